@@ -0,0 +1,196 @@
+#ifndef TODO_ALLOC_TRACKER_H
+#define TODO_ALLOC_TRACKER_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include "output_buffer.h"
+
+namespace todo
+{
+
+    // Counts heap allocations per labelled scope. Labels are string literals
+    // set with TODO_ALLOC_SCOPE; the innermost scope on a thread gets the
+    // allocations made inside it, and anything outside every scope is "other".
+    // Counting only happens when the program is built with -DTODO_TRACK_ALLOCS,
+    // which replaces the global operator new; this header must then be included
+    // by exactly one translation unit, as every program here is a single one
+    class AllocTracker
+    {
+    public:
+        static constexpr int maxLabels = 64;
+
+        struct Totals
+        {
+            std::uint64_t allocations = 0;
+            std::uint64_t bytes = 0;
+        };
+
+    private:
+        struct Slot
+        {
+            std::atomic<const char *> label{nullptr};
+            std::atomic<std::uint64_t> allocations{0};
+            std::atomic<std::uint64_t> bytes{0};
+        };
+
+        static Slot *slots()
+        {
+            // Plain static storage: operator new may run before any constructor
+            static Slot table[maxLabels];
+            return table;
+        }
+
+        static int &currentSlot()
+        {
+            thread_local int slot = 0;
+            return slot;
+        }
+
+    public:
+        // Slot of a label, claiming a free one the first time; the last slot
+        // takes every label once the table is full
+        static int slotFor(const char *label)
+        {
+            Slot *table = slots();
+            for (int i = 1; i < maxLabels - 1; ++i)
+            {
+                const char *seen = table[i].label.load(std::memory_order_acquire);
+                if (seen == label)
+                    return i;
+                if (seen == nullptr)
+                {
+                    const char *expected = nullptr;
+                    if (table[i].label.compare_exchange_strong(expected, label) || expected == label)
+                        return i;
+                }
+            }
+            return maxLabels - 1;
+        }
+
+        static void record(std::size_t size)
+        {
+            Slot &slot = slots()[currentSlot()];
+            slot.allocations.fetch_add(1, std::memory_order_relaxed);
+            slot.bytes.fetch_add(size, std::memory_order_relaxed);
+        }
+
+        // Make slot current on this thread and return the previous one
+        static int enter(int slot)
+        {
+            int previous = currentSlot();
+            currentSlot() = slot;
+            return previous;
+        }
+
+        static void leave(int previous) { currentSlot() = previous; }
+
+        // Everything allocated so far, over all labels and threads
+        static Totals totals()
+        {
+            Totals t;
+            for (int i = 0; i < maxLabels; ++i)
+            {
+                t.allocations += slots()[i].allocations.load(std::memory_order_relaxed);
+                t.bytes += slots()[i].bytes.load(std::memory_order_relaxed);
+            }
+            return t;
+        }
+
+        // Table of allocations and bytes per label
+        static void report(OutputBuffer &out)
+        {
+            out.append(std::string("allocation site         allocs         bytes\n"));
+            for (int i = 0; i < maxLabels; ++i)
+            {
+                const Slot &s = slots()[i];
+                std::uint64_t n = s.allocations.load(std::memory_order_relaxed);
+                if (n == 0)
+                    continue;
+                const char *label = i == 0 ? "other" : s.label.load(std::memory_order_relaxed);
+                char line[96];
+                std::snprintf(line, sizeof(line), "%-20s%10llu%14llu\n", label ? label : "(overflow)",
+                              static_cast<unsigned long long>(n),
+                              static_cast<unsigned long long>(s.bytes.load(std::memory_order_relaxed)));
+                out.append(std::string(line));
+            }
+        }
+    };
+
+#ifdef TODO_TRACK_ALLOCS
+    constexpr bool allocTrackingCompiledIn = true;
+
+    // Attributes the allocations of a scope to a label
+    class AllocScope
+    {
+    private:
+        int previous;
+
+    public:
+        explicit AllocScope(const char *label) : previous(AllocTracker::enter(AllocTracker::slotFor(label))) {}
+        ~AllocScope() { AllocTracker::leave(previous); }
+
+        AllocScope(const AllocScope &) = delete;
+        AllocScope &operator=(const AllocScope &) = delete;
+    };
+
+#define TODO_ALLOC_CONCAT2(a, b) a##b
+#define TODO_ALLOC_CONCAT(a, b) TODO_ALLOC_CONCAT2(a, b)
+#define TODO_ALLOC_SCOPE(label) ::todo::AllocScope TODO_ALLOC_CONCAT(todoAllocScope, __LINE__)(label)
+#else
+    constexpr bool allocTrackingCompiledIn = false;
+
+#define TODO_ALLOC_SCOPE(label) \
+    do                          \
+    {                           \
+    } while (0)
+#endif
+
+} // namespace todo
+
+#ifdef TODO_TRACK_ALLOCS
+// Replacement allocation functions; the array, nothrow and sized forms all
+// come through here. Over-aligned allocations keep the library's versions
+inline void *todoTrackedAlloc(std::size_t size)
+{
+    todo::AllocTracker::record(size);
+    return std::malloc(size ? size : 1);
+}
+
+// Kept out of line so the compiler does not see new paired with free
+#if defined(__GNUC__) || defined(__clang__)
+__attribute__((noinline))
+#endif
+inline void todoTrackedFree(void *p)
+{
+    std::free(p);
+}
+
+void *operator new(std::size_t size)
+{
+    if (void *p = todoTrackedAlloc(size))
+        return p;
+    throw std::bad_alloc();
+}
+
+void *operator new[](std::size_t size)
+{
+    if (void *p = todoTrackedAlloc(size))
+        return p;
+    throw std::bad_alloc();
+}
+
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept { return todoTrackedAlloc(size); }
+void *operator new[](std::size_t size, const std::nothrow_t &) noexcept { return todoTrackedAlloc(size); }
+void operator delete(void *p) noexcept { todoTrackedFree(p); }
+void operator delete[](void *p) noexcept { todoTrackedFree(p); }
+void operator delete(void *p, std::size_t) noexcept { todoTrackedFree(p); }
+void operator delete[](void *p, std::size_t) noexcept { todoTrackedFree(p); }
+void operator delete(void *p, const std::nothrow_t &) noexcept { todoTrackedFree(p); }
+void operator delete[](void *p, const std::nothrow_t &) noexcept { todoTrackedFree(p); }
+#endif
+
+#endif
@@ -0,0 +1,235 @@
+#ifndef TODO_BATCH_H
+#define TODO_BATCH_H
+
+#include <iostream>
+#include <string>
+#include <cstddef>
+#include <vector>
+#include "task_manager.h"
+#include "output_buffer.h"
+
+namespace todo
+{
+
+    // Totals of one batch run
+    struct BatchResult
+    {
+        std::size_t commands = 0;
+        std::size_t failures = 0;
+    };
+
+    // Runs script commands against a task manager, one per line:
+    //
+    //   add <title>;<deadline>[;<category>[;<repeat>]]
+    //   complete <title>
+    //   delete <title>
+    //   search <keyword>
+    //   view [sorted]
+    //   agenda [<from> [<to>]]
+    //   depend <task>;<prerequisite>
+    //   undepend <task>;<prerequisite>
+    //   ready
+    //   plan
+    //   undo
+    //   redo
+    //   stats
+    //
+    // Empty lines and lines starting with '#' are skipped. Every command gets a
+    // result line prefixed with its line number; matching rows of a search are
+    // printed just before its result line
+    class BatchRunner
+    {
+    private:
+        TaskManager &manager;
+        OutputBuffer &out;
+        BatchResult result;
+        std::size_t lineNumber;
+
+        void report(const std::string &message)
+        {
+            out.append(std::to_string(lineNumber) + ": " + message + "\n");
+        }
+
+        void fail(const std::string &message)
+        {
+            ++result.failures;
+            report("error: " + message);
+        }
+
+        void add(const std::string &args)
+        {
+            std::size_t first = args.find(';');
+            if (first == std::string::npos || first == 0)
+            {
+                fail("add needs <title>;<deadline>[;<category>[;<repeat>]]");
+                return;
+            }
+            std::size_t second = args.find(';', first + 1);
+            std::size_t third = second == std::string::npos ? second : args.find(';', second + 1);
+            std::string title = args.substr(0, first);
+            std::string deadline = args.substr(first + 1, second == std::string::npos ? std::string::npos : second - first - 1);
+            std::string category = second == std::string::npos ? std::string() : args.substr(second + 1, third == std::string::npos ? std::string::npos : third - second - 1);
+            std::string repeat = third == std::string::npos ? std::string() : args.substr(third + 1);
+            if (deadline.empty())
+            {
+                fail("add needs a deadline for \"" + title + "\"");
+                return;
+            }
+            Date date;
+            if (!parseDate(deadline, date))
+            {
+                fail("invalid deadline \"" + deadline + "\" for \"" + title + "\"");
+                return;
+            }
+            deadline = formatDeadline(date);
+
+            RecurrenceRule rule;
+            if (!repeat.empty())
+            {
+                if (!rule.parse(repeat, deadline))
+                {
+                    fail("cannot repeat \"" + repeat + "\" from \"" + deadline + "\"");
+                    return;
+                }
+                manager.addTask(new RecurringTask(title, deadline, category, rule));
+            }
+            else if (category.empty())
+                manager.addTask(new Task(title, deadline));
+            else
+                manager.addTask(new CategorizedTask(title, deadline, category));
+            report("added \"" + title + "\"");
+        }
+
+        void depend(const std::string &command, const std::string &args)
+        {
+            std::size_t split = args.find(';');
+            if (split == std::string::npos || split == 0 || split + 1 == args.size())
+            {
+                fail(command + " needs <task>;<prerequisite>");
+                return;
+            }
+            std::string task = args.substr(0, split);
+            std::string prerequisite = args.substr(split + 1);
+            std::vector<std::string> cycle;
+            if (command == "undepend")
+            {
+                if (manager.removeDependency(task, prerequisite))
+                    report("\"" + task + "\" no longer waits for \"" + prerequisite + "\"");
+                else
+                    fail("\"" + task + "\" does not wait for \"" + prerequisite + "\"");
+            }
+            else if (manager.addDependency(task, prerequisite, &cycle))
+                report("\"" + task + "\" waits for \"" + prerequisite + "\"");
+            else if (cycle.size() == 1)
+                fail("a task cannot wait for itself");
+            else if (cycle.empty())
+                fail("\"" + task + "\" and \"" + prerequisite + "\" must both be active tasks");
+            else
+            {
+                std::string chain;
+                for (const auto &title : cycle)
+                    chain += (chain.empty() ? "\"" : " -> \"") + title + "\"";
+                fail("cycle: \"" + prerequisite + "\" already waits for \"" + task + "\" (" + chain + ")");
+            }
+        }
+
+    public:
+        BatchRunner(TaskManager &m, OutputBuffer &o) : manager(m), out(o), lineNumber(0) {}
+
+        // Run a single command line
+        void execute(const std::string &line)
+        {
+            ++lineNumber;
+            if (line.empty() || line[0] == '#')
+                return;
+            ++result.commands;
+
+            std::size_t space = line.find(' ');
+            std::string command = line.substr(0, space);
+            std::string args = space == std::string::npos ? std::string() : line.substr(space + 1);
+
+            if (command == "add")
+                add(args);
+            else if (command == "complete")
+            {
+                if (manager.markCompleted(args))
+                    report("completed \"" + args + "\"");
+                else
+                    fail("no task titled \"" + args + "\"");
+            }
+            else if (command == "delete")
+            {
+                if (manager.deleteTask(args))
+                    report("deleted \"" + args + "\"");
+                else
+                    fail("no task titled \"" + args + "\"");
+            }
+            else if (command == "search")
+            {
+                std::size_t matches = manager.searchTask(args, out);
+                report(std::to_string(matches) + " matches for \"" + args + "\"");
+            }
+            else if (command == "view")
+            {
+                if (!args.empty() && args != "sorted")
+                {
+                    fail("view takes no argument or \"sorted\"");
+                    return;
+                }
+                manager.viewTasks(args == "sorted", out);
+                report(args.empty() ? "viewed" : "viewed sorted");
+            }
+            else if (command == "agenda")
+            {
+                std::size_t space = args.find(' ');
+                Date from, to;
+                if (!parseAgendaWindow(args.substr(0, space), space == std::string::npos ? std::string() : args.substr(space + 1), from, to))
+                {
+                    fail("agenda takes [<from> [<to>]] dates, from first");
+                    return;
+                }
+                std::size_t rows = manager.agenda(from, to, out);
+                report(std::to_string(rows) + " due " + formatDeadline(from) + " to " + formatDeadline(to));
+            }
+            else if (command == "depend" || command == "undepend")
+                depend(command, args);
+            else if (command == "ready")
+                report(std::to_string(manager.viewReady(out)) + " ready");
+            else if (command == "plan")
+                report(std::to_string(manager.viewPlan(out)) + " in dependency order");
+            else if (command == "undo" || command == "redo")
+            {
+                std::string what;
+                if (command == "undo" ? manager.undo(&what) : manager.redo(&what))
+                    report((command == "undo" ? "undid " : "redid ") + what);
+                else
+                    fail("nothing to " + command);
+            }
+            else if (command == "stats")
+            {
+                manager.operationStats().report(out);
+                if (allocTrackingCompiledIn)
+                    AllocTracker::report(out);
+                report("stats");
+            }
+            else
+                fail("unknown command \"" + command + "\"");
+        }
+
+        // Run every line of a script
+        BatchResult run(std::istream &in)
+        {
+            std::string line;
+            while (getline(in, line))
+            {
+                if (!line.empty() && line.back() == '\r')
+                    line.pop_back();
+                execute(line);
+            }
+            return result;
+        }
+    };
+
+} // namespace todo
+
+#endif
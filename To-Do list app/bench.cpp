@@ -0,0 +1,405 @@
+// Benchmark suite for TaskManager.
+//
+// Macrobenchmarks time whole operations over a store of N tasks (load, save,
+// sorted view, search, category filter); microbenchmarks time single add,
+// mark-completed and delete calls against a store of N tasks, reminder timer
+// schedule, reschedule and cancel calls with N timers pending, and dependency
+// links added to a graph of N tasks and N edges. Every case runs
+// on the same generated data set (see dataset.h), is warmed up once and then
+// repeated. Built with -DTODO_TRACK_ALLOCS (make bench_allocs) it also counts
+// heap allocations and bytes per operation. Where Linux perf_event_open works,
+// cycles, instructions, cache misses and branch misses per operation are
+// recorded as well.
+//
+// Usage: bench [--sizes 1000,100000,10000000] [--repetitions 5] [--filter name]
+//              [--json results.json] [--dir scratch-directory] [--seed n]
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+#include <functional>
+#include <cmath>
+#include <cstdio>
+#include <cstdint>
+#include <cstdlib>
+#include "task_manager.h"
+#include "output_buffer.h"
+#include "dataset.h"
+#include "alloc_tracker.h"
+#include "perf_counters.h"
+#include "timer_wheel.h"
+#include "dependency_graph.h"
+
+namespace
+{
+    using namespace todo;
+    using Clock = std::chrono::steady_clock;
+
+#ifdef _WIN32
+    const char *nullDevice = "NUL";
+#else
+    const char *nullDevice = "/dev/null";
+#endif
+
+    struct Result
+    {
+        std::string name;
+        std::size_t size;
+        std::size_t opsPerRun;
+        std::vector<double> samples; // Nanoseconds per run
+        AllocTracker::Totals allocations; // Per run, when built with TODO_TRACK_ALLOCS
+        PerfSample events;                // Summed over the timed runs, when counters work
+
+        double median() const
+        {
+            std::vector<double> s = samples;
+            std::sort(s.begin(), s.end());
+            return s.size() % 2 ? s[s.size() / 2] : (s[s.size() / 2 - 1] + s[s.size() / 2]) / 2;
+        }
+        double mean() const
+        {
+            double sum = 0;
+            for (double v : samples)
+                sum += v;
+            return sum / samples.size();
+        }
+        double stddev() const
+        {
+            double m = mean(), sum = 0;
+            for (double v : samples)
+                sum += (v - m) * (v - m);
+            return samples.size() > 1 ? std::sqrt(sum / (samples.size() - 1)) : 0;
+        }
+        double min() const { return *std::min_element(samples.begin(), samples.end()); }
+        double max() const { return *std::max_element(samples.begin(), samples.end()); }
+    };
+
+    struct Options
+    {
+        std::vector<std::size_t> sizes = {1000, 100000};
+        int repetitions = 5;
+        std::string filter;
+        std::string jsonFile;
+        std::string dir = ".";
+        std::uint64_t seed = 1;
+    };
+
+    class Suite
+    {
+    private:
+        const Options &options;
+        std::vector<Result> results;
+        PerfCounters counters;
+
+    public:
+        explicit Suite(const Options &o) : options(o)
+        {
+            if (!counters.available())
+                std::cerr << "Hardware counters unavailable: " << counters.why() << "\n";
+        }
+
+        bool hasCounters() const { return counters.available(); }
+
+        const std::vector<Result> &all() const { return results; }
+
+        // Time `run` once for warm-up and then `repetitions` times. `setup` runs
+        // before every timed run and is not measured
+        void measure(const std::string &name, std::size_t size, std::size_t opsPerRun,
+                     const std::function<void()> &setup, const std::function<void()> &run)
+        {
+            if (!options.filter.empty() && name.find(options.filter) == std::string::npos)
+                return;
+            Result result{name, size, opsPerRun, {}, {}, {}};
+            for (int r = -1; r < options.repetitions; ++r)
+            {
+                setup();
+                AllocTracker::Totals before = AllocTracker::totals();
+                PerfSample eventsBefore = counters.read();
+                auto start = Clock::now();
+                run();
+                std::chrono::duration<double, std::nano> elapsed = Clock::now() - start;
+                PerfSample eventsAfter = counters.read();
+                AllocTracker::Totals after = AllocTracker::totals();
+                if (r >= 0)
+                {
+                    result.samples.push_back(elapsed.count());
+                    result.events.add(PerfCounters::difference(eventsBefore, eventsAfter));
+                }
+                // Every run allocates the same; keep the last one
+                result.allocations.allocations = after.allocations - before.allocations;
+                result.allocations.bytes = after.bytes - before.bytes;
+            }
+            std::cerr << std::left << std::setw(20) << name << std::right << std::setw(10) << size
+                      << std::fixed << std::setprecision(1)
+                      << std::setw(16) << result.median() / opsPerRun << " ns/op"
+                      << std::setw(10) << (result.median() > 0 ? 100.0 * result.stddev() / result.mean() : 0) << " %sd";
+            if (allocTrackingCompiledIn)
+                std::cerr << std::setw(12) << static_cast<double>(result.allocations.allocations) / opsPerRun << " allocs/op";
+            if (result.events.has(PerfSample::Cycles) && result.events.has(PerfSample::Instructions) &&
+                result.events.counts[PerfSample::Cycles] > 0)
+                std::cerr << std::setw(8) << std::setprecision(2)
+                          << static_cast<double>(result.events.counts[PerfSample::Instructions]) / result.events.counts[PerfSample::Cycles]
+                          << " IPC";
+            std::cerr << "\n";
+            results.push_back(result);
+        }
+
+        void run(std::size_t n)
+        {
+            std::string file = options.dir + "/bench_tasks_" + std::to_string(n) + ".txt";
+            std::string saved = options.dir + "/bench_saved_" + std::to_string(n) + ".txt";
+            DatasetSpec spec;
+            spec.tasks = n;
+            spec.seed = options.seed;
+            DatasetGenerator(spec).write(file);
+
+            // Macrobenchmarks
+            TaskManager *manager = nullptr;
+            auto fresh = [&]()
+            {
+                delete manager;
+                manager = new TaskManager();
+                manager->loadFromFile(file);
+            };
+
+            measure("loadFromFile", n, 1, [&]()
+                    { delete manager; manager = new TaskManager(); },
+                    [&]()
+                    { manager->loadFromFile(file); });
+
+            fresh();
+            measure("saveToFile", n, 1, []() {}, [&]()
+                    { manager->saveToFile(saved); });
+
+            measure("viewTasks sorted", n, 1, []() {}, [&]()
+                    {
+                        OutputBuffer out(nullDevice);
+                        manager->viewTasks(true, out);
+                    });
+
+            measure("searchTask", n, 1, []() {}, [&]()
+                    {
+                        OutputBuffer out(nullDevice);
+                        manager->searchTask("milk", out);
+                    });
+
+            measure("filterByCategory", n, 1, []() {}, [&]()
+                    {
+                        OutputBuffer out(nullDevice);
+                        manager->filterByCategory("Work", out);
+                    });
+
+            // Microbenchmarks on a loaded store; mutations get a fresh store each run.
+            // Targets are distinct active titles picked at random from the file
+            const std::size_t ops = std::min<std::size_t>(1000, n / 10 + 1);
+            std::vector<std::string> targets;
+            {
+                std::ifstream in(file);
+                std::string line;
+                std::vector<std::string> active;
+                while (getline(in, line))
+                    if (line.compare(0, 5, "DONE:") != 0)
+                        active.push_back(line.substr(0, line.find(';')));
+                SplitMix64 pick(options.seed + 1);
+                for (std::size_t i = 0; i < ops; ++i)
+                    targets.push_back(active[pick.below(active.size())]);
+                std::sort(targets.begin(), targets.end());
+                targets.erase(std::unique(targets.begin(), targets.end()), targets.end());
+            }
+
+            measure("addTask", n, ops, fresh, [&]()
+                    {
+                        for (std::size_t i = 0; i < ops; ++i)
+                            manager->addTask(new CategorizedTask("New task " + std::to_string(i), "01.01.2026", "Work"));
+                    });
+
+            measure("markCompleted", n, targets.size(), fresh, [&]()
+                    {
+                        for (const auto &t : targets)
+                            manager->markCompleted(t);
+                    });
+
+            measure("deleteTask", n, targets.size(), fresh, [&]()
+                    {
+                        for (const auto &t : targets)
+                            manager->deleteTask(t);
+                    });
+
+            delete manager;
+            manager = nullptr;
+
+            // Reminder timers spread over a year, with n of them pending
+            {
+                using Wheel = TimerWheel<std::uint32_t>;
+                const std::int64_t start = 1767225600;
+                SplitMix64 pick(options.seed + 2);
+                std::vector<std::int64_t> times(n + ops);
+                for (auto &t : times)
+                    t = start + 1 + static_cast<std::int64_t>(pick.below(365 * 86400));
+                Wheel *wheel = nullptr;
+                std::vector<Wheel::Handle> handles;
+                auto filled = [&]()
+                {
+                    delete wheel;
+                    wheel = new Wheel(start);
+                    handles.clear();
+                    for (std::size_t i = 0; i < n; ++i)
+                        handles.push_back(wheel->schedule(times[i], static_cast<std::uint32_t>(i)));
+                };
+                const std::size_t stride = n / ops + 1;
+
+                measure("timer schedule", n, ops, filled, [&]()
+                        {
+                            for (std::size_t i = 0; i < ops; ++i)
+                                wheel->schedule(times[n + i], static_cast<std::uint32_t>(i));
+                        });
+
+                measure("timer reschedule", n, ops, filled, [&]()
+                        {
+                            for (std::size_t i = 0; i < ops; ++i)
+                                wheel->reschedule(handles[i * stride % n], times[n + i]);
+                        });
+
+                measure("timer cancel", n, ops, filled, [&]()
+                        {
+                            for (std::size_t i = 0; i < ops; ++i)
+                                wheel->cancel(handles[i * stride % n]);
+                        });
+                delete wheel;
+            }
+
+            // Dependency links between random tasks of a graph that already
+            // has one edge per task. About half of them go against the order
+            // and need a repair or turn out to close a cycle
+            {
+                using Node = DependencyGraph::Node;
+                SplitMix64 pick(options.seed + 3);
+                std::vector<std::pair<Node, Node>> existing, added;
+                for (std::size_t i = 0; i < n; ++i)
+                {
+                    Node a = static_cast<Node>(pick.below(n)), b = static_cast<Node>(pick.below(n));
+                    existing.push_back(std::make_pair(std::min(a, b), std::max(a, b)));
+                }
+                for (std::size_t i = 0; i < ops; ++i)
+                    added.push_back(std::make_pair(static_cast<Node>(pick.below(n)), static_cast<Node>(pick.below(n))));
+                DependencyGraph *graph = nullptr;
+                auto linked = [&]()
+                {
+                    delete graph;
+                    graph = new DependencyGraph();
+                    for (std::size_t i = 0; i < n; ++i)
+                        graph->node("Task " + std::to_string(i));
+                    graph->linkAll(existing);
+                };
+
+                measure("dependency link", n, ops, linked, [&]()
+                        {
+                            for (const auto &e : added)
+                                graph->link(e.first, e.second);
+                        });
+                delete graph;
+            }
+
+            std::remove(file.c_str());
+            std::remove(saved.c_str());
+        }
+    };
+
+    void writeJson(const std::string &filename, const Options &options, const std::vector<Result> &results)
+    {
+        std::ofstream out(filename);
+        out << "{\n  \"suite\": \"todo-bench\",\n  \"repetitions\": " << options.repetitions
+            << ",\n  \"seed\": " << options.seed << ",\n  \"allocation_tracking\": "
+            << (allocTrackingCompiledIn ? "true" : "false") << ",\n";
+        out << "  \"compiler\": \"" <<
+#if defined(__clang__)
+            "clang " __clang_version__
+#elif defined(__GNUC__)
+            "gcc " __VERSION__
+#else
+            "unknown"
+#endif
+            << "\",\n  \"results\": [\n";
+        out << std::fixed << std::setprecision(1);
+        for (std::size_t i = 0; i < results.size(); ++i)
+        {
+            const Result &r = results[i];
+            out << "    {\"name\": \"" << r.name << "\", \"size\": " << r.size << ", \"ops_per_run\": " << r.opsPerRun
+                << ", \"median_ns\": " << r.median() << ", \"mean_ns\": " << r.mean()
+                << ", \"stddev_ns\": " << r.stddev() << ", \"min_ns\": " << r.min() << ", \"max_ns\": " << r.max()
+                << ", \"ns_per_op\": " << r.median() / r.opsPerRun;
+            // Enough digits that one more allocation per run shows, for bench_compare --allocs
+            if (allocTrackingCompiledIn)
+                out << std::setprecision(4)
+                    << ", \"allocs_per_op\": " << static_cast<double>(r.allocations.allocations) / r.opsPerRun
+                    << ", \"bytes_per_op\": " << static_cast<double>(r.allocations.bytes) / r.opsPerRun
+                    << std::setprecision(1);
+            // Hardware events per operation, averaged over the timed runs
+            for (int e = 0; e < PerfSample::EventCount; ++e)
+                if (r.events.has(static_cast<PerfSample::Event>(e)))
+                    out << ", \"" << PerfSample::name(static_cast<PerfSample::Event>(e)) << "_per_op\": "
+                        << static_cast<double>(r.events.counts[e]) / (static_cast<double>(r.opsPerRun) * r.samples.size());
+            out << ", \"samples_ns\": [";
+            for (std::size_t s = 0; s < r.samples.size(); ++s)
+                out << (s ? ", " : "") << r.samples[s];
+            out << "]}" << (i + 1 < results.size() ? "," : "") << "\n";
+        }
+        out << "  ]\n}\n";
+    }
+
+    bool parseSizes(const std::string &list, std::vector<std::size_t> &sizes)
+    {
+        sizes.clear();
+        std::size_t start = 0;
+        while (start < list.size())
+        {
+            std::size_t comma = list.find(',', start);
+            std::string item = list.substr(start, comma == std::string::npos ? std::string::npos : comma - start);
+            unsigned long long value = std::strtoull(item.c_str(), nullptr, 10);
+            if (value == 0)
+                return false;
+            sizes.push_back(static_cast<std::size_t>(value));
+            start = comma == std::string::npos ? list.size() : comma + 1;
+        }
+        return !sizes.empty();
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    Options options;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--sizes" && hasValue && parseSizes(argv[i + 1], options.sizes))
+            ++i;
+        else if (arg == "--repetitions" && hasValue && std::atoi(argv[i + 1]) > 0)
+            options.repetitions = std::atoi(argv[++i]);
+        else if (arg == "--filter" && hasValue)
+            options.filter = argv[++i];
+        else if (arg == "--json" && hasValue)
+            options.jsonFile = argv[++i];
+        else if (arg == "--dir" && hasValue)
+            options.dir = argv[++i];
+        else if (arg == "--seed" && hasValue)
+            options.seed = std::strtoull(argv[++i], nullptr, 10);
+        else
+        {
+            std::cerr << "usage: bench [--sizes 1000,100000,10000000] [--repetitions n] [--filter name]\n"
+                         "             [--json results.json] [--dir scratch-directory] [--seed n]\n";
+            return 2;
+        }
+    }
+
+    Suite suite(options);
+    for (std::size_t n : options.sizes)
+        suite.run(n);
+    if (!options.jsonFile.empty())
+        writeJson(options.jsonFile, options, suite.all());
+    return 0;
+}
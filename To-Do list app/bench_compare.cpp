@@ -0,0 +1,374 @@
+// Compares two result files written by `bench --json` and fails when a case
+// got slower than the noise allows.
+//
+// A case regresses when its median time per run grew by more than the larger
+// of --threshold (relative, 0.10 by default) and --noise times the larger
+// relative spread of the two runs. The spread is the median absolute deviation
+// of the samples scaled to match a standard deviation, so a single slow
+// repetition does not widen the limit. When both files carry allocation
+// counts, any growth in allocations per operation is a regression too.
+//
+// With --allocs only the allocation counts of `bench_allocs` output are
+// compared. They do not depend on the machine, so the baseline can be
+// committed; a case without counts is bad input.
+//
+// Usage: bench_compare baseline.json current.json [--threshold 0.10] [--noise 3] [--allocs]
+// Exit status: 0 no regression, 1 regression, 2 bad input
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+
+namespace
+{
+    // Just enough JSON for bench output: objects, arrays, strings, numbers, literals
+    struct JsonValue
+    {
+        enum Kind
+        {
+            Null,
+            Bool,
+            Number,
+            String,
+            Array,
+            Object
+        };
+
+        Kind kind = Null;
+        double number = 0;
+        bool boolean = false;
+        std::string text;
+        std::vector<JsonValue> items;
+        std::map<std::string, JsonValue> members;
+
+        const JsonValue *get(const std::string &key) const
+        {
+            auto it = members.find(key);
+            return it == members.end() ? nullptr : &it->second;
+        }
+
+        double numberOr(const std::string &key, double fallback) const
+        {
+            const JsonValue *v = get(key);
+            return v && v->kind == Number ? v->number : fallback;
+        }
+    };
+
+    class JsonParser
+    {
+    private:
+        const std::string &s;
+        std::size_t pos = 0;
+
+        void skipSpace()
+        {
+            while (pos < s.size() && (s[pos] == ' ' || s[pos] == '\n' || s[pos] == '\r' || s[pos] == '\t'))
+                ++pos;
+        }
+
+        bool expect(char c)
+        {
+            skipSpace();
+            if (pos < s.size() && s[pos] == c)
+            {
+                ++pos;
+                return true;
+            }
+            return false;
+        }
+
+        bool parseString(std::string &out)
+        {
+            if (!expect('"'))
+                return false;
+            while (pos < s.size() && s[pos] != '"')
+            {
+                char c = s[pos++];
+                if (c == '\\' && pos < s.size())
+                {
+                    char e = s[pos++];
+                    switch (e)
+                    {
+                    case 'n': c = '\n'; break;
+                    case 't': c = '\t'; break;
+                    case 'r': c = '\r'; break;
+                    case 'b': c = '\b'; break;
+                    case 'f': c = '\f'; break;
+                    case 'u':
+                        pos += 4; // Names in bench output are ASCII
+                        c = '?';
+                        break;
+                    default: c = e;
+                    }
+                }
+                out += c;
+            }
+            return expect('"');
+        }
+
+    public:
+        explicit JsonParser(const std::string &text) : s(text) {}
+
+        bool parse(JsonValue &v)
+        {
+            skipSpace();
+            if (pos >= s.size())
+                return false;
+            char c = s[pos];
+            if (c == '{')
+            {
+                ++pos;
+                v.kind = JsonValue::Object;
+                if (expect('}'))
+                    return true;
+                do
+                {
+                    std::string key;
+                    skipSpace();
+                    if (!parseString(key) || !expect(':') || !parse(v.members[key]))
+                        return false;
+                } while (expect(','));
+                return expect('}');
+            }
+            if (c == '[')
+            {
+                ++pos;
+                v.kind = JsonValue::Array;
+                if (expect(']'))
+                    return true;
+                do
+                {
+                    v.items.emplace_back();
+                    if (!parse(v.items.back()))
+                        return false;
+                } while (expect(','));
+                return expect(']');
+            }
+            if (c == '"')
+            {
+                v.kind = JsonValue::String;
+                return parseString(v.text);
+            }
+            if (s.compare(pos, 4, "true") == 0 || s.compare(pos, 5, "false") == 0)
+            {
+                v.kind = JsonValue::Bool;
+                v.boolean = s[pos] == 't';
+                pos += v.boolean ? 4 : 5;
+                return true;
+            }
+            if (s.compare(pos, 4, "null") == 0)
+            {
+                pos += 4;
+                return true;
+            }
+            char *end;
+            v.number = std::strtod(s.c_str() + pos, &end);
+            if (end == s.c_str() + pos)
+                return false;
+            v.kind = JsonValue::Number;
+            pos = static_cast<std::size_t>(end - s.c_str());
+            return true;
+        }
+    };
+
+    struct Case
+    {
+        double median = 0;
+        double spread = 0; // Robust standard deviation relative to the median
+        double opsPerRun = 1;
+        double allocsPerOp = -1; // -1 when the run did not count allocations
+    };
+
+    double median(std::vector<double> v)
+    {
+        if (v.empty())
+            return 0;
+        std::sort(v.begin(), v.end());
+        return v.size() % 2 ? v[v.size() / 2] : (v[v.size() / 2 - 1] + v[v.size() / 2]) / 2;
+    }
+
+    // 1.4826 * MAD / median from the samples, or stddev / mean without them
+    double relativeSpread(const JsonValue &result, double med)
+    {
+        const JsonValue *samples = result.get("samples_ns");
+        if (!samples || samples->kind != JsonValue::Array || samples->items.size() < 2 || med <= 0)
+        {
+            double mean = result.numberOr("mean_ns", 0);
+            return mean > 0 ? result.numberOr("stddev_ns", 0) / mean : 0;
+        }
+        std::vector<double> deviations;
+        for (const JsonValue &v : samples->items)
+            deviations.push_back(v.number > med ? v.number - med : med - v.number);
+        return 1.4826 * median(deviations) / med;
+    }
+
+    using Cases = std::map<std::pair<std::string, long long>, Case>;
+
+    bool load(const std::string &filename, Cases &cases)
+    {
+        std::ifstream in(filename, std::ios::binary);
+        if (!in)
+        {
+            std::cerr << "Could not open " << filename << "\n";
+            return false;
+        }
+        std::stringstream buffer;
+        buffer << in.rdbuf();
+        std::string text = buffer.str();
+        JsonValue root;
+        const JsonValue *results = nullptr;
+        if (!JsonParser(text).parse(root) || !(results = root.get("results")) || results->kind != JsonValue::Array)
+        {
+            std::cerr << filename << " is not bench JSON output\n";
+            return false;
+        }
+        for (const JsonValue &r : results->items)
+        {
+            const JsonValue *name = r.get("name");
+            if (!name || name->kind != JsonValue::String)
+                continue;
+            Case c;
+            c.median = r.numberOr("median_ns", 0);
+            c.spread = relativeSpread(r, c.median);
+            c.opsPerRun = r.numberOr("ops_per_run", 1);
+            c.allocsPerOp = r.numberOr("allocs_per_op", -1);
+            cases[std::make_pair(name->text, static_cast<long long>(r.numberOr("size", 0)))] = c;
+        }
+        return true;
+    }
+
+    std::string formatTime(double ns)
+    {
+        char text[32];
+        if (ns < 1e3)
+            std::snprintf(text, sizeof(text), "%.0f ns", ns);
+        else if (ns < 1e6)
+            std::snprintf(text, sizeof(text), "%.2f us", ns / 1e3);
+        else if (ns < 1e9)
+            std::snprintf(text, sizeof(text), "%.2f ms", ns / 1e6);
+        else
+            std::snprintf(text, sizeof(text), "%.2f s", ns / 1e9);
+        return text;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    std::vector<std::string> files;
+    double threshold = 0.10;
+    double noise = 3.0;
+    bool allocsOnly = false;
+    bool badOption = false;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "--threshold" && i + 1 < argc)
+            threshold = std::atof(argv[++i]);
+        else if (arg == "--noise" && i + 1 < argc)
+            noise = std::atof(argv[++i]);
+        else if (arg == "--allocs")
+            allocsOnly = true;
+        else if (arg.compare(0, 2, "--") != 0)
+            files.push_back(arg);
+        else
+            badOption = true;
+    }
+    if (badOption || files.size() != 2 || threshold < 0 || noise < 0)
+    {
+        std::cerr << "usage: bench_compare baseline.json current.json [--threshold 0.10] [--noise 3] [--allocs]\n";
+        return 2;
+    }
+
+    Cases baseline, current;
+    if (!load(files[0], baseline) || !load(files[1], current))
+        return 2;
+
+    int regressions = 0, improvements = 0, compared = 0;
+    for (const auto &entry : current)
+    {
+        const std::string &name = entry.first.first;
+        long long size = entry.first.second;
+        auto it = baseline.find(entry.first);
+        char label[64];
+        std::snprintf(label, sizeof(label), "%-18s %9lld", name.c_str(), size);
+        if (it == baseline.end())
+        {
+            std::cout << "  new       " << label << "  (not in baseline)\n";
+            continue;
+        }
+        const Case &before = it->second;
+        const Case &after = entry.second;
+        char line[160];
+        if (allocsOnly)
+        {
+            if (before.allocsPerOp < 0 || after.allocsPerOp < 0)
+            {
+                std::cerr << name << " " << size << " has no allocation counts; compare output of bench_allocs\n";
+                return 2;
+            }
+            ++compared;
+            const char *verdict = "  ok      ";
+            if (after.allocsPerOp > before.allocsPerOp + 1e-9)
+            {
+                verdict = "REGRESSED ";
+                ++regressions;
+            }
+            else if (after.allocsPerOp < before.allocsPerOp - 1e-9)
+            {
+                verdict = "  fewer   ";
+                ++improvements;
+            }
+            std::snprintf(line, sizeof(line), "%s %s  allocs/op %.4f -> %.4f", verdict, label, before.allocsPerOp, after.allocsPerOp);
+            std::cout << line << "\n";
+            continue;
+        }
+        if (before.median <= 0)
+            continue;
+        ++compared;
+
+        double change = after.median / before.median - 1;
+        double limit = std::max(threshold, noise * std::max(before.spread, after.spread));
+        const char *verdict = "  ok      ";
+        if (change > limit)
+        {
+            verdict = "REGRESSED ";
+            ++regressions;
+        }
+        else if (change < -limit)
+        {
+            verdict = "  faster  ";
+            ++improvements;
+        }
+        std::snprintf(line, sizeof(line), "%s %s  %10s -> %-10s  %+7.1f%%  (limit %.1f%%)", verdict, label,
+                      formatTime(before.median / before.opsPerRun).c_str(),
+                      formatTime(after.median / after.opsPerRun).c_str(), change * 100, limit * 100);
+        std::cout << line;
+
+        if (before.allocsPerOp >= 0 && after.allocsPerOp >= 0)
+        {
+            std::snprintf(line, sizeof(line), "  allocs/op %.1f -> %.1f", before.allocsPerOp, after.allocsPerOp);
+            std::cout << line;
+            if (after.allocsPerOp > before.allocsPerOp + 1e-9)
+            {
+                std::cout << "  MORE ALLOCATIONS";
+                if (change <= limit)
+                    ++regressions;
+            }
+        }
+        std::cout << "\n";
+    }
+    for (const auto &entry : baseline)
+        if (current.find(entry.first) == current.end())
+            std::cout << "  missing   " << entry.first.first << " " << entry.first.second << "  (in baseline only)\n";
+
+    std::cout << compared << " cases compared, " << regressions << " regressed, " << improvements
+              << (allocsOnly ? " allocate less\n" : " faster\n");
+    return regressions > 0 ? 1 : 0;
+}
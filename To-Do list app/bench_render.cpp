@@ -0,0 +1,130 @@
+// Row rendering benchmark: compares the iostream manipulator path that
+// rows used to take with the buffered and compile-time formatted paths.
+//
+// Build: g++ -O2 -std=c++17 bench_render.cpp -o bench_render
+// Run:   ./bench_render [rows] [repetitions] > /dev/null
+//
+// Rows go to stdout, so redirect it; timings are printed on stderr.
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <algorithm>
+#include <cstdlib>
+#include "task.h"
+
+namespace
+{
+    using namespace todo;
+    using Clock = std::chrono::steady_clock;
+
+    struct Row
+    {
+        std::string title;
+        std::string deadline;
+        std::string category;
+        bool completed;
+    };
+
+    // The row format exactly as it was written before the output buffer
+    void legacyDisplay(const Row &row)
+    {
+        std::cout << (row.completed ? "[X] " : "[ ] ")
+                  << std::left << std::setw(20) << row.title
+                  << " | Due: " << std::setw(12) << row.deadline;
+        if (!row.category.empty())
+            std::cout << " | Category: " << row.category;
+        std::cout << std::endl;
+    }
+
+    // Run one benchmark case several times and report the best and median run
+    template <class Fn>
+    void runCase(const char *name, std::size_t rows, int repetitions, Fn fn)
+    {
+        std::vector<double> seconds;
+        for (int r = 0; r < repetitions; ++r)
+        {
+            auto start = Clock::now();
+            fn();
+            std::chrono::duration<double> elapsed = Clock::now() - start;
+            seconds.push_back(elapsed.count());
+        }
+        std::sort(seconds.begin(), seconds.end());
+        double best = seconds.front();
+        double median = seconds[seconds.size() / 2];
+        std::cerr << std::left << std::setw(28) << name << std::right
+                  << std::fixed << std::setprecision(1)
+                  << std::setw(10) << best * 1e9 / rows << " ns/row (best)"
+                  << std::setw(10) << median * 1e9 / rows << " ns/row (median)\n";
+    }
+}
+
+int main(int argc, char **argv)
+{
+    std::size_t rows = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1000000;
+    int repetitions = argc > 2 ? std::atoi(argv[2]) : 5;
+    if (rows == 0 || repetitions <= 0)
+    {
+        std::cerr << "usage: bench_render [rows] [repetitions]\n";
+        return 1;
+    }
+
+    // Mix of short and over-wide titles, with and without a category
+    const char *categories[] = {"Home", "Work", "Events", ""};
+    std::vector<Row> data;
+    std::vector<TaskBase *> tasks;
+    data.reserve(rows);
+    tasks.reserve(rows);
+    for (std::size_t i = 0; i < rows; ++i)
+    {
+        Row row;
+        row.title = "Task " + std::to_string(i) + std::string(i % 23, 'x');
+        row.deadline = std::to_string(1 + i % 28) + "." + std::to_string(1 + i % 12) + ".2026";
+        row.category = categories[i % 4];
+        row.completed = (i % 5 == 0);
+        if (row.category.empty())
+            tasks.push_back(new Task(row.title, row.deadline, row.completed));
+        else
+            tasks.push_back(new CategorizedTask(row.title, row.deadline, row.category, row.completed));
+        data.push_back(row);
+    }
+
+    std::cerr << "Rendering " << rows << " rows, " << repetitions << " repetitions\n";
+
+    runCase("iostream + std::endl", rows, repetitions, [&]()
+            {
+                for (const auto &row : data)
+                    legacyDisplay(row);
+            });
+
+    runCase("OutputBuffer::appendPadded", rows, repetitions, [&]()
+            {
+                OutputBuffer out;
+                for (const auto &row : data)
+                {
+                    out.append(row.completed ? "[X] " : "[ ] ", 4);
+                    out.appendPadded(row.title, 20);
+                    out.append(" | Due: ", 8);
+                    out.appendPadded(row.deadline, 12);
+                    if (!row.category.empty())
+                    {
+                        out.append(" | Category: ", 13);
+                        out.append(row.category);
+                    }
+                    out.append('\n');
+                }
+            });
+
+    runCase("RowFormatter (render)", rows, repetitions, [&]()
+            {
+                OutputBuffer out;
+                for (const auto &t : tasks)
+                    t->render(out);
+            });
+
+    for (auto t : tasks)
+        delete t;
+    return 0;
+}
@@ -0,0 +1,236 @@
+#ifndef TODO_CSV_IMPORT_H
+#define TODO_CSV_IMPORT_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cctype>
+#include <charconv>
+#include <cstddef>
+#include "csv_reader.h"
+#include "date_utils.h"
+#include "import_result.h"
+#include "task.h"
+#include "task_manager.h"
+
+namespace todo
+{
+
+    // Which CSV columns feed which task fields. A column is named by its
+    // header text (case-insensitive) or by its 1-based position. Without a
+    // header row the default names stand for columns 1, 2 and 3
+    struct CsvImportOptions
+    {
+        char delimiter = ',';
+        bool header = true;
+        std::string titleColumn = "title";
+        std::string deadlineColumn = "deadline";
+        std::string categoryColumn = "category";   // Optional
+        std::string completedColumn = "completed"; // Optional
+
+        // Whether column names a column by position rather than by header
+        static bool isPosition(const std::string &column)
+        {
+            return !column.empty() && column.find_first_not_of("0123456789") == std::string::npos;
+        }
+
+        // The 0-based index of a column given by position; false for a
+        // position of 0 or one too large for an int
+        static bool columnPosition(const std::string &column, int &index)
+        {
+            int position = 0;
+            auto parsed = std::from_chars(column.data(), column.data() + column.size(), position);
+            if (parsed.ec != std::errc() || position < 1)
+                return false;
+            index = position - 1;
+            return true;
+        }
+
+        // Apply "field=column,..." as given on the command line; false on an
+        // unknown field or a column position that is out of range
+        bool setMapping(const std::string &mapping)
+        {
+            std::size_t start = 0;
+            while (start < mapping.size())
+            {
+                std::size_t comma = mapping.find(',', start);
+                std::string item = mapping.substr(start, comma == std::string::npos ? std::string::npos : comma - start);
+                start = comma == std::string::npos ? mapping.size() : comma + 1;
+
+                std::size_t eq = item.find('=');
+                if (eq == std::string::npos)
+                    return false;
+                std::string field = item.substr(0, eq);
+                std::string column = item.substr(eq + 1);
+                int index;
+                if (isPosition(column) && !columnPosition(column, index))
+                    return false;
+                if (field == "title")
+                    titleColumn = column;
+                else if (field == "deadline")
+                    deadlineColumn = column;
+                else if (field == "category")
+                    categoryColumn = column;
+                else if (field == "completed")
+                    completedColumn = column;
+                else
+                    return false;
+            }
+            return true;
+        }
+    };
+
+    // Streams a CSV file into a TaskManager. Rows are validated and their
+    // dates converted to DD.MM.YYYY while parsing; valid tasks are handed to the
+    // manager in large batches through addTasks()
+    class CsvImporter
+    {
+    private:
+        static constexpr std::size_t batchSize = 1 << 16;
+
+        const CsvImportOptions &options;
+        ImportResult result;
+        int titleIndex = -1;
+        int deadlineIndex = -1;
+        int categoryIndex = -1;
+        int completedIndex = -1;
+
+        static bool equalsIgnoreCase(std::string_view a, std::string_view b)
+        {
+            if (a.size() != b.size())
+                return false;
+            for (std::size_t i = 0; i < a.size(); ++i)
+                if (std::tolower(static_cast<unsigned char>(a[i])) != std::tolower(static_cast<unsigned char>(b[i])))
+                    return false;
+            return true;
+        }
+
+        // Resolve a column name or position against the header row
+        static int findColumn(const std::string &column, const std::vector<std::string_view> &header)
+        {
+            int index;
+            if (CsvImportOptions::isPosition(column))
+                return CsvImportOptions::columnPosition(column, index) ? index : -1;
+            for (std::size_t i = 0; i < header.size(); ++i)
+                if (equalsIgnoreCase(header[i], column))
+                    return static_cast<int>(i);
+            return -1;
+        }
+
+        static bool isTrue(std::string_view value)
+        {
+            static const char *yes[] = {"1", "true", "yes", "y", "x", "done", "completed"};
+            for (const char *y : yes)
+                if (equalsIgnoreCase(value, y))
+                    return true;
+            return false;
+        }
+
+        static std::string_view field(const std::vector<std::string_view> &fields, int index)
+        {
+            return index >= 0 && static_cast<std::size_t>(index) < fields.size() ? fields[index] : std::string_view();
+        }
+
+        void reject(std::size_t line, const std::string &reason)
+        {
+            result.reject("line " + std::to_string(line) + ": " + reason);
+        }
+
+        // Check one row and build its task; nullptr if the row is rejected
+        TaskBase *convert(const std::vector<std::string_view> &fields, std::size_t line, bool &completed)
+        {
+            std::string_view title = field(fields, titleIndex);
+            std::string_view deadlineText = field(fields, deadlineIndex);
+            std::string_view category = field(fields, categoryIndex);
+            completed = isTrue(field(fields, completedIndex));
+
+            // The task file uses ';' as separator and one line per task
+            if (title.empty())
+            {
+                reject(line, "missing title");
+                return nullptr;
+            }
+            if (title.find_first_of(";\r\n") != std::string_view::npos ||
+                category.find_first_of(";\r\n") != std::string_view::npos)
+            {
+                reject(line, "title or category contains ';' or a line break");
+                return nullptr;
+            }
+            Date date;
+            if (!parseDate(deadlineText, date))
+            {
+                reject(line, "invalid deadline \"" + std::string(deadlineText) + "\"");
+                return nullptr;
+            }
+
+            if (category.empty())
+                return new Task(std::string(title), formatDeadline(date), completed);
+            return new CategorizedTask(std::string(title), formatDeadline(date), std::string(category), completed);
+        }
+
+    public:
+        explicit CsvImporter(const CsvImportOptions &opts) : options(opts) {}
+
+        ImportResult run(const std::string &filename, TaskManager &manager)
+        {
+            result = ImportResult();
+            CsvReader reader(options.delimiter);
+            if (!reader.open(filename))
+                return result;
+            result.opened = true;
+            TaskManager::UndoGroup undoAsOne(manager, "import-csv"); // Chunks of one import undo together
+
+            std::vector<std::string_view> fields;
+            if (options.header)
+            {
+                if (!reader.nextRow(fields))
+                    return result;
+                titleIndex = findColumn(options.titleColumn, fields);
+                deadlineIndex = findColumn(options.deadlineColumn, fields);
+                categoryIndex = findColumn(options.categoryColumn, fields);
+                completedIndex = findColumn(options.completedColumn, fields);
+            }
+            else
+            {
+                std::vector<std::string_view> none;
+                titleIndex = findColumn(options.titleColumn == "title" ? "1" : options.titleColumn, none);
+                deadlineIndex = findColumn(options.deadlineColumn == "deadline" ? "2" : options.deadlineColumn, none);
+                categoryIndex = findColumn(options.categoryColumn == "category" ? "3" : options.categoryColumn, none);
+                completedIndex = findColumn(options.completedColumn == "completed" ? "" : options.completedColumn, none);
+            }
+            if (titleIndex < 0 || deadlineIndex < 0)
+            {
+                result.errors.push_back("no column for " + std::string(titleIndex < 0 ? "title" : "deadline"));
+                return result;
+            }
+
+            std::vector<TaskBase *> active, done;
+            active.reserve(batchSize);
+            while (reader.nextRow(fields))
+            {
+                bool completed = false;
+                TaskBase *task = convert(fields, reader.lineNumber(), completed);
+                if (!task)
+                    continue;
+                (completed ? done : active).push_back(task);
+                ++result.imported;
+                if (active.size() == batchSize)
+                {
+                    manager.addTasks(active);
+                    active.clear();
+                }
+                if (done.size() == batchSize)
+                {
+                    manager.addCompletedTasks(done);
+                    done.clear();
+                }
+            }
+            manager.addTasks(active);
+            manager.addCompletedTasks(done);
+            return result;
+        }
+    };
+
+} // namespace todo
+
+#endif
@@ -0,0 +1,186 @@
+#ifndef TODO_CSV_READER_H
+#define TODO_CSV_READER_H
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace todo
+{
+
+    // Streaming CSV reader (RFC 4180). Quoted fields may contain the delimiter,
+    // doubled quotes and line breaks; CRLF and LF line endings are both accepted.
+    // The file is read in fixed-size blocks, so memory use only depends on the
+    // longest row
+    class CsvReader
+    {
+    private:
+        enum State
+        {
+            FieldStart,
+            Unquoted,
+            Quoted,
+            QuoteInQuoted // Saw '"' inside a quoted field: end of field or an escaped quote
+        };
+
+        std::FILE *file;
+        char delimiter;
+        std::vector<char> block;
+        std::size_t pos;
+        std::size_t end;
+        bool atEof;
+        std::string row;                // Field contents of the current row, back to back
+        std::vector<std::size_t> ends;  // End offset of each field in row
+        std::size_t line;               // Physical line the next row starts on
+        std::size_t rowLine;            // Physical line the current row started on
+
+        bool refill()
+        {
+            if (atEof)
+                return false;
+            pos = 0;
+            end = std::fread(block.data(), 1, block.size(), file);
+            if (end == 0)
+                atEof = true;
+            return end > 0;
+        }
+
+    public:
+        explicit CsvReader(char fieldDelimiter = ',', std::size_t blockSize = 1 << 20)
+            : file(nullptr), delimiter(fieldDelimiter), block(blockSize), pos(0), end(0), atEof(false),
+              line(1), rowLine(1) {}
+
+        ~CsvReader() { close(); }
+
+        CsvReader(const CsvReader &) = delete;
+        CsvReader &operator=(const CsvReader &) = delete;
+
+        bool open(const std::string &filename)
+        {
+            close();
+            file = std::fopen(filename.c_str(), "rb");
+            pos = end = 0;
+            atEof = false;
+            line = rowLine = 1;
+            return file != nullptr;
+        }
+
+        void close()
+        {
+            if (file)
+                std::fclose(file);
+            file = nullptr;
+        }
+
+        // Line number where the last returned row started
+        std::size_t lineNumber() const { return rowLine; }
+
+        // Read the next row. Field views stay valid until the next call.
+        // Blank lines are skipped
+        bool nextRow(std::vector<std::string_view> &fields)
+        {
+            if (!file)
+                return false;
+
+            while (true)
+            {
+                row.clear();
+                ends.clear();
+                rowLine = line;
+                State state = FieldStart;
+                bool any = false; // Anything at all was read for this row
+
+                while (true)
+                {
+                    if (pos == end && !refill())
+                    {
+                        // Last row without a trailing newline
+                        if (!any)
+                            return false;
+                        ends.push_back(row.size());
+                        break;
+                    }
+                    any = true;
+
+                    if (state == Unquoted || state == FieldStart)
+                    {
+                        // Copy the plain part of the field in one go
+                        std::size_t start = pos;
+                        while (pos < end && block[pos] != delimiter && block[pos] != '\n' &&
+                               block[pos] != '\r' && (block[pos] != '"' || pos > start || state == Unquoted))
+                            ++pos;
+                        if (pos > start)
+                        {
+                            row.append(block.data() + start, pos - start);
+                            state = Unquoted;
+                            continue;
+                        }
+                    }
+
+                    char c = block[pos++];
+                    if (state == Quoted)
+                    {
+                        if (c == '"')
+                            state = QuoteInQuoted;
+                        else
+                        {
+                            if (c == '\n')
+                                ++line;
+                            row.push_back(c);
+                        }
+                        continue;
+                    }
+                    if (state == QuoteInQuoted)
+                    {
+                        if (c == '"')
+                        {
+                            row.push_back('"');
+                            state = Quoted;
+                            continue;
+                        }
+                        state = Unquoted; // Closing quote; c is handled below
+                    }
+
+                    if (c == delimiter)
+                    {
+                        ends.push_back(row.size());
+                        state = FieldStart;
+                    }
+                    else if (c == '\n')
+                    {
+                        ++line;
+                        ends.push_back(row.size());
+                        break;
+                    }
+                    else if (c == '\r')
+                        continue; // Part of CRLF
+                    else if (c == '"' && state == FieldStart)
+                        state = Quoted;
+                    else
+                    {
+                        row.push_back(c);
+                        state = Unquoted;
+                    }
+                }
+
+                // A line with nothing on it is not a record
+                if (ends.size() == 1 && ends[0] == 0)
+                    continue;
+
+                fields.clear();
+                std::size_t start = 0;
+                for (std::size_t e : ends)
+                {
+                    fields.push_back(std::string_view(row.data() + start, e - start));
+                    start = e;
+                }
+                return true;
+            }
+        }
+    };
+
+} // namespace todo
+
+#endif
@@ -0,0 +1,213 @@
+#ifndef TODO_DATASET_H
+#define TODO_DATASET_H
+
+#include <cstdint>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include "date_utils.h"
+#include "output_buffer.h"
+
+namespace todo
+{
+
+    // splitmix64: tiny, fast and identical on every platform, unlike the
+    // standard distributions whose output is implementation defined
+    class SplitMix64
+    {
+    private:
+        std::uint64_t state;
+
+    public:
+        explicit SplitMix64(std::uint64_t seed) : state(seed) {}
+
+        std::uint64_t next()
+        {
+            std::uint64_t z = (state += 0x9e3779b97f4a7c15ULL);
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+            return z ^ (z >> 31);
+        }
+
+        // Uniform in [0, n)
+        std::size_t below(std::size_t n) { return n ? static_cast<std::size_t>(next() % n) : 0; }
+
+        // Uniform in [0, 1) with 53 bits of precision
+        double unit() { return static_cast<double>(next() >> 11) * (1.0 / 9007199254740992.0); }
+
+        bool chance(double p) { return unit() < p; }
+    };
+
+    // What a generated task file looks like
+    struct DatasetSpec
+    {
+        enum TitleDistribution
+        {
+            Uniform, // Every length in [titleMin, titleMax] equally likely
+            Normal   // Bell curve centred between titleMin and titleMax
+        };
+
+        std::size_t tasks = 1000;         // Lines written, active and completed
+        std::uint64_t seed = 1;
+        std::size_t categories = 8;       // Distinct category names
+        double categorySkew = 1.0;        // Zipf exponent; 0 spreads tasks evenly
+        double uncategorized = 0.1;       // Share of tasks without a category
+        std::size_t titleMin = 8;
+        std::size_t titleMax = 40;
+        TitleDistribution titleDistribution = Normal;
+        Date firstDeadline = {2025, 1, 1};
+        int deadlineDays = 730;           // Deadlines fall in [firstDeadline, +days)
+        double completed = 0.2;           // Share of completed tasks
+        double duplicates = 0.0;          // Share of titles reusing an earlier title
+    };
+
+    // Writes task files in the tasks.txt format from a DatasetSpec. The same spec
+    // always produces the same bytes
+    class DatasetGenerator
+    {
+    private:
+        DatasetSpec spec;
+        SplitMix64 rng;
+        std::vector<std::string> categoryNames;
+        std::vector<double> categoryCdf; // Cumulative Zipf weights
+        std::vector<Date> dates;         // Every possible deadline, in order
+        std::vector<std::string> titles; // Titles written so far, for duplicates
+
+        static const char *word(std::size_t i)
+        {
+            static const char *words[] = {
+                "buy", "call", "fix", "clean", "book", "pay", "send", "write", "read", "plan",
+                "check", "order", "return", "renew", "email", "update", "review", "pick", "up", "the",
+                "milk", "car", "dentist", "report", "invoice", "garden", "kitchen", "flights", "taxes", "bike",
+                "slides", "notes", "mom", "team", "landlord", "insurance", "library", "books", "gift", "tickets"};
+            return words[i % (sizeof(words) / sizeof(words[0]))];
+        }
+
+        static std::string categoryName(std::size_t i)
+        {
+            static const char *names[] = {"Home", "Work", "Events", "Shopping", "Health", "Study", "Travel", "Finance"};
+            std::string name = names[i % 8];
+            if (i >= 8)
+                name += ' ' + std::to_string(i / 8 + 1);
+            return name;
+        }
+
+        std::size_t titleLength()
+        {
+            std::size_t span = spec.titleMax - spec.titleMin;
+            if (spec.titleDistribution == DatasetSpec::Uniform)
+                return spec.titleMin + rng.below(span + 1);
+            // Irwin-Hall: the mean of four uniforms is close enough to a normal curve
+            double sum = rng.unit() + rng.unit() + rng.unit() + rng.unit();
+            return spec.titleMin + static_cast<std::size_t>(sum / 4 * (span + 1));
+        }
+
+        // Words up to the wanted length, then a serial number so titles stay unique
+        std::string makeTitle(std::size_t serial)
+        {
+            std::string suffix = " " + std::to_string(serial);
+            std::size_t length = std::max(titleLength(), suffix.size() + 1);
+            std::string title;
+            while (title.size() + suffix.size() < length)
+            {
+                if (!title.empty())
+                    title += ' ';
+                title += word(rng.below(40));
+            }
+            title.resize(length - suffix.size());
+            if (title.back() == ' ')
+                title.back() = 'x';
+            if (title.front() >= 'a' && title.front() <= 'z')
+                title.front() = static_cast<char>(title.front() - 'a' + 'A');
+            return title + suffix;
+        }
+
+        std::size_t pickCategory()
+        {
+            double u = rng.unit() * categoryCdf.back();
+            return static_cast<std::size_t>(std::upper_bound(categoryCdf.begin(), categoryCdf.end(), u) - categoryCdf.begin());
+        }
+
+    public:
+        explicit DatasetGenerator(const DatasetSpec &s) : spec(s), rng(s.seed)
+        {
+            if (spec.titleMin == 0)
+                spec.titleMin = 1;
+            if (spec.titleMax < spec.titleMin)
+                spec.titleMax = spec.titleMin;
+
+            double total = 0;
+            for (std::size_t i = 0; i < spec.categories; ++i)
+            {
+                categoryNames.push_back(categoryName(i));
+                total += 1.0 / std::pow(static_cast<double>(i + 1), spec.categorySkew);
+                categoryCdf.push_back(total);
+            }
+
+            Date d = spec.firstDeadline;
+            for (int i = 0; i < std::max(spec.deadlineDays, 1) && d.year <= 9999; ++i)
+            {
+                dates.push_back(d);
+                if (++d.day > daysInMonth(d.year, d.month))
+                {
+                    d.day = 1;
+                    if (++d.month > 12)
+                    {
+                        d.month = 1;
+                        ++d.year;
+                    }
+                }
+            }
+        }
+
+        // Write the whole data set: active tasks first, then completed ones with
+        // the DONE: prefix, like TaskManager::saveToFile
+        void write(OutputBuffer &out)
+        {
+            std::string done; // Completed lines, written after the active ones
+            titles.clear();
+            for (std::size_t i = 0; i < spec.tasks; ++i)
+            {
+                std::string line;
+                if (!titles.empty() && rng.chance(spec.duplicates))
+                    line = titles[rng.below(titles.size())];
+                else
+                {
+                    line = makeTitle(i + 1);
+                    if (spec.duplicates > 0)
+                        titles.push_back(line);
+                }
+                bool completed = rng.chance(spec.completed);
+                line += ';';
+                line += formatDeadline(dates[rng.below(dates.size())]);
+                line += completed ? ";1" : ";0";
+                if (!categoryNames.empty() && !rng.chance(spec.uncategorized))
+                {
+                    line += ';';
+                    line += categoryNames[pickCategory()];
+                }
+                line += '\n';
+                if (completed)
+                    done += "DONE:" + line;
+                else
+                    out.append(line);
+            }
+            out.append(done);
+        }
+
+        // False if the file could not be written
+        bool write(const std::string &filename)
+        {
+            OutputBuffer out(filename);
+            if (!out.isOpen())
+                return false;
+            write(out);
+            out.flush();
+            return !out.hasFailed();
+        }
+    };
+
+} // namespace todo
+
+#endif
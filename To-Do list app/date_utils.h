@@ -0,0 +1,140 @@
+#ifndef TODO_DATE_UTILS_H
+#define TODO_DATE_UTILS_H
+
+#include <ctime>
+#include <string>
+#include <string_view>
+
+namespace todo
+{
+
+    // Calendar date as used for deadlines
+    struct Date
+    {
+        int year = 0;
+        int month = 0;
+        int day = 0;
+    };
+
+    inline bool isLeapYear(int year)
+    {
+        return (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+    }
+
+    inline int daysInMonth(int year, int month)
+    {
+        static const int days[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+        return month == 2 && isLeapYear(year) ? 29 : days[month - 1];
+    }
+
+    inline bool isValidDate(const Date &date)
+    {
+        return date.year >= 1 && date.year <= 9999 && date.month >= 1 && date.month <= 12 &&
+               date.day >= 1 && date.day <= daysInMonth(date.year, date.month);
+    }
+
+    // Read up to maxDigits digits from s at pos; false if there are none
+    inline bool readNumber(std::string_view s, std::size_t &pos, int maxDigits, int &value)
+    {
+        std::size_t start = pos;
+        value = 0;
+        while (pos < s.size() && s[pos] >= '0' && s[pos] <= '9' && pos - start < static_cast<std::size_t>(maxDigits))
+            value = value * 10 + (s[pos++] - '0');
+        return pos > start;
+    }
+
+    // Parse a date written as D.M.YYYY, D/M/YYYY (day first, like the app) or
+    // ISO YYYY-MM-DD. Anything after an ISO date (a time, a zone) is ignored.
+    // Surrounding spaces are allowed. Returns false for malformed or impossible dates
+    inline bool parseDate(std::string_view s, Date &date)
+    {
+        while (!s.empty() && s.front() == ' ')
+            s.remove_prefix(1);
+        while (!s.empty() && s.back() == ' ')
+            s.remove_suffix(1);
+
+        std::size_t pos = 0;
+        int first = 0;
+        if (!readNumber(s, pos, 4, first) || pos >= s.size())
+            return false;
+
+        char separator = s[pos];
+        if (separator == '-' && pos == 4)
+        {
+            date.year = first;
+            ++pos;
+            if (!readNumber(s, pos, 2, date.month) || pos >= s.size() || s[pos++] != '-' ||
+                !readNumber(s, pos, 2, date.day))
+                return false;
+            if (pos < s.size() && s[pos] != 'T' && s[pos] != ' ')
+                return false;
+        }
+        else if ((separator == '.' || separator == '/') && pos <= 2)
+        {
+            date.day = first;
+            ++pos;
+            if (!readNumber(s, pos, 2, date.month) || pos >= s.size() || s[pos++] != separator)
+                return false;
+            std::size_t yearStart = pos;
+            if (!readNumber(s, pos, 4, date.year) || pos - yearStart != 4 || pos != s.size())
+                return false;
+        }
+        else
+            return false;
+
+        return isValidDate(date);
+    }
+
+    // Days since 1.1.1970 in the proleptic Gregorian calendar, for stepping
+    // and comparing dates (H. Hinnant's days_from_civil)
+    inline long daysFromDate(const Date &date)
+    {
+        long year = date.year - (date.month <= 2 ? 1 : 0);
+        long era = (year >= 0 ? year : year - 399) / 400;
+        long yearOfEra = year - era * 400;
+        long dayOfYear = (153 * (date.month + (date.month > 2 ? -3 : 9)) + 2) / 5 + date.day - 1;
+        long dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+        return era * 146097 + dayOfEra - 719468;
+    }
+
+    inline Date dateFromDays(long days)
+    {
+        days += 719468;
+        long era = (days >= 0 ? days : days - 146096) / 146097;
+        long dayOfEra = days - era * 146097;
+        long yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+        long dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+        long shifted = (5 * dayOfYear + 2) / 153; // Months counted from March
+        Date date;
+        date.day = static_cast<int>(dayOfYear - (153 * shifted + 2) / 5 + 1);
+        date.month = static_cast<int>(shifted < 10 ? shifted + 3 : shifted - 9);
+        date.year = static_cast<int>(yearOfEra + era * 400 + (date.month <= 2 ? 1 : 0));
+        return date;
+    }
+
+    // The local calendar date
+    inline Date today()
+    {
+        std::time_t now = std::time(nullptr);
+        std::tm *local = std::localtime(&now);
+        Date date;
+        date.year = local->tm_year + 1900;
+        date.month = local->tm_mon + 1;
+        date.day = local->tm_mday;
+        return date;
+    }
+
+    // Format a date the way deadlines are stored: DD.MM.YYYY
+    inline std::string formatDeadline(const Date &date)
+    {
+        char text[11] = {
+            static_cast<char>('0' + date.day / 10), static_cast<char>('0' + date.day % 10), '.',
+            static_cast<char>('0' + date.month / 10), static_cast<char>('0' + date.month % 10), '.',
+            static_cast<char>('0' + date.year / 1000), static_cast<char>('0' + date.year / 100 % 10),
+            static_cast<char>('0' + date.year / 10 % 10), static_cast<char>('0' + date.year % 10), '\0'};
+        return std::string(text, 10);
+    }
+
+} // namespace todo
+
+#endif
@@ -0,0 +1,274 @@
+#ifndef TODO_DEADLINE_INDEX_H
+#define TODO_DEADLINE_INDEX_H
+
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <algorithm>
+#include <filesystem>
+#include <system_error>
+#include "metrics.h"
+#include "task_file.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/stat.h>
+#define TODO_FILE_INODES 1
+#endif
+
+namespace todo
+{
+
+    // What a file looked like on disk: size, modification time and inode
+    // (0 where there are no inodes). A rewrite shows up as a change even when
+    // it keeps the size
+    struct FileIdentity
+    {
+        std::uint64_t size = 0;
+        std::int64_t modified = 0; // Ticks of the file clock, nanoseconds on common systems
+        std::uint64_t inode = 0;
+
+        static FileIdentity of(const std::string &filename)
+        {
+            FileIdentity id;
+            std::error_code error;
+            std::uintmax_t size = std::filesystem::file_size(filename, error);
+            if (error)
+                return id;
+            id.size = size;
+            id.modified = static_cast<std::int64_t>(std::filesystem::last_write_time(filename, error).time_since_epoch().count());
+#ifdef TODO_FILE_INODES
+            struct stat st;
+            if (::stat(filename.c_str(), &st) == 0)
+                id.inode = static_cast<std::uint64_t>(st.st_ino);
+#endif
+            return id;
+        }
+
+        bool operator==(const FileIdentity &o) const { return size == o.size && modified == o.modified && inode == o.inode; }
+        bool operator!=(const FileIdentity &o) const { return !(*this == o); }
+    };
+
+    // Sidecar index (<tasks file>.idx) listing the active tasks of a task file
+    // ordered by deadline, as (deadline key, byte offset of the line) pairs.
+    //
+    // The index remembers the identity of the task file it was made for (size,
+    // modification time, inode), how many bytes of it it covers and a hash of
+    // the first and last block of that range. It is used only while the file is
+    // exactly as recorded. One-shot "add" appends a line and then records the
+    // new identity, so those lines are picked up by scanning just the new tail;
+    // any other change, even one that keeps the size, rebuilds the index from a
+    // full scan. saveToFile removes the index when it rewrites the file
+    class DeadlineIndex
+    {
+    private:
+        struct Entry
+        {
+            std::int32_t key;
+            std::uint32_t reserved;
+            std::uint64_t offset;
+        };
+
+        struct Header
+        {
+            char magic[8];
+            std::uint64_t coveredSize;
+            std::uint64_t fingerprint;
+            std::uint64_t count;
+            FileIdentity file; // The task file the index is current for
+        };
+
+        static constexpr char magicValue[8] = {'T', 'O', 'D', 'O', 'I', 'D', 'X', '2'};
+        static constexpr std::size_t sampleSize = 4096;
+        // Past this many unindexed bytes a rebuild is cheaper than rescanning the tail each time
+        static constexpr std::uint64_t maxTailBytes = 1 << 20;
+
+        static bool lessThan(const Entry &a, const Entry &b)
+        {
+            return a.key != b.key ? a.key < b.key : a.offset < b.offset;
+        }
+
+        // FNV-1a over bytes [start, start + length)
+        static std::uint64_t hashRange(std::FILE *f, std::uint64_t start, std::size_t length, std::uint64_t h)
+        {
+            char bytes[sampleSize];
+            std::size_t n = 0;
+            if (std::fseek(f, static_cast<long>(start), SEEK_SET) == 0)
+                n = std::fread(bytes, 1, std::min(length, sampleSize), f);
+            for (std::size_t i = 0; i < n; ++i)
+            {
+                h ^= static_cast<unsigned char>(bytes[i]);
+                h *= 1099511628211ULL;
+            }
+            return h ^ n;
+        }
+
+        // Cheap identity of the first `size` bytes: a hash of their first and last block
+        static std::uint64_t fingerprint(std::FILE *f, std::uint64_t size)
+        {
+            std::uint64_t tailStart = size > sampleSize ? size - sampleSize : 0;
+            std::uint64_t h = hashRange(f, 0, static_cast<std::size_t>(std::min<std::uint64_t>(size, sampleSize)), 1469598103934665603ULL);
+            return hashRange(f, tailStart, static_cast<std::size_t>(size - tailStart), h);
+        }
+
+        // Collect active lines from `from` to the end of the file
+        static bool scan(const std::string &filename, std::uint64_t from, std::vector<Entry> &entries)
+        {
+            LineReader reader;
+            if (!reader.open(filename, from))
+                return false;
+            std::string_view line;
+            std::uint64_t offset;
+            TaskRecord record;
+            while (reader.next(line, &offset))
+            {
+                parseTaskLine(line, record, 2);
+                if (!record.done)
+                    entries.push_back(Entry{deadlineKey(record.deadline), 0, offset});
+            }
+            return true;
+        }
+
+        // Read the header and the first `limit` entries; false if the index is unusable
+        static bool readIndex(const std::string &indexFile, std::FILE *tasks, const FileIdentity &file,
+                              std::size_t limit, Header &header, std::vector<Entry> &entries)
+        {
+            std::uint64_t tasksSize = file.size;
+            std::FILE *f = std::fopen(indexFile.c_str(), "rb");
+            if (!f)
+                return false;
+            bool ok = std::fread(&header, sizeof(header), 1, f) == 1 &&
+                      std::memcmp(header.magic, magicValue, sizeof(magicValue)) == 0 &&
+                      header.file == file &&
+                      header.coveredSize <= tasksSize &&
+                      tasksSize - header.coveredSize <= maxTailBytes &&
+                      fingerprint(tasks, header.coveredSize) == header.fingerprint;
+            if (ok)
+            {
+                std::size_t n = static_cast<std::size_t>(std::min<std::uint64_t>(header.count, limit));
+                entries.resize(n);
+                ok = n == 0 || std::fread(entries.data(), sizeof(Entry), n, f) == n;
+            }
+            std::fclose(f);
+            return ok;
+        }
+
+        static void writeIndex(const std::string &indexFile, std::FILE *tasks, const FileIdentity &file,
+                               const std::vector<Entry> &entries)
+        {
+            Header header;
+            std::memcpy(header.magic, magicValue, sizeof(magicValue));
+            header.coveredSize = file.size;
+            header.fingerprint = fingerprint(tasks, file.size);
+            header.count = entries.size();
+            header.file = file;
+
+            // Write next to the real file and swap it in, so readers never see half an index
+            std::string temp = indexFile + ".tmp";
+            std::FILE *f = std::fopen(temp.c_str(), "wb");
+            if (!f)
+                return;
+            bool ok = std::fwrite(&header, sizeof(header), 1, f) == 1 &&
+                      (entries.empty() || std::fwrite(entries.data(), sizeof(Entry), entries.size(), f) == entries.size());
+            ok = std::fclose(f) == 0 && ok;
+            std::remove(indexFile.c_str());
+            if (!ok || std::rename(temp.c_str(), indexFile.c_str()) != 0)
+                std::remove(temp.c_str());
+            else
+                MetricsRegistry::instance()
+                    .counter("todo_persisted_bytes_total", "Bytes written to task files and their indexes, by file", "file=\"index\"")
+                    .add(sizeof(header) + entries.size() * sizeof(Entry));
+        }
+
+        // The line starting at offset, without its line ending
+        static std::string readLine(std::FILE *f, std::uint64_t offset)
+        {
+            std::string line;
+            if (std::fseek(f, static_cast<long>(offset), SEEK_SET) != 0)
+                return line;
+            char chunk[256];
+            while (std::fgets(chunk, sizeof(chunk), f))
+            {
+                line += chunk;
+                if (!line.empty() && line.back() == '\n')
+                {
+                    line.pop_back();
+                    break;
+                }
+            }
+            return line;
+        }
+
+    public:
+        static std::string fileFor(const std::string &filename) { return filename + ".idx"; }
+
+        // After lines were appended to a task file that looked like before,
+        // let an index that was current then cover the new lines as a tail to
+        // scan. An index made for anything else is left to be rebuilt
+        static void appended(const std::string &filename, const FileIdentity &before)
+        {
+            std::FILE *f = std::fopen(fileFor(filename).c_str(), "r+b");
+            if (!f)
+                return;
+            Header header;
+            if (std::fread(&header, sizeof(header), 1, f) == 1 &&
+                std::memcmp(header.magic, magicValue, sizeof(magicValue)) == 0 && header.file == before)
+            {
+                header.file = FileIdentity::of(filename);
+                if (std::fseek(f, 0, SEEK_SET) == 0)
+                    std::fwrite(&header, sizeof(header), 1, f);
+            }
+            std::fclose(f);
+        }
+
+        // Drop the index of a task file that is about to be rewritten
+        static void invalidate(const std::string &filename) { std::remove(fileFor(filename).c_str()); }
+
+        // Lines of the `count` active tasks with the earliest deadlines, in order.
+        // Uses the index when it is current and rebuilds it otherwise
+        static std::vector<std::string> earliest(const std::string &filename, std::size_t count)
+        {
+            std::vector<std::string> lines;
+            std::FILE *tasks = std::fopen(filename.c_str(), "rb");
+            if (!tasks)
+                return lines;
+
+            FileIdentity file = FileIdentity::of(filename);
+            std::uint64_t size = file.size;
+            std::string indexFile = fileFor(filename);
+            Header header;
+            std::vector<Entry> entries;
+            static const MetricsRegistry::Counter hits = MetricsRegistry::instance().counter(
+                "todo_deadline_index_lookups_total", "Deadline index reads, by whether the sidecar was current", "result=\"hit\"");
+            static const MetricsRegistry::Counter rebuilds = MetricsRegistry::instance().counter(
+                "todo_deadline_index_lookups_total", "Deadline index reads, by whether the sidecar was current", "result=\"rebuild\"");
+            if (readIndex(indexFile, tasks, file, count, header, entries))
+            {
+                hits.add();
+                // Only lines appended since the index was built need a look
+                if (header.coveredSize < size)
+                    scan(filename, header.coveredSize, entries);
+            }
+            else
+            {
+                rebuilds.add();
+                entries.clear();
+                scan(filename, 0, entries);
+                std::sort(entries.begin(), entries.end(), lessThan);
+                writeIndex(indexFile, tasks, file, entries);
+            }
+
+            std::size_t n = std::min(count, entries.size());
+            std::partial_sort(entries.begin(), entries.begin() + n, entries.end(), lessThan);
+            for (std::size_t i = 0; i < n; ++i)
+                lines.push_back(readLine(tasks, entries[i].offset));
+            std::fclose(tasks);
+            return lines;
+        }
+    };
+
+} // namespace todo
+
+#endif
@@ -0,0 +1,322 @@
+#ifndef TODO_DEPENDENCY_GRAPH_H
+#define TODO_DEPENDENCY_GRAPH_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace todo
+{
+
+    // Which tasks wait for which, by title, kept in a topological order that
+    // is repaired as edges come in (Pearce and Kelly). Every task stands after
+    // the tasks it waits for, so a new edge that agrees with the order costs a
+    // duplicate check. One that does not only searches the stretch of the order
+    // between its two ends: forward from the waiting task for what waits on it,
+    // which finds a cycle if it reaches the other end, and backward from the
+    // other end for what it waits on. The two sets swap places among the
+    // positions they held, and nothing outside the stretch moves
+    class DependencyGraph
+    {
+    public:
+        using Node = std::uint32_t;
+
+        enum Result
+        {
+            Linked,        // The edge is new
+            AlreadyLinked, // The edge was there before
+            Cycle          // The edge would close a cycle and was left out
+        };
+
+    private:
+        static constexpr std::uint32_t none = 0xffffffffu;
+
+        std::unordered_map<std::string, Node> ids;
+        std::vector<const std::string *> titles; // Keys of ids, which stay put
+        std::vector<std::vector<Node>> before;   // The tasks each task waits for
+        std::vector<std::vector<Node>> after;    // The tasks waiting for each task
+        std::vector<std::uint32_t> position;     // Place of each task in the order
+        std::vector<Node> order;                 // Tasks by place
+        std::vector<std::uint32_t> visited;      // The search that last reached each task
+        std::uint32_t mark = 0;
+        std::size_t edges = 0;
+
+        // Scratch space of link(), kept to save allocations
+        std::vector<Node> forward;
+        std::vector<Node> backward;
+        std::vector<std::uint32_t> places;
+        std::vector<std::pair<Node, std::size_t>> stack;
+
+        // Collect in found the tasks reachable from start along edges whose
+        // place is within [low, high]. Returns false when stop is reached, with
+        // the chain from start to stop in path
+        bool search(Node start, const std::vector<std::vector<Node>> &edges, std::uint32_t low, std::uint32_t high,
+                    Node stop, std::vector<Node> &found, std::vector<Node> *path)
+        {
+            if (++mark == 0)
+            {
+                std::fill(visited.begin(), visited.end(), 0);
+                mark = 1;
+            }
+            found.clear();
+            stack.clear();
+            visited[start] = mark;
+            found.push_back(start);
+            stack.push_back(std::make_pair(start, std::size_t(0)));
+            while (!stack.empty())
+            {
+                const std::vector<Node> &next = edges[stack.back().first];
+                if (stack.back().second == next.size())
+                {
+                    stack.pop_back();
+                    continue;
+                }
+                Node n = next[stack.back().second++];
+                if (n == stop)
+                {
+                    if (path)
+                    {
+                        path->clear();
+                        for (const auto &frame : stack)
+                            path->push_back(frame.first);
+                        path->push_back(stop);
+                    }
+                    return false;
+                }
+                if (visited[n] == mark || position[n] < low || position[n] > high)
+                    continue;
+                visited[n] = mark;
+                found.push_back(n);
+                stack.push_back(std::make_pair(n, std::size_t(0)));
+            }
+            return true;
+        }
+
+        // Give the tasks found backward the first of the places both sets
+        // held and the tasks found forward the rest, each set in its old order
+        void reorder()
+        {
+            auto byPlace = [this](Node a, Node b)
+            { return position[a] < position[b]; };
+            std::sort(backward.begin(), backward.end(), byPlace);
+            std::sort(forward.begin(), forward.end(), byPlace);
+            places.clear();
+            for (Node n : backward)
+                places.push_back(position[n]);
+            for (Node n : forward)
+                places.push_back(position[n]);
+            std::sort(places.begin(), places.end());
+            std::size_t i = 0;
+            for (const auto *set : {&backward, &forward})
+            {
+                for (Node n : *set)
+                {
+                    position[n] = places[i];
+                    order[places[i++]] = n;
+                }
+            }
+        }
+
+        void addEdge(Node first, Node then)
+        {
+            after[first].push_back(then);
+            before[then].push_back(first);
+            ++edges;
+        }
+
+        static bool erase(std::vector<Node> &list, Node n)
+        {
+            auto it = std::find(list.begin(), list.end(), n);
+            if (it == list.end())
+                return false;
+            list.erase(it);
+            return true;
+        }
+
+        // Order every task from scratch (Kahn), keeping the current order among
+        // tasks that are free to go either way; false if there is a cycle
+        bool sortAll()
+        {
+            std::vector<std::uint32_t> waiting(order.size());
+            std::vector<Node> sorted;
+            sorted.reserve(order.size());
+            for (Node n : order)
+            {
+                waiting[n] = static_cast<std::uint32_t>(before[n].size());
+                if (waiting[n] == 0)
+                    sorted.push_back(n);
+            }
+            for (std::size_t i = 0; i < sorted.size(); ++i)
+                for (Node n : after[sorted[i]])
+                    if (--waiting[n] == 0)
+                        sorted.push_back(n);
+            if (sorted.size() < order.size())
+                return false;
+            order.swap(sorted);
+            for (std::uint32_t i = 0; i < order.size(); ++i)
+                position[order[i]] = i;
+            return true;
+        }
+
+    public:
+        // The task with this title, added at the end of the order if it is new
+        Node node(const std::string &title)
+        {
+            auto inserted = ids.emplace(title, static_cast<Node>(titles.size()));
+            if (inserted.second)
+            {
+                titles.push_back(&inserted.first->first);
+                before.emplace_back();
+                after.emplace_back();
+                position.push_back(static_cast<std::uint32_t>(order.size()));
+                order.push_back(inserted.first->second);
+                visited.push_back(0);
+            }
+            return inserted.first->second;
+        }
+
+        bool find(const std::string &title, Node &n) const
+        {
+            auto it = ids.find(title);
+            if (it == ids.end())
+                return false;
+            n = it->second;
+            return true;
+        }
+
+        // Make then wait for first. A cycle is refused, and cycle (if given)
+        // gets the chain by which first already waits for then: from then to
+        // first, each task waiting for the one before it
+        Result link(Node first, Node then, std::vector<Node> *cycle = nullptr)
+        {
+            if (first == then)
+            {
+                if (cycle)
+                    cycle->assign(1, first);
+                return Cycle;
+            }
+            if (std::find(after[first].begin(), after[first].end(), then) != after[first].end())
+                return AlreadyLinked;
+            if (position[first] > position[then])
+            {
+                if (!search(then, after, 0, position[first], first, forward, cycle))
+                    return Cycle;
+                search(first, before, position[then], none, none, backward, nullptr);
+                reorder();
+            }
+            addEdge(first, then);
+            return Linked;
+        }
+
+        // Stop then waiting for first; the order stays valid as it is
+        bool unlink(Node first, Node then)
+        {
+            if (!erase(after[first], then))
+                return false;
+            erase(before[then], first);
+            --edges;
+            return true;
+        }
+
+        // Take every edge of n out, leaving what n waited for in prerequisites
+        // and what waited for n in dependents; the order stays valid as it is
+        void detach(Node n, std::vector<Node> &prerequisites, std::vector<Node> &dependents)
+        {
+            prerequisites.swap(before[n]);
+            dependents.swap(after[n]);
+            before[n].clear();
+            after[n].clear();
+            for (Node p : prerequisites)
+                erase(after[p], n);
+            for (Node d : dependents)
+                erase(before[d], n);
+            edges -= prerequisites.size() + dependents.size();
+        }
+
+        // Add many edges at once, as from a file: they go in with one sort of
+        // the whole graph rather than a repair each. Should that find a cycle,
+        // they are added one at a time instead and the ones that would close
+        // one are left out. Returns how many were left out
+        std::size_t linkAll(const std::vector<std::pair<Node, Node>> &pairs)
+        {
+            std::vector<bool> added(pairs.size());
+            std::size_t refused = 0;
+            for (std::size_t i = 0; i < pairs.size(); ++i)
+            {
+                Node first = pairs[i].first, then = pairs[i].second;
+                const std::vector<Node> &out = after[first];
+                if (first == then)
+                    ++refused;
+                else if (std::find(out.begin(), out.end(), then) == out.end())
+                {
+                    addEdge(first, then);
+                    added[i] = true;
+                }
+            }
+            if (sortAll())
+                return refused;
+            for (std::size_t i = 0; i < pairs.size(); ++i)
+                if (added[i])
+                    unlink(pairs[i].first, pairs[i].second);
+            for (std::size_t i = 0; i < pairs.size(); ++i)
+                if (added[i] && link(pairs[i].first, pairs[i].second) == Cycle)
+                    ++refused;
+            return refused;
+        }
+
+        const std::string &title(Node n) const { return *titles[n]; }
+        const std::vector<Node> &prerequisites(Node n) const { return before[n]; }
+        const std::vector<Node> &dependents(Node n) const { return after[n]; }
+
+        // Call visit(node) for every task, each after all it waits for
+        template <class Visit>
+        void forEachInOrder(Visit visit) const
+        {
+            for (Node n : order)
+                visit(n);
+        }
+
+        bool empty() const { return edges == 0; }
+        std::size_t edgeCount() const { return edges; }
+    };
+
+    // Append a title to the value of an after= field. Titles are separated by
+    // '|', and a '|' or '\' inside a title gets a '\' in front
+    inline void appendTitleList(std::string &value, std::string_view title)
+    {
+        if (!value.empty())
+            value += '|';
+        for (char c : title)
+        {
+            if (c == '|' || c == '\\')
+                value += '\\';
+            value += c;
+        }
+    }
+
+    // Split the value of an after= field back into titles
+    inline void splitTitleList(std::string_view value, std::vector<std::string> &titles)
+    {
+        titles.clear();
+        if (value.empty())
+            return;
+        titles.emplace_back();
+        for (std::size_t i = 0; i < value.size(); ++i)
+        {
+            if (value[i] == '\\' && i + 1 < value.size())
+                titles.back() += value[++i];
+            else if (value[i] == '|')
+                titles.emplace_back();
+            else
+                titles.back() += value[i];
+        }
+    }
+
+} // namespace todo
+
+#endif
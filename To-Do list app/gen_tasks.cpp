@@ -0,0 +1,135 @@
+// Writes a synthetic task file in the tasks.txt format. The same options and
+// seed always give the same file.
+//
+// Usage: gen_tasks [options] [-o file]   (stdout without -o)
+
+#include <iostream>
+#include <string>
+#include <cstdlib>
+#include "dataset.h"
+
+namespace
+{
+    using namespace todo;
+
+    void usage()
+    {
+        std::cerr << "usage: gen_tasks [options] [-o file]\n"
+                     "  --tasks N              lines to write (1000)\n"
+                     "  --seed N               random seed (1)\n"
+                     "  --categories N         distinct categories (8)\n"
+                     "  --skew X               Zipf exponent of category use, 0 = even (1.0)\n"
+                     "  --uncategorized R      share of tasks without a category (0.1)\n"
+                     "  --title-length MIN:MAX title length range (8:40)\n"
+                     "  --title-dist D         uniform or normal (normal)\n"
+                     "  --first-deadline DATE  earliest deadline (01.01.2025)\n"
+                     "  --deadline-days N      days deadlines are spread over (730)\n"
+                     "  --completed R          share of completed tasks (0.2)\n"
+                     "  --duplicates R         share of titles repeating an earlier one (0)\n"
+                     "  --format F             output format; only text for now (text)\n";
+    }
+
+    bool parseCount(const char *s, std::size_t &value)
+    {
+        char *end;
+        unsigned long long v = std::strtoull(s, &end, 10);
+        if (*s == '\0' || *end != '\0')
+            return false;
+        value = static_cast<std::size_t>(v);
+        return true;
+    }
+
+    bool parseRatio(const char *s, double &value, double max = 1.0)
+    {
+        char *end;
+        double v = std::strtod(s, &end);
+        if (*s == '\0' || *end != '\0' || !(v >= 0 && v <= max))
+            return false;
+        value = v;
+        return true;
+    }
+
+    bool parseRange(const std::string &s, std::size_t &min, std::size_t &max)
+    {
+        std::size_t colon = s.find(':');
+        return colon != std::string::npos && parseCount(s.substr(0, colon).c_str(), min) &&
+               parseCount(s.substr(colon + 1).c_str(), max) && min >= 1 && min <= max;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    DatasetSpec spec;
+    std::string output;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (i + 1 >= argc)
+        {
+            usage();
+            return 2;
+        }
+        const char *value = argv[++i];
+        std::size_t count = 0;
+        bool ok = true;
+        if (arg == "-o")
+            output = value;
+        else if (arg == "--tasks")
+            ok = parseCount(value, spec.tasks);
+        else if (arg == "--seed")
+        {
+            ok = parseCount(value, count);
+            spec.seed = count;
+        }
+        else if (arg == "--categories")
+            ok = parseCount(value, spec.categories);
+        else if (arg == "--skew")
+            ok = parseRatio(value, spec.categorySkew, 10.0);
+        else if (arg == "--uncategorized")
+            ok = parseRatio(value, spec.uncategorized);
+        else if (arg == "--title-length")
+            ok = parseRange(value, spec.titleMin, spec.titleMax);
+        else if (arg == "--title-dist")
+        {
+            std::string d = value;
+            ok = d == "uniform" || d == "normal";
+            spec.titleDistribution = d == "uniform" ? DatasetSpec::Uniform : DatasetSpec::Normal;
+        }
+        else if (arg == "--first-deadline")
+            ok = parseDate(value, spec.firstDeadline);
+        else if (arg == "--deadline-days")
+        {
+            ok = parseCount(value, count) && count >= 1 && count <= 3650000;
+            spec.deadlineDays = static_cast<int>(count);
+        }
+        else if (arg == "--completed")
+            ok = parseRatio(value, spec.completed);
+        else if (arg == "--duplicates")
+            ok = parseRatio(value, spec.duplicates);
+        else if (arg == "--format")
+            ok = std::string(value) == "text";
+        else
+            ok = false;
+        if (!ok)
+        {
+            std::cerr << "Bad value for " << arg << ": " << value << "\n";
+            usage();
+            return 2;
+        }
+    }
+
+    DatasetGenerator generator(spec);
+    if (output.empty())
+    {
+        OutputBuffer out;
+        generator.write(out);
+        out.flush();
+        return out.hasFailed() ? 1 : 0;
+    }
+    if (!generator.write(output))
+    {
+        std::cerr << "Could not write " << output << "\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,211 @@
+#ifndef TODO_HISTORY_H
+#define TODO_HISTORY_H
+
+#include <cstddef>
+#include <deque>
+#include <string>
+#include <utility>
+#include <vector>
+#include "task.h"
+
+namespace todo
+{
+
+    // One reversible change to the lists of a TaskManager, kept as what is
+    // needed to apply it again or take it back rather than a copy of the lists.
+    // Steps recorded in a group join the step before them, and undo and redo
+    // move a group as a whole
+    struct HistoryStep
+    {
+        enum Kind
+        {
+            Added,          // tasks were appended to the active list
+            AddedCompleted, // tasks were appended to the completed list
+            Completed,      // tasks[0] moved from the active list to the end of the completed list
+            Deleted,        // tasks[0] was taken out of the active list
+            Advanced,       // series was completed: tasks[0], its done occurrence, went to the
+                            // end of the completed list and series moved on to its next deadline
+            Linked,         // tasks[0] was made to wait for tasks[1]
+            Unlinked        // tasks[0] stopped waiting for tasks[1]
+        };
+
+        Kind kind;
+        std::vector<TaskBase *> tasks;
+        std::vector<TaskBase *> shadowed; // Added: the task each title pointed to before, empty if none did
+        std::size_t position = 0;         // Completed, Deleted: index in the active list it was taken from
+        const char *group = nullptr;      // Name of the group this step starts
+        bool joinsPrevious = false;
+        RecurringTask *series = nullptr; // Advanced
+        std::vector<TaskBase *> prerequisites{}; // Completed, Deleted: the active tasks tasks[0] waited for
+        std::vector<TaskBase *> dependents{};    // Completed, Deleted: the active tasks that waited for tasks[0]
+
+        // Tasks outside the manager belong to the step: deleted ones until the
+        // delete is undone, added ones and done occurrences once undone
+        bool ownsTasks(bool undone) const
+        {
+            return undone ? kind == Added || kind == AddedCompleted || kind == Advanced : kind == Deleted;
+        }
+
+        // What undoing this step (and the group it starts) takes back
+        std::string describe() const
+        {
+            if (group)
+                return group;
+            switch (kind)
+            {
+            case Added:
+                return tasks.size() == 1 ? "add \"" + tasks[0]->getTitle() + "\""
+                                         : "add " + std::to_string(tasks.size()) + " tasks";
+            case AddedCompleted:
+                return "add " + std::to_string(tasks.size()) + " completed tasks";
+            case Completed:
+            case Advanced:
+                return "complete \"" + tasks[0]->getTitle() + "\"";
+            case Linked:
+                return "make \"" + tasks[0]->getTitle() + "\" wait for \"" + tasks[1]->getTitle() + "\"";
+            case Unlinked:
+                return "stop \"" + tasks[0]->getTitle() + "\" waiting for \"" + tasks[1]->getTitle() + "\"";
+            default:
+                return "delete \"" + tasks[0]->getTitle() + "\"";
+            }
+        }
+    };
+
+    // Undo and redo stacks of history steps. Memory grows with the changes
+    // made, not the size of the task lists; the oldest changes are dropped past
+    // maxEntries, and a new change drops everything that could be redone
+    class TaskHistory
+    {
+    public:
+        static constexpr std::size_t maxEntries = 1000;
+
+    private:
+        std::deque<HistoryStep> done;   // Oldest first
+        std::deque<HistoryStep> undone; // Most recently undone last, so a group's first step is on top
+        std::size_t doneEntries = 0;    // Steps in done that start a change
+        std::size_t undoneEntries = 0;
+        int groupDepth = 0;
+        const char *groupLabel = nullptr;
+        bool groupOpen = false; // The current group already has a step on top of done
+
+        static void release(HistoryStep &step, bool wasUndone)
+        {
+            if (step.ownsTasks(wasUndone))
+                for (auto t : step.tasks)
+                    delete t;
+        }
+
+    public:
+        TaskHistory() = default;
+        ~TaskHistory() { clear(); }
+
+        TaskHistory(const TaskHistory &) = delete;
+        TaskHistory &operator=(const TaskHistory &) = delete;
+
+        // Record a change just made; inside a group it joins the group's first step
+        void record(HistoryStep step)
+        {
+            for (auto &s : undone)
+                release(s, true);
+            undone.clear();
+            undoneEntries = 0;
+
+            if (groupDepth > 0 && groupOpen)
+                step.joinsPrevious = true;
+            else
+            {
+                step.group = groupDepth > 0 ? groupLabel : nullptr;
+                groupOpen = groupDepth > 0;
+                ++doneEntries;
+            }
+            done.push_back(std::move(step));
+
+            if (doneEntries > maxEntries)
+            {
+                do
+                {
+                    release(done.front(), false);
+                    done.pop_front();
+                } while (!done.empty() && done.front().joinsPrevious);
+                --doneEntries;
+            }
+        }
+
+        // Changes recorded until the matching endGroup() are undone together
+        void beginGroup(const char *label)
+        {
+            if (groupDepth++ == 0)
+            {
+                groupLabel = label;
+                groupOpen = false;
+            }
+        }
+
+        void endGroup()
+        {
+            if (--groupDepth == 0)
+                groupOpen = false;
+        }
+
+        bool canUndo() const { return !done.empty(); }
+        bool canRedo() const { return !undone.empty(); }
+        std::size_t undoDepth() const { return doneEntries; }
+        std::size_t redoDepth() const { return undoneEntries; }
+
+        // Undo a change step by step, newest first: revert each step popped
+        // here and hand it to pushUndone(), until one comes back with
+        // joinsPrevious false
+        HistoryStep popDone()
+        {
+            HistoryStep step = std::move(done.back());
+            done.pop_back();
+            if (!step.joinsPrevious)
+                --doneEntries;
+            groupOpen = false;
+            return step;
+        }
+
+        void pushUndone(HistoryStep step)
+        {
+            if (!step.joinsPrevious)
+                ++undoneEntries;
+            undone.push_back(std::move(step));
+        }
+
+        // Redo the same way, oldest step first, while nextJoins() says the
+        // following step belongs to the same change
+        HistoryStep popUndone()
+        {
+            HistoryStep step = std::move(undone.back());
+            undone.pop_back();
+            if (!step.joinsPrevious)
+                --undoneEntries;
+            return step;
+        }
+
+        bool nextJoins() const { return !undone.empty() && undone.back().joinsPrevious; }
+
+        void pushDone(HistoryStep step)
+        {
+            if (!step.joinsPrevious)
+                ++doneEntries;
+            done.push_back(std::move(step));
+        }
+
+        // Forget everything, freeing the tasks only the history still holds
+        void clear()
+        {
+            for (auto &s : done)
+                release(s, false);
+            for (auto &s : undone)
+                release(s, true);
+            done.clear();
+            undone.clear();
+            doneEntries = undoneEntries = 0;
+            groupOpen = false;
+        }
+    };
+
+} // namespace todo
+
+#endif
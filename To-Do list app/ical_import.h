@@ -0,0 +1,322 @@
+#ifndef TODO_ICAL_IMPORT_H
+#define TODO_ICAL_IMPORT_H
+
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+#include "task_file.h"
+#include "date_utils.h"
+#include "import_result.h"
+#include "task.h"
+#include "task_manager.h"
+
+namespace todo
+{
+
+    // Reads VTODO components from an iCalendar file without loading the whole
+    // document: physical lines are unfolded as they stream past and each task
+    // is handed to the manager in batches. A VTODO whose title and deadline a
+    // task already has, or whose UID came earlier in the file, is skipped, so
+    // importing the same file twice adds nothing the second time. An RRULE of
+    // FREQ and INTERVAL makes a recurring task starting at DTSTART; one that
+    // needs more (COUNT, UNTIL, BYDAY...) is rejected rather than imported as
+    // a one-off
+    class IcalImporter
+    {
+    private:
+        static constexpr std::size_t batchSize = 1 << 16;
+
+        // Properties of the VTODO being read
+        struct Todo
+        {
+            std::string summary;
+            std::string due;
+            std::string start; // DTSTART
+            std::string rrule;
+            std::string category;
+            std::string uid;
+            bool completed = false;
+            std::size_t line = 0;
+        };
+
+        ImportResult result;
+        std::unordered_set<std::string> known; // Title and deadline of every task there before
+        std::unordered_set<std::string> uids;  // UIDs seen in this file
+
+        static std::string key(const std::string &title, const std::string &deadline)
+        {
+            return title + '\n' + deadline;
+        }
+
+        // Whether a valid VTODO adds a task that is not there yet
+        bool fresh(const Todo &todo, const std::string &deadline)
+        {
+            if (!todo.uid.empty() && !uids.insert(todo.uid).second)
+                return false;
+            return known.count(key(todo.summary, deadline)) == 0;
+        }
+
+        // Undo TEXT escaping; stops at an unescaped ',' when listing values
+        static std::string unescapeText(std::string_view value, bool firstOfList)
+        {
+            std::string text;
+            for (std::size_t i = 0; i < value.size(); ++i)
+            {
+                char c = value[i];
+                if (c == '\\' && i + 1 < value.size())
+                {
+                    char next = value[++i];
+                    text += (next == 'n' || next == 'N') ? '\n' : next;
+                }
+                else if (c == ',' && firstOfList)
+                    break;
+                else
+                    text += c;
+            }
+            return text;
+        }
+
+        // Split "NAME;PARAM=...:VALUE" into its name and value; quoted
+        // parameter values may contain ':'
+        static bool splitProperty(std::string_view content, std::string_view &name, std::string_view &value)
+        {
+            std::size_t nameEnd = content.find_first_of(";:");
+            if (nameEnd == std::string_view::npos)
+                return false;
+            name = content.substr(0, nameEnd);
+            bool quoted = false;
+            for (std::size_t i = nameEnd; i < content.size(); ++i)
+            {
+                if (content[i] == '"')
+                    quoted = !quoted;
+                else if (content[i] == ':' && !quoted)
+                {
+                    value = content.substr(i + 1);
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        static bool equalsIgnoreCase(std::string_view a, const char *b)
+        {
+            std::size_t i = 0;
+            for (; i < a.size() && b[i]; ++i)
+            {
+                char c = a[i];
+                if (c >= 'a' && c <= 'z')
+                    c = static_cast<char>(c - 'a' + 'A');
+                if (c != b[i])
+                    return false;
+            }
+            return i == a.size() && !b[i];
+        }
+
+        // DATE or DATE-TIME value (YYYYMMDD[THHMMSS[Z]]) to a date
+        static bool convertDate(const std::string &value, Date &date)
+        {
+            if (value.size() < 8 || (value.size() > 8 && value[8] != 'T'))
+                return false;
+            int digits[8];
+            for (int i = 0; i < 8; ++i)
+            {
+                if (value[i] < '0' || value[i] > '9')
+                    return false;
+                digits[i] = value[i] - '0';
+            }
+            date.year = digits[0] * 1000 + digits[1] * 100 + digits[2] * 10 + digits[3];
+            date.month = digits[4] * 10 + digits[5];
+            date.day = digits[6] * 10 + digits[7];
+            return isValidDate(date);
+        }
+
+        // RRULE value to a rule; false for parts other than FREQ, INTERVAL and WKST
+        static bool convertRrule(std::string_view value, RecurrenceRule &rule)
+        {
+            static const char *frequencies[] = {"DAILY", "WEEKLY", "MONTHLY", "YEARLY"};
+            bool frequency = false;
+            rule.every = 1;
+            while (!value.empty())
+            {
+                std::size_t end = value.find(';');
+                std::string_view part = value.substr(0, end);
+                value.remove_prefix(end == std::string_view::npos ? value.size() : end + 1);
+                std::size_t equals = part.find('=');
+                if (equals == std::string_view::npos)
+                    return false;
+                std::string_view name = part.substr(0, equals);
+                std::string_view setting = part.substr(equals + 1);
+                if (equalsIgnoreCase(name, "FREQ"))
+                {
+                    for (int u = RecurrenceRule::Days; u <= RecurrenceRule::Years && !frequency; ++u)
+                    {
+                        frequency = equalsIgnoreCase(setting, frequencies[u]);
+                        rule.unit = static_cast<RecurrenceRule::Unit>(u);
+                    }
+                    if (!frequency)
+                        return false;
+                }
+                else if (equalsIgnoreCase(name, "INTERVAL"))
+                {
+                    std::size_t pos = 0;
+                    if (!readNumber(setting, pos, 3, rule.every) || pos != setting.size() || rule.every == 0)
+                        return false;
+                }
+                else if (!equalsIgnoreCase(name, "WKST"))
+                    return false;
+            }
+            return frequency;
+        }
+
+        TaskBase *convert(const Todo &todo)
+        {
+            std::string where = "line " + std::to_string(todo.line) + ": ";
+            const std::string &dueValue = todo.due.empty() ? todo.start : todo.due;
+            // A completed series is kept as the occurrence it ended on
+            bool repeats = !todo.rrule.empty() && !todo.completed;
+            Date due;
+            RecurrenceRule rule;
+            if (todo.summary.empty())
+                result.reject(where + "VTODO without SUMMARY");
+            else if (todo.summary.find_first_of(";\r\n") != std::string::npos ||
+                     todo.category.find_first_of(";\r\n") != std::string::npos)
+                result.reject(where + "summary or category contains ';' or a line break");
+            else if (!convertDate(dueValue, due))
+                result.reject(where + (dueValue.empty() ? std::string("VTODO without DUE date") : "invalid DUE \"" + dueValue + "\""));
+            else if (repeats && !convertRrule(todo.rrule, rule))
+                result.reject(where + "cannot repeat RRULE \"" + todo.rrule + "\"");
+            else if (repeats && !convertDate(todo.start.empty() ? dueValue : todo.start, rule.start))
+                result.reject(where + "invalid DTSTART \"" + todo.start + "\"");
+            else
+            {
+                std::string deadline = formatDeadline(due);
+                if (!fresh(todo, deadline))
+                    ++result.skipped;
+                else if (repeats)
+                    return new RecurringTask(todo.summary, deadline, todo.category, rule);
+                else if (todo.category.empty())
+                    return new Task(todo.summary, deadline, todo.completed);
+                else
+                    return new CategorizedTask(todo.summary, deadline, todo.category, todo.completed);
+            }
+            return nullptr;
+        }
+
+    public:
+        ImportResult run(const std::string &filename, TaskManager &manager)
+        {
+            result = ImportResult();
+            LineReader reader;
+            if (!reader.open(filename))
+                return result;
+            result.opened = true;
+            known.clear();
+            uids.clear();
+            manager.forEachTask([this](const TaskBase &task, bool)
+                                { known.insert(key(task.getTitle(), task.getDeadline())); });
+            TaskManager::UndoGroup undoAsOne(manager, "import-ics"); // One undo takes back the whole file
+
+            std::vector<TaskBase *> active, done;
+            Todo todo;
+            bool inTodo = false;
+            int nested = 0; // Depth of components inside the VTODO (VALARM)
+            std::size_t physical = 0;
+            std::size_t logicalStart = 0;
+            std::string logical;
+            bool havePending = false;
+
+            // Handle one unfolded content line
+            auto handle = [&](std::string_view content, std::size_t lineNumber)
+            {
+                std::string_view name, value;
+                if (!splitProperty(content, name, value))
+                    return;
+                if (equalsIgnoreCase(name, "BEGIN"))
+                {
+                    if (inTodo)
+                        ++nested;
+                    else if (equalsIgnoreCase(value, "VTODO"))
+                    {
+                        inTodo = true;
+                        todo = Todo();
+                        todo.line = lineNumber;
+                    }
+                }
+                else if (equalsIgnoreCase(name, "END"))
+                {
+                    if (nested > 0)
+                        --nested;
+                    else if (inTodo && equalsIgnoreCase(value, "VTODO"))
+                    {
+                        inTodo = false;
+                        if (TaskBase *task = convert(todo))
+                        {
+                            (todo.completed ? done : active).push_back(task);
+                            ++result.imported;
+                        }
+                    }
+                }
+                else if (!inTodo || nested > 0)
+                    return;
+                else if (equalsIgnoreCase(name, "SUMMARY"))
+                    todo.summary = unescapeText(value, false);
+                else if (equalsIgnoreCase(name, "DUE"))
+                    todo.due = std::string(value);
+                else if (equalsIgnoreCase(name, "DTSTART"))
+                    todo.start = std::string(value);
+                else if (equalsIgnoreCase(name, "RRULE"))
+                    todo.rrule = std::string(value);
+                else if (equalsIgnoreCase(name, "CATEGORIES") && todo.category.empty())
+                    todo.category = unescapeText(value, true);
+                else if (equalsIgnoreCase(name, "UID"))
+                    todo.uid = std::string(value);
+                else if (equalsIgnoreCase(name, "STATUS"))
+                    todo.completed = equalsIgnoreCase(value, "COMPLETED");
+                else if (equalsIgnoreCase(name, "COMPLETED"))
+                    todo.completed = true;
+            };
+
+            std::string_view physicalLine;
+            while (reader.next(physicalLine))
+            {
+                ++physical;
+                if (!physicalLine.empty() && physicalLine.back() == '\r')
+                    physicalLine.remove_suffix(1);
+                // A line starting with a space or tab continues the previous one
+                if (havePending && !physicalLine.empty() && (physicalLine[0] == ' ' || physicalLine[0] == '\t'))
+                {
+                    logical.append(physicalLine.data() + 1, physicalLine.size() - 1);
+                    continue;
+                }
+                if (havePending)
+                    handle(logical, logicalStart);
+                logical.assign(physicalLine.data(), physicalLine.size());
+                logicalStart = physical;
+                havePending = true;
+
+                if (active.size() >= batchSize)
+                {
+                    manager.addTasks(active);
+                    active.clear();
+                }
+                if (done.size() >= batchSize)
+                {
+                    manager.addCompletedTasks(done);
+                    done.clear();
+                }
+            }
+            if (havePending)
+                handle(logical, logicalStart);
+            // A file cut short loses its last task, and says so
+            if (inTodo)
+                result.reject("line " + std::to_string(todo.line) + ": VTODO not closed by END:VTODO");
+            manager.addTasks(active);
+            manager.addCompletedTasks(done);
+            return result;
+        }
+    };
+
+} // namespace todo
+
+#endif
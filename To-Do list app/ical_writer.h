@@ -0,0 +1,136 @@
+#ifndef TODO_ICAL_WRITER_H
+#define TODO_ICAL_WRITER_H
+
+#include <string>
+#include <ctime>
+#include <cstdint>
+#include <cstdio>
+#include "output_buffer.h"
+#include "date_utils.h"
+#include "recurrence.h"
+
+namespace todo
+{
+
+    // Writes tasks as iCalendar (RFC 5545) VTODO components, one at a time.
+    // Deadlines become all-day DUE dates and categories CATEGORIES. A series
+    // gets its first deadline as DTSTART and its rule as RRULE, so the DUE is
+    // the occurrence that is next
+    class IcalWriter
+    {
+    private:
+        OutputBuffer &out;
+        std::string stamp; // DTSTAMP shared by the whole export
+        std::string line;  // Scratch for the property being written
+
+        // Content lines longer than 75 octets are folded onto continuation
+        // lines starting with a space, never inside a UTF-8 sequence. Bytes
+        // that are not valid UTF-8 may leave no such place; then the fold
+        // falls at 75 octets anyway
+        void writeLine(const std::string &text)
+        {
+            std::size_t start = 0;
+            std::size_t limit = 75;
+            while (text.size() - start > limit)
+            {
+                std::size_t cut = start + limit;
+                while (cut > start && (static_cast<unsigned char>(text[cut]) & 0xC0) == 0x80)
+                    --cut;
+                if (cut == start)
+                    cut = start + limit;
+                out.append(text.data() + start, cut - start);
+                out.append("\r\n ", 3);
+                start = cut;
+                limit = 74; // The leading space counts
+            }
+            out.append(text.data() + start, text.size() - start);
+            out.append("\r\n", 2);
+        }
+
+        // TEXT values escape backslashes, ';', ',' and line breaks
+        static void appendText(std::string &target, const std::string &value)
+        {
+            for (char c : value)
+            {
+                if (c == '\\' || c == ';' || c == ',')
+                {
+                    target += '\\';
+                    target += c;
+                }
+                else if (c == '\n')
+                    target += "\\n";
+                else if (c != '\r')
+                    target += c;
+            }
+        }
+
+        static std::string dateValue(const Date &date)
+        {
+            char text[9];
+            std::snprintf(text, sizeof(text), "%04d%02d%02d", date.year, date.month, date.day);
+            return text;
+        }
+
+        // Stable UID so repeated exports of the same task update, not duplicate
+        static std::string uid(const std::string &title, const std::string &deadline)
+        {
+            std::uint64_t h = 1469598103934665603ULL;
+            for (char c : title + '\n' + deadline)
+            {
+                h ^= static_cast<unsigned char>(c);
+                h *= 1099511628211ULL;
+            }
+            char text[17];
+            std::snprintf(text, sizeof(text), "%016llx", static_cast<unsigned long long>(h));
+            return std::string(text) + "@todo-list-app";
+        }
+
+    public:
+        explicit IcalWriter(OutputBuffer &o) : out(o)
+        {
+            char text[17];
+            std::time_t now = std::time(nullptr);
+            std::strftime(text, sizeof(text), "%Y%m%dT%H%M%SZ", std::gmtime(&now));
+            stamp = text;
+
+            out.append(std::string("BEGIN:VCALENDAR\r\nVERSION:2.0\r\nPRODID:-//To-Do list app//EN\r\n"));
+        }
+
+        void write(const std::string &title, const std::string &deadline, const std::string &category, bool completed,
+                   const RecurrenceRule *rule = nullptr)
+        {
+            out.append(std::string("BEGIN:VTODO\r\n"));
+            writeLine("UID:" + uid(title, deadline));
+            writeLine("DTSTAMP:" + stamp);
+            line = "SUMMARY:";
+            appendText(line, title);
+            writeLine(line);
+
+            Date date;
+            if (parseDate(deadline, date))
+                writeLine("DUE;VALUE=DATE:" + dateValue(date));
+            if (rule)
+            {
+                static const char *frequencies[] = {"DAILY", "WEEKLY", "MONTHLY", "YEARLY"};
+                writeLine("DTSTART;VALUE=DATE:" + dateValue(rule->start));
+                writeLine(std::string("RRULE:FREQ=") + frequencies[rule->unit] + ";INTERVAL=" + std::to_string(rule->every));
+            }
+            if (!category.empty())
+            {
+                line = "CATEGORIES:";
+                appendText(line, category);
+                writeLine(line);
+            }
+            writeLine(completed ? "STATUS:COMPLETED" : "STATUS:NEEDS-ACTION");
+            out.append(std::string("END:VTODO\r\n"));
+        }
+
+        void finish()
+        {
+            out.append(std::string("END:VCALENDAR\r\n"));
+        }
+    };
+
+} // namespace todo
+
+#endif
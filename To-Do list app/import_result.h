@@ -0,0 +1,32 @@
+#ifndef TODO_IMPORT_RESULT_H
+#define TODO_IMPORT_RESULT_H
+
+#include <string>
+#include <vector>
+#include <cstddef>
+
+namespace todo
+{
+
+    // Outcome of importing tasks from another format
+    struct ImportResult
+    {
+        bool opened = false;
+        std::size_t imported = 0;
+        std::size_t rejected = 0;
+        std::size_t skipped = 0;         // Entries already there, left out
+        std::vector<std::string> errors; // The first few rejected entries, with reasons
+
+        static constexpr std::size_t maxErrors = 20;
+
+        void reject(const std::string &reason)
+        {
+            ++rejected;
+            if (errors.size() < maxErrors)
+                errors.push_back(reason);
+        }
+    };
+
+} // namespace todo
+
+#endif
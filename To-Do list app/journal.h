@@ -0,0 +1,215 @@
+#ifndef TODO_JOURNAL_H
+#define TODO_JOURNAL_H
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "task.h"
+#include "task_file.h"
+
+namespace todo
+{
+
+    // Append-only log of the changes made to a task file, kept next to it as
+    // <tasks file>.journal. One line per change:
+    //
+    //   <unix time>;<add|complete|reopen|delete>;<task line as saved>
+    //
+    // The task line carries the "DONE:" prefix when the task is on the completed
+    // list after the change (before it, for delete). The first line, "#since
+    // <unix time>", is where the history starts: older changes were never
+    // recorded or have been collected. Changes are buffered and written after
+    // the task file itself is saved
+    class TaskJournal
+    {
+    public:
+        enum Op
+        {
+            Add,
+            Complete,
+            Reopen,
+            Delete,
+            OpCount
+        };
+
+        struct Entry
+        {
+            std::int64_t time = 0;
+            Op op = Add;
+            std::string line;
+        };
+
+        static constexpr long defaultRetentionDays = 90;
+
+    private:
+        bool on = false;
+        long retentionDays = defaultRetentionDays;
+        std::vector<std::string> pending;
+
+        static const char *name(Op op)
+        {
+            static const char *names[OpCount] = {"add", "complete", "reopen", "delete"};
+            return names[op];
+        }
+
+        static std::string lineFor(std::int64_t time, Op op, const std::string &taskLine)
+        {
+            return std::to_string(time) + ";" + name(op) + ";" + taskLine + "\n";
+        }
+
+        // Time in the "#since" header, or -1 if the journal has none
+        static std::int64_t readSince(std::FILE *f)
+        {
+            char header[64];
+            if (!std::fgets(header, sizeof(header), f) || std::string_view(header).compare(0, 7, "#since ") != 0)
+                return -1;
+            return std::strtoll(header + 7, nullptr, 10);
+        }
+
+        static bool parseEntry(std::string_view line, Entry &entry)
+        {
+            std::size_t first = line.find(';');
+            std::size_t second = first == std::string_view::npos ? first : line.find(';', first + 1);
+            if (second == std::string_view::npos)
+                return false;
+            entry.time = std::strtoll(std::string(line.substr(0, first)).c_str(), nullptr, 10);
+            std::string_view op = line.substr(first + 1, second - first - 1);
+            int i = 0;
+            while (i < OpCount && op != name(static_cast<Op>(i)))
+                ++i;
+            if (i == OpCount)
+                return false;
+            entry.op = static_cast<Op>(i);
+            entry.line.assign(line.substr(second + 1));
+            return true;
+        }
+
+    public:
+        static std::string fileFor(const std::string &tasksFile) { return tasksFile + ".journal"; }
+
+        static std::int64_t now() { return static_cast<std::int64_t>(std::time(nullptr)); }
+
+        // Journaling is off until enabled, so tools that use a TaskManager as
+        // scratch space (benchmarks, as-of views) leave no trace
+        void enable(long keepDays = defaultRetentionDays)
+        {
+            on = true;
+            retentionDays = keepDays;
+        }
+
+        bool enabled() const { return on; }
+
+        // Note a change to task; completedList says which list it is on
+        void record(Op op, const TaskBase &task, bool completedList)
+        {
+            if (on)
+                pending.push_back(lineFor(now(), op, (completedList ? "DONE:" : "") + task.toFileString()));
+        }
+
+        // Append the buffered changes to the journal of tasksFile, starting it
+        // if there is none, and collect history past the retention window at
+        // most once a day. Returns false if the journal could not be written
+        bool flush(const std::string &tasksFile)
+        {
+            if (pending.empty())
+                return true;
+            std::string file = fileFor(tasksFile);
+            std::int64_t since = -1;
+            if (std::FILE *existing = std::fopen(file.c_str(), "rb"))
+            {
+                since = readSince(existing);
+                std::fclose(existing);
+            }
+            std::FILE *f = std::fopen(file.c_str(), "ab");
+            if (!f)
+                return false;
+            bool ok = true;
+            if (since < 0)
+            {
+                since = std::strtoll(pending.front().c_str(), nullptr, 10);
+                ok = std::fprintf(f, "#since %lld\n", static_cast<long long>(since)) > 0;
+            }
+            for (const auto &line : pending)
+                ok = ok && std::fwrite(line.data(), 1, line.size(), f) == line.size();
+            ok = std::fclose(f) == 0 && ok;
+            pending.clear();
+            std::int64_t horizon = now() - static_cast<std::int64_t>(retentionDays) * 86400;
+            if (ok && since < horizon - 86400)
+                ok = collect(tasksFile, horizon);
+            return ok;
+        }
+
+        // Append one change made without a TaskManager (the one-shot add)
+        static bool append(const std::string &tasksFile, Op op, const std::string &taskLine)
+        {
+            TaskJournal journal;
+            journal.enable();
+            journal.pending.push_back(lineFor(now(), op, taskLine));
+            return journal.flush(tasksFile);
+        }
+
+        // Read every entry, oldest first, and the start of the history.
+        // Without a journal there are no entries and the history starts now
+        static bool read(const std::string &tasksFile, std::vector<Entry> &entries, std::int64_t &since)
+        {
+            entries.clear();
+            since = now();
+            LineReader reader;
+            if (!reader.open(fileFor(tasksFile)))
+                return false;
+            std::string_view line;
+            Entry entry;
+            bool first = true;
+            while (reader.next(line))
+            {
+                if (!line.empty() && line.back() == '\r')
+                    line.remove_suffix(1);
+                if (first && line.compare(0, 7, "#since ") == 0)
+                    since = std::strtoll(std::string(line.substr(7)).c_str(), nullptr, 10);
+                else if (parseEntry(line, entry))
+                    entries.push_back(entry);
+                first = false;
+            }
+            return true;
+        }
+
+        // Drop the entries before horizon and move the start of the history
+        // there. Versions that ended before it disappear; tasks that still
+        // existed at the horizon are known from then on. The journal is
+        // rewritten next to itself and renamed over, so readers see either one
+        static bool collect(const std::string &tasksFile, std::int64_t horizon)
+        {
+            std::vector<Entry> entries;
+            std::int64_t since;
+            if (!read(tasksFile, entries, since))
+                return true;
+            std::string file = fileFor(tasksFile);
+            std::string temp = file + ".tmp";
+            std::FILE *f = std::fopen(temp.c_str(), "wb");
+            if (!f)
+                return false;
+            bool ok = std::fprintf(f, "#since %lld\n", static_cast<long long>(since > horizon ? since : horizon)) > 0;
+            for (const auto &e : entries)
+            {
+                if (e.time < horizon)
+                    continue;
+                std::string line = lineFor(e.time, e.op, e.line);
+                ok = ok && std::fwrite(line.data(), 1, line.size(), f) == line.size();
+            }
+            ok = std::fclose(f) == 0 && ok;
+            if (!ok || std::rename(temp.c_str(), file.c_str()) != 0)
+            {
+                std::remove(temp.c_str());
+                return false;
+            }
+            return true;
+        }
+    };
+
+} // namespace todo
+
+#endif
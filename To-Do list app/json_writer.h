@@ -0,0 +1,125 @@
+#ifndef TODO_JSON_WRITER_H
+#define TODO_JSON_WRITER_H
+
+#include <string>
+#include <string_view>
+#include <cstddef>
+#include "output_buffer.h"
+
+namespace todo
+{
+
+    // Append s as a quoted JSON string. Runs of characters that need no
+    // escaping are copied in one go; quotes, backslashes and control
+    // characters are escaped. Other bytes are passed through as UTF-8
+    inline void appendJsonString(OutputBuffer &out, std::string_view s)
+    {
+        static const char hex[] = "0123456789abcdef";
+        out.append('"');
+        const char *data = s.data();
+        std::size_t runStart = 0;
+        for (std::size_t i = 0; i < s.size(); ++i)
+        {
+            unsigned char c = static_cast<unsigned char>(data[i]);
+            if (c >= 0x20 && c != '"' && c != '\\')
+                continue;
+
+            out.append(data + runStart, i - runStart);
+            runStart = i + 1;
+            switch (c)
+            {
+            case '"':
+                out.append("\\\"", 2);
+                break;
+            case '\\':
+                out.append("\\\\", 2);
+                break;
+            case '\n':
+                out.append("\\n", 2);
+                break;
+            case '\r':
+                out.append("\\r", 2);
+                break;
+            case '\t':
+                out.append("\\t", 2);
+                break;
+            case '\b':
+                out.append("\\b", 2);
+                break;
+            case '\f':
+                out.append("\\f", 2);
+                break;
+            default:
+            {
+                char escaped[6] = {'\\', 'u', '0', '0', hex[c >> 4], hex[c & 0xf]};
+                out.append(escaped, 6);
+            }
+            }
+        }
+        out.append(data + runStart, s.size() - runStart);
+        out.append('"');
+    }
+
+    // Write a stream of task objects either as one JSON array or as NDJSON
+    // (one object per line). Objects go straight to the buffer, so memory use
+    // does not grow with the number of tasks
+    class JsonTaskWriter
+    {
+    private:
+        OutputBuffer &out;
+        bool ndjson;
+        bool first;
+
+    public:
+        JsonTaskWriter(OutputBuffer &o, bool newlineDelimited)
+            : out(o), ndjson(newlineDelimited), first(true)
+        {
+            if (!ndjson)
+                out.append("[\n", 2);
+        }
+
+        // Close the array if one was opened
+        void finish()
+        {
+            if (!ndjson)
+                out.append(first ? "]\n" : "\n]\n", first ? 2 : 3);
+        }
+
+        // category is left out as null when the task has none, and so is
+        // repeat (the repeat= field of the task file) for a one-off task
+        void write(const std::string &title, const std::string &deadline, const std::string &category,
+                   bool hasCategory, bool completed, std::string_view repeat = std::string_view())
+        {
+            if (!ndjson && !first)
+                out.append(",\n", 2);
+            first = false;
+
+            out.append("{\"title\":", 9);
+            appendJsonString(out, title);
+            out.append(",\"deadline\":", 12);
+            appendJsonString(out, deadline);
+            out.append(",\"category\":", 12);
+            if (hasCategory)
+                appendJsonString(out, category);
+            else
+                out.append("null", 4);
+            if (completed)
+                out.append(",\"status\":\"completed\"", 21);
+            else
+                out.append(",\"status\":\"active\"", 18);
+            out.append(",\"repeat\":", 10);
+            if (repeat.empty())
+                out.append("null}", 5);
+            else
+            {
+                appendJsonString(out, repeat);
+                out.append('}');
+            }
+            if (ndjson)
+                out.append('\n');
+        }
+    };
+
+} // namespace todo
+
+#endif
@@ -0,0 +1,288 @@
+#ifndef TODO_LATENCY_STATS_H
+#define TODO_LATENCY_STATS_H
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "metrics.h"
+#include "output_buffer.h"
+#include "perf_counters.h"
+
+namespace todo
+{
+
+    // Log-linear latency histogram in the style of HdrHistogram. Every power of
+    // two is split into 64 equal sub-buckets, so any recorded value is known to
+    // within 1/64 (about 1.6%) from 1 ns up to the full 64-bit range. Recording
+    // is a bit scan and an increment; the counts take a fixed 30 KB
+    class LatencyHistogram
+    {
+    public:
+        static constexpr int subBucketBits = 6;
+        static constexpr std::size_t subBuckets = std::size_t(1) << subBucketBits;
+        static constexpr std::size_t bucketCount = 2 * subBuckets + (64 - subBucketBits - 1) * subBuckets;
+
+    private:
+        std::vector<std::uint64_t> counts = std::vector<std::uint64_t>(bucketCount);
+        std::uint64_t total = 0;
+        std::uint64_t maxValue = 0;
+
+        static int highestBit(std::uint64_t v)
+        {
+#if defined(__GNUC__) || defined(__clang__)
+            return 63 - __builtin_clzll(v);
+#else
+            int bit = 0;
+            while (v >>= 1)
+                ++bit;
+            return bit;
+#endif
+        }
+
+        // Values below 2 * subBuckets are exact; above that only the top
+        // subBucketBits + 1 bits of a value are kept
+        static std::size_t indexOf(std::uint64_t v)
+        {
+            if (v < 2 * subBuckets)
+                return static_cast<std::size_t>(v);
+            int shift = highestBit(v) - subBucketBits;
+            return 2 * subBuckets + (shift - 1) * subBuckets + static_cast<std::size_t>((v >> shift) - subBuckets);
+        }
+
+        // Largest value that lands in bucket index
+        static std::uint64_t highestIn(std::size_t index)
+        {
+            if (index < 2 * subBuckets)
+                return index;
+            std::size_t shift = (index - 2 * subBuckets) / subBuckets + 1;
+            std::uint64_t top = (index - 2 * subBuckets) % subBuckets + subBuckets;
+            return ((top + 1) << shift) - 1;
+        }
+
+    public:
+        void record(std::uint64_t nanoseconds)
+        {
+            ++counts[indexOf(nanoseconds)];
+            ++total;
+            if (nanoseconds > maxValue)
+                maxValue = nanoseconds;
+        }
+
+        std::uint64_t count() const { return total; }
+        std::uint64_t max() const { return maxValue; }
+
+        // Smallest value at or below which `percent` of the samples fall,
+        // rounded up to the end of its bucket but never past the maximum
+        std::uint64_t percentile(double percent) const
+        {
+            if (total == 0)
+                return 0;
+            std::uint64_t wanted = static_cast<std::uint64_t>(percent / 100.0 * static_cast<double>(total) + 0.5);
+            if (wanted < 1)
+                wanted = 1;
+            std::uint64_t seen = 0;
+            for (std::size_t i = 0; i < bucketCount; ++i)
+            {
+                seen += counts[i];
+                if (seen >= wanted)
+                    return highestIn(i) < maxValue ? highestIn(i) : maxValue;
+            }
+            return maxValue;
+        }
+
+        void reset()
+        {
+            counts.assign(bucketCount, 0);
+            total = maxValue = 0;
+        }
+    };
+
+    // One latency histogram per TaskManager operation
+    class OperationStats
+    {
+    public:
+        enum Operation
+        {
+            Load,
+            Save,
+            Add,
+            AddBatch,
+            AddCompleted,
+            View,
+            ViewSorted,
+            ViewCompleted,
+            Complete,
+            Delete,
+            Search,
+            FilterCategory,
+            ListCategories,
+            ExportJson,
+            ExportIcal,
+            Undo,
+            Redo,
+            Agenda,
+            Depend,
+            Ready,
+            Plan,
+            OperationCount
+        };
+
+        static const char *name(Operation op)
+        {
+            static const char *names[OperationCount] = {
+                "load", "save", "add", "add-batch", "add-completed", "view", "view-sorted", "view-completed",
+                "complete", "delete", "search", "filter-category", "list-categories", "export-json", "export-ics",
+                "undo", "redo", "agenda", "depend", "ready", "plan"};
+            return names[op];
+        }
+
+    private:
+        LatencyHistogram histograms[OperationCount];
+        const PerfCounters *perf = nullptr; // Hardware counters, when attached
+        PerfSample perfTotals[OperationCount];
+        MetricsRegistry::Counter calls[OperationCount]; // todo_operations_total, shared by every TaskManager
+
+        static void appendDuration(std::string &line, std::uint64_t ns)
+        {
+            char text[32];
+            if (ns < 1000)
+                std::snprintf(text, sizeof(text), "%10lluns", static_cast<unsigned long long>(ns));
+            else if (ns < 1000000)
+                std::snprintf(text, sizeof(text), "%10.1fus", ns / 1e3);
+            else if (ns < 1000000000)
+                std::snprintf(text, sizeof(text), "%10.1fms", ns / 1e6);
+            else
+                std::snprintf(text, sizeof(text), "%11.2fs", ns / 1e9);
+            line += text;
+        }
+
+    public:
+        OperationStats()
+        {
+            for (int op = 0; op < OperationCount; ++op)
+                calls[op] = MetricsRegistry::instance().counter(
+                    "todo_operations_total", "TaskManager operations run, by type",
+                    std::string("op=\"") + name(static_cast<Operation>(op)) + "\"");
+        }
+
+        void record(Operation op, std::uint64_t nanoseconds)
+        {
+            histograms[op].record(nanoseconds);
+            calls[op].add();
+        }
+
+        // Also count hardware events per operation; a read costs a few system
+        // calls, so this is only for tuning sessions. Pass nullptr to stop
+        void attach(const PerfCounters *counters) { perf = counters; }
+        const PerfCounters *counters() const { return perf; }
+        void recordEvents(Operation op, const PerfSample &sample) { perfTotals[op].add(sample); }
+
+        const LatencyHistogram &histogram(Operation op) const { return histograms[op]; }
+
+        bool empty() const
+        {
+            for (const auto &h : histograms)
+                if (h.count() > 0)
+                    return false;
+            return true;
+        }
+
+        // Table of count, p50, p99, p99.9 and max for every operation that ran
+        void report(OutputBuffer &out) const
+        {
+            out.append(std::string("operation            count         p50         p99        p999         max\n"));
+            for (int op = 0; op < OperationCount; ++op)
+            {
+                const LatencyHistogram &h = histograms[op];
+                if (h.count() == 0)
+                    continue;
+                char head[40];
+                std::snprintf(head, sizeof(head), "%-16s%10llu", name(static_cast<Operation>(op)),
+                              static_cast<unsigned long long>(h.count()));
+                std::string line = head;
+                appendDuration(line, h.percentile(50));
+                appendDuration(line, h.percentile(99));
+                appendDuration(line, h.percentile(99.9));
+                appendDuration(line, h.max());
+                line += '\n';
+                out.append(line);
+            }
+            if (perf)
+                reportEvents(out);
+        }
+
+        // Right-aligned number, or n/a for a counter that is missing
+        static void appendColumn(std::string &line, int width, int precision, double value)
+        {
+            char text[32];
+            if (value < 0)
+                std::snprintf(text, sizeof(text), "%*s", width, "n/a");
+            else
+                std::snprintf(text, sizeof(text), "%*.*f", width, precision, value);
+            line += text;
+        }
+
+        // Average hardware events per call of every operation that ran
+        void reportEvents(OutputBuffer &out) const
+        {
+            out.append(std::string("operation          cycles/op      instr/op    IPC  cache-miss/op  branch-miss/op\n"));
+            for (int op = 0; op < OperationCount; ++op)
+            {
+                const LatencyHistogram &h = histograms[op];
+                const PerfSample &p = perfTotals[op];
+                if (h.count() == 0 || !p.any())
+                    continue;
+                double n = static_cast<double>(h.count());
+                auto perCall = [&](PerfSample::Event e)
+                { return p.has(e) ? p.counts[e] / n : -1.0; };
+                double cycles = perCall(PerfSample::Cycles), instructions = perCall(PerfSample::Instructions);
+
+                char head[24];
+                std::snprintf(head, sizeof(head), "%-16s", name(static_cast<Operation>(op)));
+                std::string line = head;
+                appendColumn(line, 14, 0, cycles);
+                appendColumn(line, 14, 0, instructions);
+                appendColumn(line, 7, 2, cycles > 0 && instructions >= 0 ? instructions / cycles : -1);
+                appendColumn(line, 15, 1, perCall(PerfSample::CacheMisses));
+                appendColumn(line, 16, 1, perCall(PerfSample::BranchMisses));
+                line += '\n';
+                out.append(line);
+            }
+        }
+    };
+
+    // Records the lifetime of a scope as one sample of an operation, and its
+    // hardware events when counters are attached
+    class LatencyTimer
+    {
+    private:
+        OperationStats &stats;
+        OperationStats::Operation op;
+        PerfSample events; // Counter readings at the start, when counters are attached
+        std::chrono::steady_clock::time_point start;
+
+    public:
+        LatencyTimer(OperationStats &s, OperationStats::Operation o) : stats(s), op(o)
+        {
+            if (stats.counters())
+                events = stats.counters()->read();
+            start = std::chrono::steady_clock::now();
+        }
+
+        ~LatencyTimer()
+        {
+            auto elapsed = std::chrono::steady_clock::now() - start;
+            stats.record(op, static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+            if (stats.counters())
+                stats.recordEvents(op, PerfCounters::difference(events, stats.counters()->read()));
+        }
+
+        LatencyTimer(const LatencyTimer &) = delete;
+        LatencyTimer &operator=(const LatencyTimer &) = delete;
+    };
+
+} // namespace todo
+
+#endif
@@ -1,368 +1,592 @@
-#include <iostream>
-#include <vector>
-#include <string>
-#include <fstream>
-#include <sstream>
-#include <map>
-#include <set>
-#include <algorithm>
-#include <iomanip> // For width formatting
-
-namespace todo
-{
-
-    // Abstract base class for tasks
-    class TaskBase
-    {
-    public:
-        // Pure virtual methods so that derived classes implement these
-        virtual void display() const = 0;
-        virtual std::string toFileString() const = 0;
-        virtual std::string getTitle() const = 0;
-        virtual std::string getDeadline() const = 0;
-        virtual std::string getCategory() const = 0;
-        virtual bool isCompleted() const = 0;
-        virtual void markCompleted() = 0;
-        virtual ~TaskBase() {} // Virtual destructor for safe polymorphic deletion
-    };
-
-    // Concrete task class
-    class Task : public TaskBase
-    {
-    protected:
-        std::string title;
-        std::string deadline;
-        bool completed;
-
-    public:
-        // Default constructor
-        Task() : title(""), deadline(""), completed(false) {}
-
-        // Parameterized constructor
-        Task(const std::string &t, const std::string &d, bool c = false)
-            : title(t), deadline(d), completed(c) {}
-
-        // Display task details
-        virtual void display() const override
-        {
-            std::cout << (completed ? "[X] " : "[ ] ")
-                      << std::left << std::setw(20) << title
-                      << " | Due: " << std::setw(12) << deadline << std::endl;
-        }
-
-        // Convert task details to a string for saving
-        virtual std::string toFileString() const override
-        {
-            return title + ";" + deadline + ";" + (completed ? "1" : "0");
-        }
-
-        // Mark task as completed
-        virtual void markCompleted() override { completed = true; }
-        virtual bool isCompleted() const override { return completed; }
-        virtual std::string getTitle() const override { return title; }
-        virtual std::string getDeadline() const override { return deadline; }
-        virtual std::string getCategory() const override { return ""; }
-
-        // Overload << operator to display task
-        friend std::ostream &operator<<(std::ostream &os, const Task &task)
-        {
-            os << (task.completed ? "[X] " : "[ ] ") << task.title << " (Due: " << task.deadline << ")";
-            return os;
-        }
-
-        // Overload + operator to combine tasks
-        Task operator+(const Task &other)
-        {
-            return Task(title + " & " + other.title, deadline);
-        }
-    };
-
-    // Derived class with category support
-    class CategorizedTask : public Task
-    {
-    private:
-        std::string category;
-
-    public:
-        CategorizedTask() : Task(), category("") {}
-        CategorizedTask(const std::string &t, const std::string &d, const std::string &cat, bool c = false)
-            : Task(t, d, c), category(cat) {}
-
-        // Display including category
-        void display() const override
-        {
-            std::cout << (completed ? "[X] " : "[ ] ")
-                      << std::left << std::setw(20) << title
-                      << " | Due: " << std::setw(12) << deadline
-                      << " | Category: " << category << std::endl;
-        }
-
-        // Convert to file string with category
-        std::string toFileString() const override
-        {
-            return title + ";" + deadline + ";" + (completed ? "1" : "0") + ";" + category;
-        }
-
-        std::string getCategory() const override { return category; }
-    };
-
-    // Task manager class that handles all task operations
-    class TaskManager
-    {
-    private:
-        std::vector<TaskBase *> tasks;              // Active tasks
-        std::vector<TaskBase *> completedTasks;     // Completed tasks
-        std::map<std::string, TaskBase *> titleMap; // Map for quick title lookup
-        std::set<std::string> categories;           // Set of all unique categories
-
-        // Convert date string "dd.mm.yyyy" to int "yyyymmdd" for sorting
-        static int dateToInt(const std::string &date)
-        {
-            std::istringstream ss(date);
-            std::string day, month, year;
-            getline(ss, day, '.');
-            getline(ss, month, '.');
-            getline(ss, year, '.');
-            if (day.length() == 1)
-                day = "0" + day;
-            if (month.length() == 1)
-                month = "0" + month;
-            return std::stoi(year + month + day);
-        }
-
-    public:
-        // Destructor to clean up all dynamically allocated tasks
-        ~TaskManager()
-        {
-            for (auto t : tasks)
-                delete t;
-            for (auto t : completedTasks)
-                delete t;
-        }
-
-        // Add a task to the system
-        void addTask(TaskBase *task)
-        {
-            tasks.push_back(task);
-            titleMap[task->getTitle()] = task;
-            if (!task->getCategory().empty())
-                categories.insert(task->getCategory());
-        }
-
-        // Display tasks, optionally sorted by deadline
-        void viewTasks(bool sorted = false) const
-        {
-            std::vector<TaskBase *> temp = tasks;
-            if (sorted)
-            {
-                std::sort(temp.begin(), temp.end(), [](TaskBase *a, TaskBase *b)
-                          { return dateToInt(a->getDeadline()) < dateToInt(b->getDeadline()); });
-            }
-            for (const auto &t : temp)
-                t->display();
-        }
-
-        // Display all completed tasks
-        void viewCompleted() const
-        {
-            for (const auto &t : completedTasks)
-                t->display();
-        }
-
-        // Mark task as completed by title
-        void markCompleted(const std::string &title)
-        {
-            auto it = titleMap.find(title);
-            if (it != titleMap.end())
-            {
-                it->second->markCompleted();
-                completedTasks.push_back(it->second);
-                tasks.erase(std::remove(tasks.begin(), tasks.end(), it->second), tasks.end());
-                titleMap.erase(it);
-            }
-        }
-
-        // Delete a task by title
-        void deleteTask(const std::string &title)
-        {
-            auto it = titleMap.find(title);
-            if (it != titleMap.end())
-            {
-                TaskBase *task = it->second;
-                tasks.erase(std::remove(tasks.begin(), tasks.end(), task), tasks.end());
-                delete task;
-                titleMap.erase(it);
-            }
-        }
-
-        // Search for a task by keyword
-        void searchTask(const std::string &query) const
-        {
-            for (const auto &t : tasks)
-            {
-                if (t->getTitle().find(query) != std::string::npos)
-                {
-                    t->display();
-                }
-            }
-        }
-
-        // Filter tasks by category
-        void filterByCategory(const std::string &category) const
-        {
-            std::cout << "Available categories to choose from:\n";
-            for (const auto &cat : categories)
-            {
-                std::cout << " - " << cat << std::endl;
-            }
-            std::cout << "\nShowing tasks for category: " << category << "\n";
-            for (const auto &t : tasks)
-            {
-                if (t->getCategory() == category)
-                    t->display();
-            }
-        }
-
-        // List all unique categories
-        void listAllCategories() const
-        {
-            std::cout << "Available categories:\n";
-            for (const auto &cat : categories)
-            {
-                std::cout << " - " << cat << std::endl;
-            }
-        }
-
-        // Save current tasks to file
-        void saveToFile(const std::string &filename)
-        {
-            std::ofstream ofs(filename);
-            for (const auto &t : tasks)
-                ofs << t->toFileString() << std::endl;
-            for (const auto &t : completedTasks)
-                ofs << "DONE:" << t->toFileString() << std::endl;
-        }
-
-        // Load tasks from file
-        void loadFromFile(const std::string &filename)
-        {
-            std::ifstream ifs(filename);
-            std::string line;
-            while (getline(ifs, line))
-            {
-                bool isDone = false;
-                if (line.rfind("DONE:", 0) == 0)
-                {
-                    isDone = true;
-                    line = line.substr(5);
-                }
-                std::stringstream ss(line);
-                std::string title, deadline, completedStr, category;
-
-                getline(ss, title, ';');
-                getline(ss, deadline, ';');
-                getline(ss, completedStr, ';');
-                bool completed = (completedStr == "1");
-
-                if (getline(ss, category, ';'))
-                {
-                    TaskBase *t = new CategorizedTask(title, deadline, category, completed);
-                    if (isDone)
-                        completedTasks.push_back(t);
-                    else
-                        addTask(t);
-                }
-                else
-                {
-                    TaskBase *t = new Task(title, deadline, completed);
-                    if (isDone)
-                        completedTasks.push_back(t);
-                    else
-                        addTask(t);
-                }
-            }
-        }
-    };
-
-} // namespace todo
-
-int main()
-{
-    using namespace todo;
-    TaskManager manager;
-    manager.loadFromFile("tasks.txt"); // Load saved tasks from file
-
-    int choice;
-    do
-    {
-        // Display menu
-        std::cout << "\n--- To-Do List Main Menu ---\n";
-        std::cout << "1. Add Task\n2. View Tasks\n3. View Tasks Sorted by Deadline\n4. Mark Task Completed\n5. Delete Task\n6. View Completed\n7. Search Tasks\n8. Filter by Category\n9. List Categories\n0. Exit\nChoice: ";
-        std::cin >> choice;
-        std::cin.ignore();
-
-        if (choice == 1) // Add task
-        {
-            std::string title, deadline, category;
-            std::cout << "Enter title: ";
-            getline(std::cin, title);
-            std::cout << "Enter deadline (DD.MM.YYYY): ";
-            getline(std::cin, deadline);
-            std::cout << "Enter category (leave empty for none): ";
-            getline(std::cin, category);
-            if (category.empty())
-                manager.addTask(new Task(title, deadline));
-            else
-                manager.addTask(new CategorizedTask(title, deadline, category));
-        }
-        else if (choice == 2) // View tasks
-        {
-            manager.viewTasks(false);
-        }
-        else if (choice == 3) // View sorted by deadline
-        {
-            manager.viewTasks(true);
-        }
-        else if (choice == 4) // Mark task completed
-        {
-            std::string title;
-            std::cout << "Enter title to mark completed: ";
-            getline(std::cin, title);
-            manager.markCompleted(title);
-        }
-        else if (choice == 5) // Delete task
-        {
-            std::string title;
-            std::cout << "Enter title to delete: ";
-            getline(std::cin, title);
-            manager.deleteTask(title);
-        }
-        else if (choice == 6) // View completed
-        {
-            manager.viewCompleted();
-        }
-        else if (choice == 7) // Search
-        {
-            std::string query;
-            std::cout << "Enter title keyword to search: ";
-            getline(std::cin, query);
-            manager.searchTask(query);
-        }
-        else if (choice == 8) // Filter by category
-        {
-            std::string category;
-            manager.listAllCategories();
-            std::cout << "Enter category to filter by: ";
-            getline(std::cin, category);
-            manager.filterByCategory(category);
-        }
-        else if (choice == 9) // Show saved categories
-        {
-            manager.listAllCategories();
-        }
-
-    } while (choice != 0);
-
-    manager.saveToFile("tasks.txt"); // Save tasks before exit
-    return 0;
-}
+#include <iostream>
+#include <string>
+#include <fstream>
+#include <chrono>
+#include <memory>
+#include <cstdio>
+#include "task_manager.h"
+#include "batch.h"
+#include "oneshot.h"
+#include "csv_import.h"
+#include "ical_import.h"
+#include "task_diff.h"
+#include "time_travel.h"
+#include "metrics_server.h"
+#include "reminders.h"
+
+// Latency histograms (and allocation counts when tracked) go to stderr when
+// the program ends, if anything was timed
+static void dumpStats(const todo::TaskManager &manager)
+{
+    if (manager.operationStats().empty())
+        return;
+    todo::OutputBuffer err(2);
+    manager.operationStats().report(err);
+    if (todo::allocTrackingCompiledIn)
+        todo::AllocTracker::report(err);
+}
+
+// Open hardware counters for the stats table, or say why there are none
+static std::unique_ptr<todo::PerfCounters> openPerfCounters()
+{
+    std::unique_ptr<todo::PerfCounters> counters(new todo::PerfCounters());
+    if (counters->available())
+        return counters;
+    std::cerr << "Hardware counters unavailable: " << counters->why() << "\n";
+    return nullptr;
+}
+
+// Apply a script of commands with one load and one save
+static int runBatch(const std::string &script, const todo::PerfCounters *counters)
+{
+    using namespace todo;
+    std::ifstream file;
+    if (script != "-")
+    {
+        file.open(script);
+        if (!file)
+        {
+            std::cerr << "Could not open " << script << "\n";
+            return 1;
+        }
+    }
+
+    TaskManager manager;
+    manager.attachPerfCounters(counters);
+    manager.loadFromFile("tasks.txt");
+    manager.enableJournal();
+    BatchResult result;
+    {
+        OutputBuffer out;
+        BatchRunner runner(manager, out);
+        result = runner.run(script == "-" ? std::cin : file);
+        out.append(std::to_string(result.commands) + " commands, " + std::to_string(result.failures) + " failed\n");
+    }
+    manager.saveToFile("tasks.txt");
+    dumpStats(manager);
+    return result.failures == 0 ? 0 : 1;
+}
+
+// Print what an import did, including the first rejected entries
+static void reportImport(const todo::ImportResult &result)
+{
+    std::cout << "Imported " << result.imported << " tasks, rejected " << result.rejected << " entries";
+    if (result.skipped > 0)
+        std::cout << ", skipped " << result.skipped << " already there";
+    std::cout << "\n";
+    for (const auto &error : result.errors)
+        std::cout << "  " << error << "\n";
+}
+
+// import-csv <file> [--map field=column,...] [--delimiter c] [--no-header]
+static int runImportCsv(int argc, char *argv[])
+{
+    using namespace todo;
+    if (argc < 1)
+    {
+        std::cerr << "usage: import-csv <file> [--map title=Name,deadline=Due,category=List] [--delimiter c] [--no-header]\n";
+        return 2;
+    }
+    CsvImportOptions options;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "--no-header")
+            options.header = false;
+        else if (arg == "--map" && i + 1 < argc && options.setMapping(argv[i + 1]))
+            ++i;
+        else if (arg == "--delimiter" && i + 1 < argc && std::string(argv[i + 1]).size() == 1)
+            options.delimiter = argv[++i][0];
+        else
+        {
+            std::cerr << "Bad import option: " << arg << "\n";
+            return 2;
+        }
+    }
+
+    TaskManager manager;
+    manager.loadFromFile("tasks.txt");
+    manager.enableJournal();
+    ImportResult result = CsvImporter(options).run(argv[0], manager);
+    if (!result.opened)
+    {
+        std::cerr << "Could not open " << argv[0] << "\n";
+        return 1;
+    }
+    reportImport(result);
+    manager.saveToFile("tasks.txt");
+    return 0;
+}
+
+// export-json <file> [--ndjson]: write every task as JSON, like menu option 11
+static int runExportJson(int argc, char *argv[])
+{
+    bool ndjson = argc == 2 && std::string(argv[1]) == "--ndjson";
+    if (argc < 1 || (argc > 1 && !ndjson))
+    {
+        std::cerr << "usage: export-json <file> [--ndjson]\n";
+        return 2;
+    }
+    todo::TaskManager manager;
+    manager.loadFromFile("tasks.txt");
+    if (!manager.exportJson(argv[0], ndjson))
+    {
+        std::cerr << "Could not write " << argv[0] << "\n";
+        return 1;
+    }
+    return 0;
+}
+
+// export-ics <file>: write all tasks as iCalendar VTODOs
+static int runExportIcs(int argc, char *argv[])
+{
+    if (argc < 1)
+    {
+        std::cerr << "usage: export-ics <file>\n";
+        return 2;
+    }
+    todo::TaskManager manager;
+    manager.loadFromFile("tasks.txt");
+    if (!manager.exportIcal(argv[0]))
+    {
+        std::cerr << "Could not write " << argv[0] << "\n";
+        return 1;
+    }
+    return 0;
+}
+
+// import-ics <file>: add the VTODOs of an iCalendar file
+static int runImportIcs(int argc, char *argv[])
+{
+    using namespace todo;
+    if (argc < 1)
+    {
+        std::cerr << "usage: import-ics <file>\n";
+        return 2;
+    }
+    TaskManager manager;
+    manager.loadFromFile("tasks.txt");
+    manager.enableJournal();
+    ImportResult result = IcalImporter().run(argv[0], manager);
+    if (!result.opened)
+    {
+        std::cerr << "Could not open " << argv[0] << "\n";
+        return 1;
+    }
+    reportImport(result);
+    manager.saveToFile("tasks.txt");
+    return 0;
+}
+
+// diff <before> <after>: what changed between two task files
+static int runDiff(int argc, char *argv[])
+{
+    using namespace todo;
+    if (argc != 2)
+    {
+        std::cerr << "usage: diff <before> <after>\n";
+        return 2;
+    }
+    TaskFileSnapshot before, after;
+    for (int i = 0; i < 2; ++i)
+    {
+        if (!(i == 0 ? before : after).load(argv[i]))
+        {
+            std::cerr << "Could not open " << argv[i] << "\n";
+            return 1;
+        }
+    }
+    OutputBuffer out;
+    TaskDiff::Summary s = TaskDiff::diff(before, after, out);
+    out.append(std::to_string(s.added) + " added, " + std::to_string(s.deleted) + " deleted, " +
+               std::to_string(s.completed) + " completed, " + std::to_string(s.reopened) + " reopened, " +
+               std::to_string(s.changed) + " changed, " + std::to_string(s.unchanged) + " unchanged\n");
+    return s.added + s.deleted + s.completed + s.reopened + s.changed == 0 ? 0 : 1;
+}
+
+// merge <ours> <theirs> [--base <file>] [-o <out>]: combine two copies of a task file
+static int runMerge(int argc, char *argv[])
+{
+    using namespace todo;
+    std::vector<std::string> inputs;
+    std::string baseFile, outFile;
+    for (int i = 0; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "--base" && i + 1 < argc)
+            baseFile = argv[++i];
+        else if (arg == "-o" && i + 1 < argc)
+            outFile = argv[++i];
+        else
+            inputs.push_back(arg);
+    }
+    if (inputs.size() != 2)
+    {
+        std::cerr << "usage: merge <ours> <theirs> [--base <file>] [-o <out>]\n";
+        return 2;
+    }
+
+    TaskFileSnapshot ours, theirs, base;
+    if (!ours.load(inputs[0]) || !theirs.load(inputs[1]) || (!baseFile.empty() && !base.load(baseFile)))
+    {
+        std::cerr << "Could not read the input files\n";
+        return 1;
+    }
+    OutputBuffer out = outFile.empty() ? OutputBuffer() : OutputBuffer(outFile);
+    if (!out.isOpen())
+    {
+        std::cerr << "Could not write " << outFile << "\n";
+        return 1;
+    }
+    TaskDiff::merge(ours, theirs, baseFile.empty() ? nullptr : &base, out);
+    out.flush();
+    return out.hasFailed() ? 1 : 0;
+}
+
+// Print where the time went between entering main() and the first menu
+static void reportStartup(const todo::LoadTimings &load, std::chrono::steady_clock::time_point start,
+                          std::chrono::steady_clock::time_point loaded, std::chrono::steady_clock::time_point shown)
+{
+    auto ms = [](std::chrono::steady_clock::duration d)
+    { return std::chrono::duration<double, std::milli>(d).count(); };
+    char text[512];
+    std::snprintf(text, sizeof(text),
+                  "startup: tasks.txt, %zu lines, %.1f KiB\n"
+                  "  file open     %10.3f ms\n"
+                  "  read          %10.3f ms\n"
+                  "  parse         %10.3f ms\n"
+                  "  construct     %10.3f ms\n"
+                  "  index build   %10.3f ms\n"
+                  "  first render  %10.3f ms\n"
+                  "  total         %10.3f ms (from entering main, includes %.3f ms elsewhere)\n",
+                  load.lines, load.bytes / 1024.0, ms(load.open), ms(load.read), ms(load.parse),
+                  ms(load.construct), ms(load.index), ms(shown - loaded), ms(shown - start),
+                  ms(shown - start) - ms(load.open + load.read + load.parse + load.construct + load.index) -
+                      ms(shown - loaded));
+    std::cerr << text;
+}
+
+int main(int argc, char *argv[])
+{
+    using namespace todo;
+    auto started = std::chrono::steady_clock::now();
+
+    // --trace <file>, --startup-report, --perf-counters, --metrics-file <file>
+    // and --metrics-socket <path> may come before any command
+    std::string traceFile, metricsFile, metricsSocket;
+    bool startupReport = false;
+    std::unique_ptr<PerfCounters> perfCounters;
+    while (argc > 1)
+    {
+        std::string option = argv[1];
+        int used;
+        if (option == "--trace" && argc > 2)
+        {
+            traceFile = argv[2];
+            used = 2;
+            if (!tracingCompiledIn)
+                std::cerr << "Tracing is not compiled in; build with -DTODO_ENABLE_TRACING (make main-trace)\n";
+        }
+        else if (option == "--startup-report")
+        {
+            startupReport = true;
+            used = 1;
+        }
+        else if (option == "--perf-counters")
+        {
+            perfCounters = openPerfCounters();
+            used = 1;
+        }
+        else if (option == "--metrics-file" && argc > 2)
+        {
+            metricsFile = argv[2];
+            used = 2;
+        }
+        else if (option == "--metrics-socket" && argc > 2)
+        {
+            metricsSocket = argv[2];
+            used = 2;
+        }
+        else
+            break;
+        argv[used] = argv[0];
+        argc -= used;
+        argv += used;
+    }
+    TraceSession trace(tracingCompiledIn ? traceFile : std::string());
+    MetricsFileSession metrics(metricsFile);
+    MetricsServer metricsServer;
+    if (!metricsSocket.empty() && !metricsServer.start(metricsSocket))
+        std::cerr << "Metrics socket unavailable: " << metricsServer.why() << "\n";
+    if (startupReport && argc > 1)
+        std::cerr << "--startup-report only applies to the interactive menu\n";
+
+    if (argc > 1)
+    {
+        std::string command = argv[1];
+        if (command == "--batch")
+            return runBatch(argc > 2 ? argv[2] : "-", perfCounters.get());
+        if (command == "add")
+            return addCommand("tasks.txt", argc - 2, argv + 2);
+        if (command == "next")
+            return nextCommand("tasks.txt", argc - 2, argv + 2);
+        if (command == "agenda")
+            return agendaCommand("tasks.txt", argc - 2, argv + 2);
+        if (command == "ready")
+            return readyCommand("tasks.txt", argc - 2, argv + 2);
+        if (command == "plan")
+            return planCommand("tasks.txt", argc - 2, argv + 2);
+        if (command == "list")
+            return listCommand("tasks.txt", argc - 2, argv + 2);
+        if (command == "search")
+            return searchCommand("tasks.txt", argc - 2, argv + 2);
+        if (command == "import-csv")
+            return runImportCsv(argc - 2, argv + 2);
+        if (command == "diff")
+            return runDiff(argc - 2, argv + 2);
+        if (command == "merge")
+            return runMerge(argc - 2, argv + 2);
+        if (command == "watch")
+            return watchCommand("tasks.txt", argc - 2, argv + 2, &metrics);
+        if (command == "as-of")
+            return asOfCommand("tasks.txt", argc - 2, argv + 2);
+        if (command == "history-gc")
+            return historyGcCommand("tasks.txt", argc - 2, argv + 2);
+        if (command == "export-json")
+            return runExportJson(argc - 2, argv + 2);
+        if (command == "export-ics")
+            return runExportIcs(argc - 2, argv + 2);
+        if (command == "import-ics")
+            return runImportIcs(argc - 2, argv + 2);
+        std::cerr << "Unknown command: " << command << "\n"
+                  << "Usage: main [--trace <file>] [--startup-report] [--perf-counters]\n"
+                  << "            [--metrics-file <file>] [--metrics-socket <path>] [command]\n"
+                  << "Commands:   --batch <file|-> | add <title> <deadline> [category] [--every <rule>]\n"
+                  << "            next [count] | agenda [<from> [<to>]] | ready | plan\n"
+                  << "            list [--done|--all] [--fields f,...] [--json] | search <keyword> [--fields f,...] [--json]\n"
+                  << "            import-csv <file> [--map field=column,...] [--delimiter c] [--no-header]\n"
+                  << "            export-json <file> [--ndjson] | export-ics <file> | import-ics <file>\n"
+                  << "            diff <before> <after> | merge <ours> <theirs> [--base <file>] [-o <out>]\n"
+                  << "            as-of <when> view [sorted]|search <keyword>|filter <category>|completed\n"
+                  << "            history-gc [days] | watch [--remind 1d,1h,...] [--due-time HH:MM]\n";
+        return 2;
+    }
+
+    TaskManager manager;
+    manager.attachPerfCounters(perfCounters.get());
+    LoadTimings loadTimings;
+    manager.loadFromFile("tasks.txt", startupReport ? &loadTimings : nullptr); // Load saved tasks from file
+    manager.enableJournal();
+    auto loaded = std::chrono::steady_clock::now();
+
+    int choice;
+    do
+    {
+        // Display menu
+        std::cout << "\n--- To-Do List Main Menu ---\n";
+        std::cout << "1. Add Task\n2. View Tasks\n3. View Tasks Sorted by Deadline\n4. Mark Task Completed\n5. Delete Task\n6. View Completed\n7. Search Tasks\n8. Filter by Category\n9. List Categories\n10. Browse Tasks (paged)\n11. Export Tasks (JSON/NDJSON)\n12. Import Tasks from CSV\n13. Export to iCalendar\n14. Import from iCalendar\n15. Show Operation Stats\n16. Undo\n17. Redo\n18. Agenda\n19. Add Dependency\n20. Remove Dependency\n21. Ready Tasks\n22. Dependency Order\n0. Exit\nChoice: ";
+        if (startupReport)
+        {
+            std::cout.flush();
+            reportStartup(loadTimings, started, loaded, std::chrono::steady_clock::now());
+            startupReport = false;
+        }
+        std::cin >> choice;
+        std::cin.ignore();
+
+        if (choice == 1) // Add task
+        {
+            std::string title, deadline, category, repeat;
+            std::cout << "Enter title: ";
+            getline(std::cin, title);
+            std::cout << "Enter deadline (DD.MM.YYYY): ";
+            getline(std::cin, deadline);
+            std::cout << "Enter category (leave empty for none): ";
+            getline(std::cin, category);
+            std::cout << "Repeat (daily, weekly, monthly, yearly, or e.g. 2w; leave empty for none): ";
+            getline(std::cin, repeat);
+            RecurrenceRule rule;
+            if (!repeat.empty())
+            {
+                if (rule.parse(repeat, deadline))
+                    manager.addTask(new RecurringTask(title, deadline, category, rule));
+                else
+                    std::cout << "Cannot repeat \"" << repeat << "\" from \"" << deadline << "\"\n";
+            }
+            else if (category.empty())
+                manager.addTask(new Task(title, deadline));
+            else
+                manager.addTask(new CategorizedTask(title, deadline, category));
+        }
+        else if (choice == 2) // View tasks
+        {
+            manager.viewTasks(false);
+        }
+        else if (choice == 3) // View sorted by deadline
+        {
+            manager.viewTasks(true);
+        }
+        else if (choice == 4) // Mark task completed
+        {
+            std::string title;
+            std::cout << "Enter title to mark completed: ";
+            getline(std::cin, title);
+            manager.markCompleted(title);
+        }
+        else if (choice == 5) // Delete task
+        {
+            std::string title;
+            std::cout << "Enter title to delete: ";
+            getline(std::cin, title);
+            manager.deleteTask(title);
+        }
+        else if (choice == 6) // View completed
+        {
+            manager.viewCompleted();
+        }
+        else if (choice == 7) // Search
+        {
+            std::string query;
+            std::cout << "Enter title keyword to search: ";
+            getline(std::cin, query);
+            manager.searchTask(query);
+        }
+        else if (choice == 8) // Filter by category
+        {
+            std::string category;
+            manager.listAllCategories();
+            std::cout << "Enter category to filter by: ";
+            getline(std::cin, category);
+            manager.filterByCategory(category);
+        }
+        else if (choice == 9) // Show saved categories
+        {
+            manager.listAllCategories();
+        }
+        else if (choice == 10) // Page through tasks
+        {
+            std::string answer;
+            std::cout << "Sort by deadline? (y/n): ";
+            getline(std::cin, answer);
+            manager.browseTasks(answer == "y" || answer == "Y");
+        }
+        else if (choice == 11) // Export for other tools
+        {
+            std::string filename, format;
+            std::cout << "Enter export file name: ";
+            getline(std::cin, filename);
+            std::cout << "Format (json/ndjson): ";
+            getline(std::cin, format);
+            if (manager.exportJson(filename, format == "ndjson"))
+                std::cout << "Tasks exported to " << filename << "\n";
+            else
+                std::cout << "Could not write " << filename << "\n";
+        }
+        else if (choice == 12) // Import from CSV with title/deadline/category headers
+        {
+            std::string filename;
+            std::cout << "Enter CSV file name (columns title, deadline, category): ";
+            getline(std::cin, filename);
+            ImportResult result = CsvImporter(CsvImportOptions()).run(filename, manager);
+            if (result.opened)
+                reportImport(result);
+            else
+                std::cout << "Could not open " << filename << "\n";
+        }
+        else if (choice == 13) // Export deadlines for calendar apps
+        {
+            std::string filename;
+            std::cout << "Enter .ics file name: ";
+            getline(std::cin, filename);
+            if (manager.exportIcal(filename))
+                std::cout << "Tasks exported to " << filename << "\n";
+            else
+                std::cout << "Could not write " << filename << "\n";
+        }
+        else if (choice == 14) // Import tasks back from a calendar
+        {
+            std::string filename;
+            std::cout << "Enter .ics file name: ";
+            getline(std::cin, filename);
+            ImportResult result = IcalImporter().run(filename, manager);
+            if (result.opened)
+                reportImport(result);
+            else
+                std::cout << "Could not open " << filename << "\n";
+        }
+        else if (choice == 15) // Latency of everything done so far
+        {
+            OutputBuffer out;
+            manager.operationStats().report(out);
+            if (allocTrackingCompiledIn)
+                AllocTracker::report(out);
+        }
+        else if (choice == 16 || choice == 17) // Take back or repeat the last change
+        {
+            std::string what;
+            if (choice == 16 ? manager.undo(&what) : manager.redo(&what))
+                std::cout << (choice == 16 ? "Undone: " : "Redone: ") << what << "\n";
+            else
+                std::cout << (choice == 16 ? "Nothing to undo\n" : "Nothing to redo\n");
+        }
+        else if (choice == 18) // What falls due over the next days, recurring tasks included
+        {
+            std::string from, to;
+            std::cout << "From (DD.MM.YYYY, leave empty for today): ";
+            getline(std::cin, from);
+            std::cout << "To (leave empty for two weeks): ";
+            getline(std::cin, to);
+            Date first, last;
+            if (parseAgendaWindow(from, to, first, last))
+            {
+                OutputBuffer out;
+                manager.agenda(first, last, out);
+            }
+            else
+                std::cout << "Not a date range: " << from << " " << to << "\n";
+        }
+        else if (choice == 19 || choice == 20) // One task has to wait for another, or no longer
+        {
+            std::string task, prerequisite;
+            std::cout << "Enter title of the task that waits: ";
+            getline(std::cin, task);
+            std::cout << "Enter title of the task it waits for: ";
+            getline(std::cin, prerequisite);
+            std::vector<std::string> cycle;
+            if (choice == 20)
+            {
+                if (!manager.removeDependency(task, prerequisite))
+                    std::cout << "\"" << task << "\" does not wait for \"" << prerequisite << "\"\n";
+            }
+            else if (manager.addDependency(task, prerequisite, &cycle))
+                std::cout << "\"" << task << "\" now waits for \"" << prerequisite << "\"\n";
+            else if (cycle.size() == 1)
+                std::cout << "A task cannot wait for itself\n";
+            else if (cycle.empty())
+                std::cout << "Both tasks must be active tasks\n";
+            else
+            {
+                std::cout << "Not added, \"" << prerequisite << "\" already waits for \"" << task << "\":";
+                for (std::size_t i = 0; i < cycle.size(); ++i)
+                    std::cout << (i == 0 ? " " : " -> ") << cycle[i];
+                std::cout << "\n";
+            }
+        }
+        else if (choice == 21) // What can be started now
+        {
+            OutputBuffer out;
+            manager.viewReady(out);
+        }
+        else if (choice == 22) // Linked tasks, each after what it waits for
+        {
+            OutputBuffer out;
+            manager.viewPlan(out);
+        }
+        metrics.flush();
+
+    } while (choice != 0);
+
+    manager.saveToFile("tasks.txt"); // Save tasks before exit
+    dumpStats(manager);
+    return 0;
+}
@@ -0,0 +1,241 @@
+#ifndef TODO_METRICS_H
+#define TODO_METRICS_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "output_buffer.h"
+
+namespace todo
+{
+
+    // Process-wide counters and gauges for a metrics scraper, written out in the
+    // Prometheus text format. Counters are sharded per thread: every thread bumps
+    // cells in its own cache-line-aligned block with a plain relaxed store, so an
+    // increment never waits on another thread or drags a shared line between
+    // cores. A scrape adds the blocks up. Gauges hold one value each on a line
+    // of their own, set by whoever owns the measured thing
+    class MetricsRegistry
+    {
+    public:
+        static constexpr int maxMetrics = 64;
+
+        class Counter
+        {
+        private:
+            int slot = -1;
+
+        public:
+            Counter() = default;
+            explicit Counter(int s) : slot(s) {}
+
+            void add(std::uint64_t n = 1) const
+            {
+                if (slot < 0)
+                    return;
+                // Only this thread writes its cell, so load + store is enough
+                std::atomic<std::uint64_t> &cell = MetricsRegistry::instance().localShard().cells[slot];
+                cell.store(cell.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+            }
+        };
+
+        class Gauge
+        {
+        private:
+            int slot = -1;
+
+        public:
+            Gauge() = default;
+            explicit Gauge(int s) : slot(s) {}
+
+            void set(std::int64_t value) const
+            {
+                if (slot >= 0)
+                    MetricsRegistry::instance().gauges[slot].value.store(value, std::memory_order_relaxed);
+            }
+        };
+
+    private:
+        struct alignas(64) Shard
+        {
+            std::atomic<std::uint64_t> cells[maxMetrics] = {};
+        };
+
+        struct alignas(64) GaugeCell
+        {
+            std::atomic<std::int64_t> value{0};
+        };
+
+        struct Descriptor
+        {
+            std::string name;   // Metric family, e.g. todo_operations_total
+            std::string labels; // Rendered label set without braces, may be empty
+            std::string help;
+            bool counter;
+            int slot;
+        };
+
+        std::mutex lock; // Guards registration and the shard list, never the increments
+        std::vector<Descriptor> descriptors;
+        std::vector<std::unique_ptr<Shard>> shards; // Kept after their thread exits, so totals never drop
+        GaugeCell gauges[maxMetrics];
+        int counterSlots = 0;
+        int gaugeSlots = 0;
+        std::chrono::steady_clock::time_point started = std::chrono::steady_clock::now();
+
+        Shard &localShard()
+        {
+            thread_local Shard *shard = nullptr;
+            if (!shard)
+            {
+                std::lock_guard<std::mutex> guard(lock);
+                shards.emplace_back(new Shard());
+                shard = shards.back().get();
+            }
+            return *shard;
+        }
+
+        // Slot of an existing series with this name and labels, or a new one;
+        // -1 once the table is full, which makes the handle a no-op
+        int registerSeries(const std::string &name, const std::string &labels, const std::string &help, bool counter)
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            for (const auto &d : descriptors)
+                if (d.name == name && d.labels == labels)
+                    return d.counter == counter ? d.slot : -1;
+            int &used = counter ? counterSlots : gaugeSlots;
+            if (used == maxMetrics)
+                return -1;
+            descriptors.push_back(Descriptor{name, labels, help, counter, used});
+            return used++;
+        }
+
+        std::uint64_t counterValue(int slot) const
+        {
+            std::uint64_t total = 0;
+            for (const auto &shard : shards)
+                total += shard->cells[slot].load(std::memory_order_relaxed);
+            return total;
+        }
+
+        MetricsRegistry() = default;
+
+    public:
+        static MetricsRegistry &instance()
+        {
+            static MetricsRegistry registry;
+            return registry;
+        }
+
+        MetricsRegistry(const MetricsRegistry &) = delete;
+        MetricsRegistry &operator=(const MetricsRegistry &) = delete;
+
+        // Handles are cheap to copy; registering the same name and labels again
+        // returns the same series. labels is a rendered set such as op="add"
+        Counter counter(const std::string &name, const std::string &help, const std::string &labels = std::string())
+        {
+            return Counter(registerSeries(name, labels, help, true));
+        }
+
+        Gauge gauge(const std::string &name, const std::string &help, const std::string &labels = std::string())
+        {
+            return Gauge(registerSeries(name, labels, help, false));
+        }
+
+        // Every series, grouped by family with its HELP and TYPE lines, plus
+        // todo_uptime_seconds so rates can be taken from a single scrape
+        std::string text()
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            std::string out;
+            std::vector<bool> written(descriptors.size(), false);
+            char value[32];
+            for (std::size_t i = 0; i < descriptors.size(); ++i)
+            {
+                if (written[i])
+                    continue;
+                const Descriptor &family = descriptors[i];
+                out += "# HELP " + family.name + " " + family.help + "\n";
+                out += "# TYPE " + family.name + (family.counter ? " counter\n" : " gauge\n");
+                for (std::size_t j = i; j < descriptors.size(); ++j)
+                {
+                    const Descriptor &d = descriptors[j];
+                    if (written[j] || d.name != family.name)
+                        continue;
+                    written[j] = true;
+                    out += d.name;
+                    if (!d.labels.empty())
+                        out += "{" + d.labels + "}";
+                    if (d.counter)
+                        std::snprintf(value, sizeof(value), " %llu\n", static_cast<unsigned long long>(counterValue(d.slot)));
+                    else
+                        std::snprintf(value, sizeof(value), " %lld\n",
+                                      static_cast<long long>(gauges[d.slot].value.load(std::memory_order_relaxed)));
+                    out += value;
+                }
+            }
+            std::snprintf(value, sizeof(value), " %.3f\n",
+                          std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count());
+            out += "# HELP todo_uptime_seconds Seconds since the process started\n"
+                   "# TYPE todo_uptime_seconds gauge\n"
+                   "todo_uptime_seconds";
+            out += value;
+            return out;
+        }
+
+        // Write the exposition to a file through a temporary and a rename, so
+        // a collector reading it (node_exporter's textfile directory) never
+        // sees half a scrape. Returns false if it could not be written
+        bool write(const std::string &filename)
+        {
+            std::string temp = filename + ".tmp";
+            {
+                OutputBuffer out(temp);
+                if (!out.isOpen())
+                    return false;
+                out.append(text());
+                out.flush();
+                if (out.hasFailed())
+                {
+                    std::remove(temp.c_str());
+                    return false;
+                }
+            }
+            if (std::rename(temp.c_str(), filename.c_str()) != 0)
+            {
+                std::remove(temp.c_str());
+                return false;
+            }
+            return true;
+        }
+    };
+
+    // Keeps a metrics file current: written on every flush() and once more
+    // when the session ends. An empty filename turns it off
+    class MetricsFileSession
+    {
+    private:
+        std::string filename;
+
+    public:
+        explicit MetricsFileSession(const std::string &file) : filename(file) {}
+        ~MetricsFileSession() { flush(); }
+
+        MetricsFileSession(const MetricsFileSession &) = delete;
+        MetricsFileSession &operator=(const MetricsFileSession &) = delete;
+
+        void flush() const
+        {
+            if (!filename.empty() && !MetricsRegistry::instance().write(filename))
+                std::fprintf(stderr, "Could not write %s\n", filename.c_str());
+        }
+    };
+
+} // namespace todo
+
+#endif
@@ -0,0 +1,167 @@
+#ifndef TODO_METRICS_SERVER_H
+#define TODO_METRICS_SERVER_H
+
+#include <atomic>
+#include <cstring>
+#include <string>
+#include <thread>
+#include "metrics.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <cerrno>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#define TODO_METRICS_SOCKET 1
+#ifdef MSG_NOSIGNAL
+#define TODO_SEND_FLAGS MSG_NOSIGNAL
+#else
+#define TODO_SEND_FLAGS 0 // SO_NOSIGPIPE is set on each client instead
+#endif
+#endif
+
+namespace todo
+{
+
+    // Serves the metrics registry on a Unix domain socket from a background
+    // thread. A client that sends an HTTP request (curl --unix-socket <path>
+    // http://localhost/metrics, or a Prometheus agent pointed at the socket)
+    // gets an HTTP response; anything else gets the bare exposition text, so
+    // `socat - UNIX-CONNECT:<path>` works too. The thread only reads the
+    // registry and never touches a TaskManager. Systems without Unix sockets
+    // always fail to start, and why() says so
+    class MetricsServer
+    {
+    private:
+        std::string socketPath;
+        std::string reason;
+        std::atomic<bool> stopping{false};
+        std::thread worker;
+        int listener = -1;
+
+#ifdef TODO_METRICS_SOCKET
+        // Wait briefly for a request line, then answer and hang up
+        static void serve(int client)
+        {
+            char request[1024];
+            ssize_t n = 0;
+            pollfd p{client, POLLIN, 0};
+            if (::poll(&p, 1, 200) > 0)
+                n = ::read(client, request, sizeof(request));
+            std::string body = MetricsRegistry::instance().text();
+            std::string reply;
+            // A request line such as "GET /metrics HTTP/1.1" gets an HTTP reply
+            std::string head(request, n > 0 ? static_cast<std::size_t>(n) : 0);
+            if (head.find(" HTTP/") < head.find('\n'))
+                reply = "HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: " +
+                        std::to_string(body.size()) + "\r\nConnection: close\r\n\r\n";
+            reply += body;
+            const char *data = reply.data();
+            std::size_t left = reply.size();
+#ifdef SO_NOSIGPIPE
+            int one = 1;
+            ::setsockopt(client, SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof(one));
+#endif
+            while (left > 0)
+            {
+                // A client that hung up must not take the program down with
+                // SIGPIPE; EPIPE or ECONNRESET just drops it
+                ssize_t written = ::send(client, data, left, TODO_SEND_FLAGS);
+                if (written < 0 && errno == EINTR)
+                    continue;
+                if (written <= 0)
+                    break;
+                data += written;
+                left -= static_cast<std::size_t>(written);
+            }
+            ::close(client);
+        }
+
+        void run()
+        {
+            while (!stopping.load(std::memory_order_relaxed))
+            {
+                // Wake up now and then to notice stop()
+                pollfd p{listener, POLLIN, 0};
+                if (::poll(&p, 1, 100) <= 0)
+                    continue;
+                int client = ::accept(listener, nullptr, nullptr);
+                if (client >= 0)
+                    serve(client);
+            }
+        }
+#endif
+
+    public:
+        MetricsServer() = default;
+        ~MetricsServer() { stop(); }
+
+        MetricsServer(const MetricsServer &) = delete;
+        MetricsServer &operator=(const MetricsServer &) = delete;
+
+        // Listen on path, replacing a stale socket left there. Anything else
+        // at path is left alone and the server does not start; false on failure
+        bool start(const std::string &path)
+        {
+#ifdef TODO_METRICS_SOCKET
+            sockaddr_un address;
+            std::memset(&address, 0, sizeof(address));
+            address.sun_family = AF_UNIX;
+            if (path.empty() || path.size() >= sizeof(address.sun_path))
+            {
+                reason = "socket path is empty or too long";
+                return false;
+            }
+            std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+            struct stat existing;
+            if (::lstat(path.c_str(), &existing) == 0 && !S_ISSOCK(existing.st_mode))
+            {
+                reason = path + " exists and is not a socket";
+                return false;
+            }
+            listener = ::socket(AF_UNIX, SOCK_STREAM, 0);
+            if (listener < 0)
+            {
+                reason = std::string("socket failed: ") + std::strerror(errno);
+                return false;
+            }
+            ::unlink(path.c_str()); // Only ever a socket, checked above
+            if (::bind(listener, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0 ||
+                ::listen(listener, 8) != 0)
+            {
+                reason = std::string("could not listen on ") + path + ": " + std::strerror(errno);
+                ::close(listener);
+                listener = -1;
+                return false;
+            }
+            socketPath = path;
+            worker = std::thread(&MetricsServer::run, this);
+            return true;
+#else
+            (void)path;
+            reason = "metrics sockets need Unix domain sockets";
+            return false;
+#endif
+        }
+
+        const std::string &why() const { return reason; }
+
+        void stop()
+        {
+#ifdef TODO_METRICS_SOCKET
+            if (!worker.joinable())
+                return;
+            stopping.store(true, std::memory_order_relaxed);
+            worker.join();
+            ::close(listener);
+            listener = -1;
+            ::unlink(socketPath.c_str());
+#endif
+        }
+    };
+
+} // namespace todo
+
+#endif
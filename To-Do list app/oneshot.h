@@ -0,0 +1,394 @@
+#ifndef TODO_ONESHOT_H
+#define TODO_ONESHOT_H
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <cstdlib>
+#include <vector>
+#include <algorithm>
+#include <unordered_map>
+#include "task.h"
+#include "task_file.h"
+#include "deadline_index.h"
+#include "dependency_graph.h"
+#include "journal.h"
+#include "row_formatter.h"
+#include "output_buffer.h"
+#include "projection.h"
+
+namespace todo
+{
+
+    // One-shot commands for shell use. Each touches only what it needs
+    // instead of loading the whole task file into a TaskManager
+
+    // Render a raw task file line the same way Task::render does
+    inline void renderRecord(const TaskRecord &record, OutputBuffer &out)
+    {
+        std::string_view repeat;
+        RecurrenceRule rule;
+        if (record.extension("repeat", repeat) && rule.parseField(repeat))
+            RecurringTask::formatRow(out, record.completed(), record.title, record.deadline, record.category, rule.describe());
+        else if (record.categorized())
+            RowFormatter<CategorizedRowLayout>::format(out, record.completed(), record.title, record.deadline, record.category);
+        else
+            RowFormatter<TaskRowLayout>::format(out, record.completed(), record.title, record.deadline);
+    }
+
+    // add <title> <deadline> [category] [--every <rule>]: append one line to the task file
+    inline int addCommand(const std::string &filename, int argc, char *argv[])
+    {
+        std::string repeat;
+        if (argc >= 2 && std::string(argv[argc - 2]) == "--every")
+        {
+            repeat = argv[argc - 1];
+            argc -= 2;
+        }
+        if (argc < 2 || argc > 3)
+        {
+            std::cerr << "usage: add <title> <deadline> [category] [--every <rule>]\n"
+                      << "  rule: daily, weekly, monthly, yearly, or <n>d, <n>w, <n>m, <n>y\n";
+            return 2;
+        }
+        std::string title = argv[0];
+        std::string deadline = argv[1];
+        std::string category = argc > 2 ? argv[2] : "";
+        if (title.find(';') != std::string::npos || category.find(';') != std::string::npos)
+        {
+            std::cerr << "Titles and categories cannot contain ';'\n";
+            return 2;
+        }
+        Date date;
+        if (!parseDate(deadline, date))
+        {
+            std::cerr << "Invalid deadline \"" << deadline << "\"\n"
+                      << "usage: add <title> <deadline> [category] [--every <rule>]\n"
+                      << "  deadline: D.M.YYYY, D/M/YYYY or YYYY-MM-DD\n";
+            return 2;
+        }
+        deadline = formatDeadline(date);
+        RecurrenceRule rule;
+        if (!repeat.empty() && !rule.parse(repeat, deadline))
+        {
+            std::cerr << "Cannot repeat \"" << repeat << "\" from \"" << deadline << "\"\n";
+            return 2;
+        }
+
+        // Make sure the new line does not get glued to an unterminated last line
+        FileIdentity before = FileIdentity::of(filename);
+        bool needsNewline = false;
+        {
+            std::ifstream existing(filename, std::ios::binary | std::ios::ate);
+            if (existing && existing.tellg() > 0)
+            {
+                char last = 0;
+                existing.seekg(-1, std::ios::end);
+                existing.get(last);
+                needsNewline = last != '\n';
+            }
+        }
+
+        std::string line = !repeat.empty()    ? RecurringTask(title, deadline, category, rule).toFileString()
+                           : category.empty() ? Task(title, deadline).toFileString()
+                                              : CategorizedTask(title, deadline, category).toFileString();
+        std::ofstream ofs(filename, std::ios::app);
+        if (needsNewline)
+            ofs << '\n';
+        ofs << line << '\n';
+        ofs.close();
+        if (!ofs || !TaskJournal::append(filename, TaskJournal::Add, line))
+        {
+            std::cerr << "Could not write " << filename << "\n";
+            return 1;
+        }
+        DeadlineIndex::appended(filename, before);
+        return 0;
+    }
+
+    // next [count]: the active tasks with the earliest deadlines, from the deadline index
+    inline int nextCommand(const std::string &filename, int argc, char *argv[])
+    {
+        long count = argc > 0 ? std::atol(argv[0]) : 5;
+        if (count <= 0)
+        {
+            std::cerr << "usage: next [count]\n";
+            return 2;
+        }
+        OutputBuffer out;
+        TaskRecord record;
+        for (const auto &line : DeadlineIndex::earliest(filename, static_cast<std::size_t>(count)))
+        {
+            parseTaskLine(line, record);
+            renderRecord(record, out);
+        }
+        return 0;
+    }
+
+    // agenda [from [to]]: the active tasks due in a window, by date, with each
+    // recurring task once per occurrence. Only the lines that have something in
+    // the window are kept while the file streams past
+    inline int agendaCommand(const std::string &filename, int argc, char *argv[])
+    {
+        Date from, to;
+        if (argc > 2 || !parseAgendaWindow(argc > 0 ? argv[0] : "", argc > 1 ? argv[1] : "", from, to))
+        {
+            std::cerr << "usage: agenda [<from> [<to>]]  (today and the next 13 days by default)\n";
+            return 2;
+        }
+        LineReader reader;
+        if (!reader.open(filename))
+        {
+            std::cerr << "Could not open " << filename << "\n";
+            return 1;
+        }
+        AgendaQueue queue(from, to);
+        std::vector<std::string> lines;
+        std::string_view line, repeat;
+        TaskRecord record;
+        RecurrenceRule rule;
+        Date due;
+        while (reader.next(line))
+        {
+            parseTaskLine(line, record);
+            if (record.done || !parseDate(record.deadline, due))
+                continue;
+            bool repeats = record.extension("repeat", repeat) && rule.parseField(repeat);
+            if (queue.add(lines.size(), due, repeats ? &rule : nullptr))
+                lines.push_back(std::string(line));
+        }
+
+        OutputBuffer out;
+        std::size_t i;
+        while (queue.next(i, due))
+        {
+            parseTaskLine(lines[i], record);
+            if (record.extension("repeat", repeat) && rule.parseField(repeat))
+                RecurringTask::formatRow(out, false, record.title, formatDeadline(due), record.category, rule.describe());
+            else
+                renderRecord(record, out);
+        }
+        return 0;
+    }
+
+    // The dependencies between the active tasks of a task file, read without
+    // building the tasks: one pass keeps the lines with an after= field, a
+    // second the lines of the tasks they name. Edges go in as loadFromFile
+    // puts them in, so both agree on a file that closes a cycle
+    struct FileDependencies
+    {
+        DependencyGraph graph;
+        std::unordered_map<std::string, std::string> lines; // Active tasks in the graph, by title
+
+        bool load(const std::string &filename)
+        {
+            LineReader reader;
+            if (!reader.open(filename))
+                return false;
+            std::string_view line, after;
+            TaskRecord record;
+            std::vector<std::string> prerequisites;
+            std::vector<std::pair<DependencyGraph::Node, DependencyGraph::Node>> edges;
+            while (reader.next(line))
+            {
+                parseTaskLine(line, record);
+                if (record.done || !record.extension("after", after))
+                    continue;
+                std::string title(record.title);
+                DependencyGraph::Node then = graph.node(title);
+                splitTitleList(after, prerequisites);
+                for (const auto &p : prerequisites)
+                    edges.push_back(std::make_pair(graph.node(p), then));
+                lines[title] = std::string(line);
+            }
+            if (edges.empty() || !reader.open(filename))
+                return true;
+            DependencyGraph::Node n;
+            while (reader.next(line))
+            {
+                parseTaskLine(line, record, 1);
+                std::string title(record.title);
+                if (!record.done && graph.find(title, n) && !lines.count(title))
+                    lines[title] = std::string(line);
+            }
+            graph.linkAll(edges);
+            return true;
+        }
+
+        bool active(DependencyGraph::Node n) const { return lines.count(graph.title(n)) > 0; }
+
+        // Whether a task waits for an active task
+        bool waiting(DependencyGraph::Node n) const
+        {
+            for (auto p : graph.prerequisites(n))
+                if (active(p))
+                    return true;
+            return false;
+        }
+    };
+
+    // ready: the active tasks that wait for no active task, in file order
+    inline int readyCommand(const std::string &filename, int argc, char *[])
+    {
+        if (argc > 0)
+        {
+            std::cerr << "usage: ready\n";
+            return 2;
+        }
+        FileDependencies dependencies;
+        LineReader reader;
+        if (!dependencies.load(filename) || !reader.open(filename))
+        {
+            std::cerr << "Could not open " << filename << "\n";
+            return 1;
+        }
+        OutputBuffer out;
+        std::string_view line;
+        TaskRecord record;
+        DependencyGraph::Node n;
+        while (reader.next(line))
+        {
+            parseTaskLine(line, record);
+            if (record.done)
+                continue;
+            if (!dependencies.graph.empty() && dependencies.graph.find(std::string(record.title), n) &&
+                dependencies.waiting(n))
+                continue;
+            renderRecord(record, out);
+        }
+        return 0;
+    }
+
+    // plan: the active tasks that wait for or hold up another active task,
+    // each after everything it waits for
+    inline int planCommand(const std::string &filename, int argc, char *[])
+    {
+        if (argc > 0)
+        {
+            std::cerr << "usage: plan\n";
+            return 2;
+        }
+        FileDependencies dependencies;
+        if (!dependencies.load(filename))
+        {
+            std::cerr << "Could not open " << filename << "\n";
+            return 1;
+        }
+        OutputBuffer out;
+        TaskRecord record;
+        const DependencyGraph &graph = dependencies.graph;
+        graph.forEachInOrder([&](DependencyGraph::Node n)
+                             {
+            if (!dependencies.active(n))
+                return;
+            bool linked = dependencies.waiting(n);
+            for (auto d : graph.dependents(n))
+                linked = linked || dependencies.active(d);
+            if (!linked)
+                return;
+            parseTaskLine(dependencies.lines.find(graph.title(n))->second, record);
+            renderRecord(record, out); });
+        return 0;
+    }
+
+    // Stream the task file and print the lines accepted by `keep`. With a
+    // projection only the selected fields are parsed and printed (tab-separated,
+    // or NDJSON with --json); without one, rows look like the interactive views
+    template <class Filter>
+    int scanCommand(const std::string &filename, const Projection &projection, bool json,
+                    int filterFields, Filter keep)
+    {
+        LineReader reader;
+        if (!reader.open(filename))
+        {
+            std::cerr << "Could not open " << filename << "\n";
+            return 1;
+        }
+        Projection all;
+        all.parse("title,deadline,category,status,repeat"); // The keys of `main export-json`
+        const Projection &shown = projection.empty() && json ? all : projection;
+        int fieldCount = std::max(filterFields, shown.empty() ? 4 : shown.fieldCount());
+
+        OutputBuffer out;
+        std::string_view line;
+        TaskRecord record;
+        while (reader.next(line))
+        {
+            parseTaskLine(line, record, fieldCount);
+            if (!keep(record))
+                continue;
+            if (json)
+                shown.renderJson(record, out);
+            else if (!shown.empty())
+                shown.renderText(record, out);
+            else
+                renderRecord(record, out);
+        }
+        return 0;
+    }
+
+    // Split "--fields a,b" and "--json" off the arguments; false on a bad option
+    inline bool parseOutputOptions(int argc, char *argv[], std::vector<std::string> &rest,
+                                   Projection &projection, bool &json)
+    {
+        json = false;
+        for (int i = 0; i < argc; ++i)
+        {
+            std::string arg = argv[i];
+            if (arg == "--fields")
+            {
+                if (i + 1 >= argc || !projection.parse(argv[++i]))
+                {
+                    std::cerr << "--fields takes a list of title,deadline,completed,category,status,repeat\n";
+                    return false;
+                }
+            }
+            else if (arg == "--json")
+                json = true;
+            else
+                rest.push_back(arg);
+        }
+        return true;
+    }
+
+    // list [--done|--all] [--fields ...] [--json]: active tasks by default
+    inline int listCommand(const std::string &filename, int argc, char *argv[])
+    {
+        std::vector<std::string> rest;
+        Projection projection;
+        bool json;
+        if (!parseOutputOptions(argc, argv, rest, projection, json))
+            return 2;
+        std::string which = rest.empty() ? "" : rest[0];
+        if (rest.size() > 1 || (!which.empty() && which != "--done" && which != "--all"))
+        {
+            std::cerr << "usage: list [--done|--all] [--fields f1,f2,...] [--json]\n";
+            return 2;
+        }
+        bool done = which == "--done";
+        bool all = which == "--all";
+        return scanCommand(filename, projection, json, 0, [&](const TaskRecord &r)
+                           { return all || r.done == done; });
+    }
+
+    // search <keyword> [--fields ...] [--json]: active tasks whose title contains keyword
+    inline int searchCommand(const std::string &filename, int argc, char *argv[])
+    {
+        std::vector<std::string> rest;
+        Projection projection;
+        bool json;
+        if (!parseOutputOptions(argc, argv, rest, projection, json))
+            return 2;
+        if (rest.size() != 1)
+        {
+            std::cerr << "usage: search <keyword> [--fields f1,f2,...] [--json]\n";
+            return 2;
+        }
+        const std::string &keyword = rest[0];
+        return scanCommand(filename, projection, json, 1, [&](const TaskRecord &r)
+                           { return !r.done && r.title.find(keyword) != std::string_view::npos; });
+    }
+
+} // namespace todo
+
+#endif
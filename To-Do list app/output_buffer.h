@@ -0,0 +1,175 @@
+#ifndef TODO_OUTPUT_BUFFER_H
+#define TODO_OUTPUT_BUFFER_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cstring>
+#include <cstddef>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+namespace todo
+{
+
+    // Output buffer that collects formatted rows and hands them to the OS in
+    // a few large write() calls instead of flushing after every line
+    class OutputBuffer
+    {
+    public:
+        static constexpr std::size_t defaultCapacity = 1 << 16;
+
+    private:
+        int fd;
+        bool ownsFd;
+        bool failed;
+        std::vector<char> buffer;
+        std::size_t used;
+
+        // Write a whole block to the file descriptor, retrying short writes
+        void writeAll(const char *data, std::size_t size)
+        {
+            // Anything already sent through std::cout has to reach the
+            // terminal before our rows do
+            if (fd == 1)
+                std::cout.flush();
+            while (size > 0)
+            {
+#ifdef _WIN32
+                int n = _write(fd, data, static_cast<unsigned int>(size));
+#else
+                ssize_t n = ::write(fd, data, size);
+                if (n < 0 && errno == EINTR)
+                    continue;
+#endif
+                if (n <= 0)
+                {
+                    failed = true; // Nothing sensible to do if the output is gone
+                    return;
+                }
+                data += n;
+                size -= static_cast<std::size_t>(n);
+            }
+        }
+
+    public:
+        explicit OutputBuffer(int fileDescriptor = 1, std::size_t capacity = defaultCapacity)
+            : fd(fileDescriptor), ownsFd(false), failed(false), buffer(capacity), used(0) {}
+
+        // Write to a file instead, creating or truncating it; check isOpen()
+        explicit OutputBuffer(const std::string &filename, std::size_t capacity = defaultCapacity)
+            : fd(-1), ownsFd(true), failed(false), buffer(capacity), used(0)
+        {
+#ifdef _WIN32
+            fd = _open(filename.c_str(), _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY, _S_IREAD | _S_IWRITE);
+#else
+            fd = ::open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+#endif
+        }
+
+        // Whatever is left is written out when the buffer goes away
+        ~OutputBuffer()
+        {
+            flush();
+            if (ownsFd && fd >= 0)
+            {
+#ifdef _WIN32
+                _close(fd);
+#else
+                ::close(fd);
+#endif
+            }
+        }
+
+        bool isOpen() const { return fd >= 0; }
+
+        // True once a write to the descriptor has failed
+        bool hasFailed() const { return failed; }
+
+        OutputBuffer(const OutputBuffer &) = delete;
+        OutputBuffer &operator=(const OutputBuffer &) = delete;
+
+        // Get room for at least n bytes; the caller fills them and calls commit()
+        char *reserve(std::size_t n)
+        {
+            if (n > buffer.size() - used)
+            {
+                flush();
+                if (n > buffer.size())
+                    buffer.resize(n);
+            }
+            return buffer.data() + used;
+        }
+
+        void commit(std::size_t n) { used += n; }
+
+        void append(const char *data, std::size_t size)
+        {
+            if (size > buffer.size() - used)
+            {
+                flush();
+                // Blocks bigger than the whole buffer go straight out
+                if (size >= buffer.size())
+                {
+                    writeAll(data, size);
+                    return;
+                }
+            }
+            std::memcpy(buffer.data() + used, data, size);
+            used += size;
+        }
+
+        void append(const std::string &s) { append(s.data(), s.size()); }
+
+        void append(char c)
+        {
+            if (used == buffer.size())
+                flush();
+            buffer[used++] = c;
+        }
+
+        // Append n copies of c
+        void fill(char c, std::size_t n)
+        {
+            while (n > 0)
+            {
+                if (used == buffer.size())
+                    flush();
+                std::size_t chunk = std::min(n, buffer.size() - used);
+                std::memset(buffer.data() + used, c, chunk);
+                used += chunk;
+                n -= chunk;
+            }
+        }
+
+        // Same result as std::left << std::setw(width) << s
+        void appendPadded(const std::string &s, std::size_t width)
+        {
+            append(s);
+            if (s.size() < width)
+                fill(' ', width - s.size());
+        }
+
+        // Hand everything collected so far to the OS
+        void flush()
+        {
+            if (used > 0)
+            {
+                writeAll(buffer.data(), used);
+                used = 0;
+            }
+        }
+    };
+
+} // namespace todo
+
+#endif
@@ -0,0 +1,127 @@
+#ifndef TODO_PAGER_H
+#define TODO_PAGER_H
+
+#include <iostream>
+#include <string>
+#include <algorithm>
+#include <cstdlib>
+#include <cstddef>
+#include "output_buffer.h"
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#include <sys/ioctl.h>
+#endif
+
+namespace todo
+{
+
+    // Rows the pager can show. Rows are rendered on request, so a source only
+    // has to know how many rows it has and how to format one of them
+    class PagerSource
+    {
+    public:
+        virtual std::size_t size() const = 0;
+        virtual void renderRow(std::size_t index, OutputBuffer &out) const = 0;
+        virtual ~PagerSource() {}
+    };
+
+    // Interactive pager that renders only the visible window of a source.
+    // Work per page depends on the page height, not on the size of the list
+    class Pager
+    {
+    private:
+        const PagerSource &source;
+        std::size_t pageHeight;
+        bool clearScreen;
+
+        // Rows that fit in the terminal, leaving room for the header and prompt
+        static std::size_t terminalRows()
+        {
+#ifndef _WIN32
+            struct winsize ws;
+            if (ioctl(1, TIOCGWINSZ, &ws) == 0 && ws.ws_row > 5)
+                return ws.ws_row - 3;
+#endif
+            return 20;
+        }
+
+        static bool stdoutIsTerminal()
+        {
+#ifdef _WIN32
+            return _isatty(1) != 0;
+#else
+            return isatty(1) != 0;
+#endif
+        }
+
+    public:
+        explicit Pager(const PagerSource &src, std::size_t height = 0)
+            : source(src), pageHeight(height ? height : terminalRows()), clearScreen(stdoutIsTerminal()) {}
+
+        std::size_t pageCount() const
+        {
+            std::size_t n = source.size();
+            return n == 0 ? 1 : (n + pageHeight - 1) / pageHeight;
+        }
+
+        // Render a single page into the buffer
+        void renderPage(std::size_t page, OutputBuffer &out) const
+        {
+            std::size_t total = source.size();
+            std::size_t first = page * pageHeight;
+            std::size_t last = std::min(total, first + pageHeight);
+
+            if (clearScreen)
+                out.append("\x1b[H\x1b[2J", 7);
+            std::string header = total == 0
+                                     ? std::string("No tasks to show\n")
+                                     : "Tasks " + std::to_string(first + 1) + "-" + std::to_string(last) +
+                                           " of " + std::to_string(total) +
+                                           " (page " + std::to_string(page + 1) + "/" + std::to_string(pageCount()) + ")\n";
+            out.append(header);
+            for (std::size_t i = first; i < last; ++i)
+                source.renderRow(i, out);
+        }
+
+        // Read paging commands until the user quits or input runs out
+        void run(std::istream &in = std::cin)
+        {
+            std::size_t page = 0;
+            std::string command;
+            while (true)
+            {
+                {
+                    OutputBuffer out;
+                    renderPage(page, out);
+                    out.append(std::string("[Enter/n] next  [p] prev  [f] first  [l] last  [number] go to page  [q] quit: "));
+                }
+
+                if (!getline(in, command) || command == "q")
+                    break;
+
+                std::size_t pages = pageCount();
+                if (command.empty() || command == "n")
+                    page = std::min(page + 1, pages - 1);
+                else if (command == "p")
+                    page = page > 0 ? page - 1 : 0;
+                else if (command == "f")
+                    page = 0;
+                else if (command == "l")
+                    page = pages - 1;
+                else
+                {
+                    long requested = std::atol(command.c_str());
+                    if (requested >= 1)
+                        page = std::min(static_cast<std::size_t>(requested), pages) - 1;
+                }
+            }
+            std::cout << "\n";
+        }
+    };
+
+} // namespace todo
+
+#endif
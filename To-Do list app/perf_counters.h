@@ -0,0 +1,165 @@
+#ifndef TODO_PERF_COUNTERS_H
+#define TODO_PERF_COUNTERS_H
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#ifdef __linux__
+#include <cerrno>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace todo
+{
+
+    // Hardware event counts over some stretch of code. A count is -1 when that
+    // counter could not be opened
+    struct PerfSample
+    {
+        enum Event
+        {
+            Cycles,
+            Instructions,
+            CacheMisses,
+            BranchMisses,
+            EventCount
+        };
+
+        std::int64_t counts[EventCount] = {-1, -1, -1, -1};
+
+        bool has(Event e) const { return counts[e] >= 0; }
+
+        bool any() const
+        {
+            for (std::int64_t c : counts)
+                if (c >= 0)
+                    return true;
+            return false;
+        }
+
+        // Add the counts of other wherever this sample has that counter
+        void add(const PerfSample &other)
+        {
+            for (int i = 0; i < EventCount; ++i)
+                if (other.counts[i] >= 0)
+                    counts[i] = (counts[i] < 0 ? 0 : counts[i]) + other.counts[i];
+        }
+
+        static const char *name(Event e)
+        {
+            static const char *names[EventCount] = {"cycles", "instructions", "cache_misses", "branch_misses"};
+            return names[e];
+        }
+    };
+
+    // Cycles, instructions, cache misses and branch misses of the calling thread
+    // in user space, through Linux perf_event_open. Each counter is opened on its
+    // own, so a machine without some of them (a VM, a locked-down container,
+    // perf_event_paranoid) still gets the rest; with none at all available() is
+    // false and why() says what went wrong. Other systems always report unavailable
+    class PerfCounters
+    {
+    private:
+        int fds[PerfSample::EventCount] = {-1, -1, -1, -1};
+        std::string reason;
+
+#ifdef __linux__
+        static int open(std::uint64_t config)
+        {
+            perf_event_attr attr;
+            std::memset(&attr, 0, sizeof(attr));
+            attr.size = sizeof(attr);
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = config;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+            return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+        }
+
+        // Running count, scaled up when the kernel multiplexed the counter
+        static std::int64_t readCounter(int fd)
+        {
+            std::uint64_t values[3];
+            if (fd < 0 || ::read(fd, values, sizeof(values)) != static_cast<ssize_t>(sizeof(values)))
+                return -1;
+            if (values[2] == 0)
+                return 0;
+            if (values[2] < values[1])
+                return static_cast<std::int64_t>(static_cast<double>(values[0]) * values[1] / values[2]);
+            return static_cast<std::int64_t>(values[0]);
+        }
+#endif
+
+    public:
+        PerfCounters()
+        {
+#ifdef __linux__
+            static const std::uint64_t configs[PerfSample::EventCount] = {
+                PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+                PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES};
+            int error = 0;
+            for (int i = 0; i < PerfSample::EventCount; ++i)
+            {
+                fds[i] = open(configs[i]);
+                if (fds[i] < 0)
+                    error = errno;
+            }
+            if (!available())
+                reason = std::string("perf_event_open failed: ") + std::strerror(error) +
+                         (error == EACCES || error == EPERM ? " (see /proc/sys/kernel/perf_event_paranoid)" : "");
+#else
+            reason = "hardware counters need Linux perf_event_open";
+#endif
+        }
+
+        ~PerfCounters()
+        {
+#ifdef __linux__
+            for (int fd : fds)
+                if (fd >= 0)
+                    ::close(fd);
+#endif
+        }
+
+        PerfCounters(const PerfCounters &) = delete;
+        PerfCounters &operator=(const PerfCounters &) = delete;
+
+        bool available() const
+        {
+            for (int fd : fds)
+                if (fd >= 0)
+                    return true;
+            return false;
+        }
+
+        const std::string &why() const { return reason; }
+
+        // Current running totals; subtract two readings to count a stretch of code
+        PerfSample read() const
+        {
+            PerfSample sample;
+#ifdef __linux__
+            for (int i = 0; i < PerfSample::EventCount; ++i)
+                sample.counts[i] = readCounter(fds[i]);
+#endif
+            return sample;
+        }
+
+        static PerfSample difference(const PerfSample &before, const PerfSample &after)
+        {
+            PerfSample d;
+            for (int i = 0; i < PerfSample::EventCount; ++i)
+                if (before.counts[i] >= 0 && after.counts[i] >= 0)
+                    d.counts[i] = after.counts[i] - before.counts[i];
+            return d;
+        }
+    };
+
+} // namespace todo
+
+#endif
@@ -0,0 +1,168 @@
+#ifndef TODO_PROJECTION_H
+#define TODO_PROJECTION_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <algorithm>
+#include <cstring>
+#include "task_file.h"
+#include "output_buffer.h"
+#include "json_writer.h"
+
+namespace todo
+{
+
+    // Task fields that can be selected for output
+    enum class TaskField
+    {
+        Title,
+        Deadline,
+        Completed,
+        Category,
+        Status, // "active" or "completed" list
+        Repeat  // The repeat= field of a recurring task
+    };
+
+    // The fields a command should print, in the order asked for, as given by
+    // --fields title,deadline. Readers ask it how far into a line they have to
+    // parse, so fields nobody asked for are never split out or formatted
+    class Projection
+    {
+    private:
+        std::vector<TaskField> fields;
+
+        // How many ';' separated fields have to be split to reach f
+        static int fieldsNeeded(TaskField f)
+        {
+            switch (f)
+            {
+            case TaskField::Title:
+                return 1;
+            case TaskField::Deadline:
+                return 2;
+            case TaskField::Completed:
+                return 3;
+            case TaskField::Category:
+            case TaskField::Repeat:
+                return 4;
+            default:
+                return 0; // Status only needs the "DONE:" prefix
+            }
+        }
+
+        static const char *name(TaskField f)
+        {
+            static const char *names[] = {"title", "deadline", "completed", "category", "status", "repeat"};
+            return names[static_cast<int>(f)];
+        }
+
+        static std::string_view value(const TaskRecord &record, TaskField f)
+        {
+            switch (f)
+            {
+            case TaskField::Title:
+                return record.title;
+            case TaskField::Deadline:
+                return record.deadline;
+            case TaskField::Completed:
+                return record.completed() ? "1" : "0";
+            case TaskField::Category:
+                return record.category;
+            case TaskField::Repeat:
+            {
+                std::string_view repeat;
+                return record.extension("repeat", repeat) ? repeat : std::string_view();
+            }
+            default:
+                return record.done ? "completed" : "active";
+            }
+        }
+
+    public:
+        // Parse a comma-separated field list; false on an unknown name
+        bool parse(const std::string &list)
+        {
+            fields.clear();
+            std::size_t start = 0;
+            while (start <= list.size())
+            {
+                std::size_t comma = list.find(',', start);
+                std::string item = list.substr(start, comma == std::string::npos ? std::string::npos : comma - start);
+                bool known = false;
+                for (int f = 0; f <= static_cast<int>(TaskField::Repeat); ++f)
+                {
+                    if (item == name(static_cast<TaskField>(f)))
+                    {
+                        fields.push_back(static_cast<TaskField>(f));
+                        known = true;
+                    }
+                }
+                if (!known)
+                    return false;
+                if (comma == std::string::npos)
+                    break;
+                start = comma + 1;
+            }
+            return !fields.empty();
+        }
+
+        bool empty() const { return fields.empty(); }
+
+        // Number of leading fields a line has to be split into for this projection
+        int fieldCount() const
+        {
+            int count = 0;
+            for (TaskField f : fields)
+                count = std::max(count, fieldsNeeded(f));
+            return count;
+        }
+
+        // Selected fields separated by tabs, one task per line
+        void renderText(const TaskRecord &record, OutputBuffer &out) const
+        {
+            for (std::size_t i = 0; i < fields.size(); ++i)
+            {
+                if (i > 0)
+                    out.append('\t');
+                std::string_view v = value(record, fields[i]);
+                out.append(v.data(), v.size());
+            }
+            out.append('\n');
+        }
+
+        // Selected fields as one JSON object per line, with the keys and values
+        // of `main export-json`: completed and status both become its "status", given
+        // once, and category and repeat are null for a task without one
+        void renderJson(const TaskRecord &record, OutputBuffer &out) const
+        {
+            out.append('{');
+            bool first = true, status = false;
+            for (TaskField f : fields)
+            {
+                if (f == TaskField::Completed)
+                    f = TaskField::Status;
+                if (f == TaskField::Status && status)
+                    continue;
+                status = status || f == TaskField::Status;
+                if (!first)
+                    out.append(',');
+                first = false;
+                const char *key = name(f);
+                out.append('"');
+                out.append(key, std::strlen(key));
+                out.append("\":", 2);
+                std::string_view v = value(record, f);
+                bool absent = f == TaskField::Category ? !record.categorized() || v.empty() : f == TaskField::Repeat && v.empty();
+                if (absent)
+                    out.append("null", 4);
+                else
+                    appendJsonString(out, v);
+            }
+            out.append("}\n", 2);
+        }
+    };
+
+} // namespace todo
+
+#endif
@@ -0,0 +1,229 @@
+#ifndef TODO_RECURRENCE_H
+#define TODO_RECURRENCE_H
+
+#include <algorithm>
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "date_utils.h"
+
+namespace todo
+{
+
+    // When a recurring task falls due: start and every `every` days, weeks,
+    // months or years after it. Occurrences are counted from start rather than
+    // from each other, so a series on the 31st comes back to the 31st after a
+    // short month. Saved in a task line as the extension field
+    //
+    //   repeat=<every><d|w|m|y>@<start as DD.MM.YYYY>
+    struct RecurrenceRule
+    {
+        enum Unit
+        {
+            Days,
+            Weeks,
+            Months,
+            Years
+        };
+
+        Unit unit = Weeks;
+        int every = 1;
+        Date start;
+
+    private:
+        static constexpr char unitLetters[] = "dwmy";
+
+        bool readSpan(std::string_view text)
+        {
+            static const char *words[] = {"daily", "weekly", "monthly", "yearly"};
+            for (int u = Days; u <= Years; ++u)
+            {
+                if (text == words[u])
+                {
+                    unit = static_cast<Unit>(u);
+                    every = 1;
+                    return true;
+                }
+            }
+            std::size_t pos = 0;
+            if (!readNumber(text, pos, 3, every) || every == 0 || pos + 1 != text.size())
+                return false;
+            const char *letter = std::char_traits<char>::find(unitLetters, 4, text[pos]);
+            if (!letter)
+                return false;
+            unit = static_cast<Unit>(letter - unitLetters);
+            return true;
+        }
+
+    public:
+        // Read a rule typed by a user: daily, weekly, monthly, yearly, or a
+        // count and a unit such as 2w or 3m. The series starts at firstDeadline
+        bool parse(std::string_view text, std::string_view firstDeadline)
+        {
+            return readSpan(text) && parseDate(firstDeadline, start);
+        }
+
+        // Read the value of a repeat= field
+        bool parseField(std::string_view value)
+        {
+            std::size_t at = value.find('@');
+            return at != std::string_view::npos && readSpan(value.substr(0, at)) &&
+                   parseDate(value.substr(at + 1), start);
+        }
+
+        std::string field() const
+        {
+            return std::to_string(every) + unitLetters[unit] + "@" + formatDeadline(start);
+        }
+
+        // "every week", "every 2 months"
+        std::string describe() const
+        {
+            static const char *names[] = {"day", "week", "month", "year"};
+            if (every == 1)
+                return std::string("every ") + names[unit];
+            return "every " + std::to_string(every) + " " + names[unit] + "s";
+        }
+
+        // The occurrence with the given index, start being 0; false past 9999
+        bool occurrence(long index, Date &date) const
+        {
+            if (unit == Days || unit == Weeks)
+                date = dateFromDays(daysFromDate(start) + index * every * (unit == Weeks ? 7 : 1));
+            else
+            {
+                long months = start.month - 1 + index * every * (unit == Years ? 12 : 1);
+                if (start.year + months / 12 > 9999)
+                    return false;
+                date.year = static_cast<int>(start.year + months / 12);
+                date.month = static_cast<int>(months % 12 + 1);
+                date.day = std::min(start.day, daysInMonth(date.year, date.month));
+            }
+            return isValidDate(date);
+        }
+
+        // Index of the first occurrence on or after day, found arithmetically
+        // rather than by stepping through the ones before it
+        long firstIndexFrom(const Date &day) const
+        {
+            long days = daysFromDate(day) - daysFromDate(start);
+            if (days <= 0)
+                return 0;
+            if (unit == Days || unit == Weeks)
+            {
+                long step = static_cast<long>(every) * (unit == Weeks ? 7 : 1);
+                return (days + step - 1) / step;
+            }
+            long months = (day.year - start.year) * 12L + day.month - start.month;
+            long index = months / (static_cast<long>(every) * (unit == Years ? 12 : 1));
+            // The estimate is at most one short, when day falls after a clamped occurrence
+            Date date;
+            while (occurrence(index, date) && daysFromDate(date) < daysFromDate(day))
+                ++index;
+            return index;
+        }
+
+        // First occurrence strictly after day; false if there is none
+        bool nextAfter(const Date &day, Date &date) const
+        {
+            return occurrence(firstIndexFrom(dateFromDays(daysFromDate(day) + 1)), date);
+        }
+    };
+
+    // The days an agenda covers, both included. An empty from means today and
+    // an empty to two weeks from the first day
+    inline bool parseAgendaWindow(const std::string &from, const std::string &to, Date &first, Date &last)
+    {
+        if (from.empty())
+            first = today();
+        else if (!parseDate(from, first))
+            return false;
+        if (to.empty())
+        {
+            last = dateFromDays(daysFromDate(first) + 13);
+            return true;
+        }
+        return parseDate(to, last) && daysFromDate(last) >= daysFromDate(first);
+    }
+
+    // Lists the occurrences of many tasks in a window in date order without
+    // expanding any series up front. Each task keeps one pending occurrence on
+    // a heap; taking it puts that task's next occurrence in its place. A window
+    // costs a heap operation per row shown, however long the series run
+    class AgendaQueue
+    {
+    private:
+        struct Pending
+        {
+            long day;
+            std::size_t source;
+            long index; // Occurrence index of day, for a series
+            bool repeats;
+            RecurrenceRule rule;
+        };
+
+        long first;
+        long last;
+        std::vector<Pending> heap;
+
+        // Earliest day on top; ties keep the order the tasks were added in
+        static bool later(const Pending &a, const Pending &b)
+        {
+            return a.day != b.day ? a.day > b.day : a.source > b.source;
+        }
+
+        void push(const Pending &p)
+        {
+            heap.push_back(p);
+            std::push_heap(heap.begin(), heap.end(), later);
+        }
+
+    public:
+        AgendaQueue(const Date &from, const Date &to) : first(daysFromDate(from)), last(daysFromDate(to)) {}
+
+        // A task due on `due`, identified by source. With a rule it also comes
+        // back on every later occurrence; the ones before due are done.
+        // Returns false if nothing of it falls in the window
+        bool add(std::size_t source, const Date &due, const RecurrenceRule *rule = nullptr)
+        {
+            long day = daysFromDate(due);
+            if (!rule)
+            {
+                if (day < first || day > last)
+                    return false;
+                push(Pending{day, source, 0, false, RecurrenceRule()});
+                return true;
+            }
+            long index = rule->firstIndexFrom(dateFromDays(std::max(day, first)));
+            Date date;
+            if (!rule->occurrence(index, date) || daysFromDate(date) > last)
+                return false;
+            push(Pending{daysFromDate(date), source, index, true, *rule});
+            return true;
+        }
+
+        // The next occurrence in date order; false once the window is used up
+        bool next(std::size_t &source, Date &date)
+        {
+            if (heap.empty())
+                return false;
+            std::pop_heap(heap.begin(), heap.end(), later);
+            Pending p = heap.back();
+            heap.pop_back();
+            source = p.source;
+            date = dateFromDays(p.day);
+            Date following;
+            if (p.repeats && p.rule.occurrence(p.index + 1, following) && daysFromDate(following) <= last)
+            {
+                p.day = daysFromDate(following);
+                ++p.index;
+                push(p);
+            }
+            return true;
+        }
+    };
+
+} // namespace todo
+
+#endif
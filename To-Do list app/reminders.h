@@ -0,0 +1,361 @@
+#ifndef TODO_REMINDERS_H
+#define TODO_REMINDERS_H
+
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <filesystem>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "date_utils.h"
+#include "metrics.h"
+#include "task_file.h"
+#include "timer_wheel.h"
+
+namespace todo
+{
+
+    // Reminders for the active tasks of a task file, each a set offset before
+    // the task falls due. A deadline is a date, so a task falls due on that day
+    // at a configurable time of day (09:00 unless told otherwise).
+    //
+    // Every task holds a single timer on the wheel, set for its next reminder;
+    // when it fires the same task is scheduled again for the one after. sync()
+    // matches the scheduler against the file by title, so a changed deadline
+    // moves one timer, a new task adds one and a gone or completed task drops
+    // one, and only what changed touches the wheel. Reminders that were due
+    // before the scheduler learned of them are skipped, not fired late
+    class ReminderScheduler
+    {
+    public:
+        // One reminder going off
+        struct Event
+        {
+            std::string_view title;
+            std::string_view deadline;
+            std::int64_t offset; // Seconds before the task falls due
+            std::int64_t at;     // When it was meant to go off
+        };
+
+        // What a sync() changed
+        struct SyncStats
+        {
+            std::size_t added = 0;
+            std::size_t moved = 0;
+            std::size_t dropped = 0;
+        };
+
+    private:
+        struct Reminder
+        {
+            std::string deadline;
+            std::int64_t due = 0;
+            std::uint64_t timer = 0; // Wheel handle, 0 when no reminder is left
+            std::size_t next = 0; // Index of the offset the timer is set for
+            unsigned seen = 0;    // The last sync() that found the task in the file
+        };
+
+        // Timers point at map entries, which stay put while the map grows
+        using Entry = std::unordered_map<std::string, Reminder>::value_type;
+
+        std::vector<std::int64_t> offsets; // Longest first
+        std::int64_t dueSeconds;           // Time of day a task falls due, in seconds after midnight
+        std::unordered_map<std::string, Reminder> reminders;
+        std::unordered_map<long, std::int64_t> midnights; // Local midnight of each deadline day seen
+        std::unordered_map<std::string, std::string> latest; // Deadline of each title's last active line, per sync
+        TimerWheel<Entry *> wheel;
+        unsigned pass = 0;
+        MetricsRegistry::Counter fired;
+        MetricsRegistry::Gauge scheduled;
+
+        // When a deadline day falls due, or -1 for a date that is not one.
+        // mktime is slow and deadlines repeat, so each day is converted once
+        std::int64_t dueTime(std::string_view deadline)
+        {
+            Date date;
+            if (!parseDate(deadline, date))
+                return -1;
+            long day = daysFromDate(date);
+            auto it = midnights.find(day);
+            if (it == midnights.end())
+            {
+                std::tm tm = {};
+                tm.tm_year = date.year - 1900;
+                tm.tm_mon = date.month - 1;
+                tm.tm_mday = date.day;
+                tm.tm_isdst = -1;
+                it = midnights.emplace(day, static_cast<std::int64_t>(std::mktime(&tm))).first;
+            }
+            return it->second + dueSeconds;
+        }
+
+        // Set the timer of a task for its first reminder after now; the
+        // caller has checked that there is one
+        void arm(Entry &entry, std::int64_t now)
+        {
+            Reminder &r = entry.second;
+            std::size_t i = 0;
+            while (r.due - offsets[i] <= now)
+                ++i;
+            r.next = i;
+            if (!wheel.reschedule(r.timer, r.due - offsets[i]))
+                r.timer = wheel.schedule(r.due - offsets[i], &entry);
+        }
+
+    public:
+        // offsets in seconds before the deadline, dueTime in seconds after midnight
+        ReminderScheduler(std::vector<std::int64_t> remindAt, std::int64_t dueTimeOfDay, std::int64_t now)
+            : offsets(std::move(remindAt)), dueSeconds(dueTimeOfDay), wheel(now)
+        {
+            std::sort(offsets.begin(), offsets.end(), std::greater<std::int64_t>());
+            offsets.erase(std::unique(offsets.begin(), offsets.end()), offsets.end());
+            MetricsRegistry &m = MetricsRegistry::instance();
+            fired = m.counter("todo_reminders_fired_total", "Reminders that went off");
+            scheduled = m.gauge("todo_reminders_pending", "Tasks with a reminder still to come");
+        }
+
+        // Bring the reminders in line with the active tasks of a task file.
+        // Only tasks with a reminder still ahead are kept. Later lines win over
+        // earlier ones with the same title, as in the title index. Returns
+        // false if the file cannot be read
+        bool sync(const std::string &filename, std::int64_t now, SyncStats *stats = nullptr)
+        {
+            LineReader reader;
+            if (!reader.open(filename))
+                return false;
+            SyncStats unused;
+            SyncStats &s = stats ? *stats : unused;
+            ++pass;
+            std::string_view line;
+            TaskRecord record;
+            std::string title;
+            // Duplicates are resolved first, so an earlier line never moves a reminder back
+            latest.clear();
+            while (reader.next(line))
+            {
+                parseTaskLine(line, record, 2);
+                if (record.done)
+                    continue;
+                title.assign(record.title.data(), record.title.size());
+                latest[title].assign(record.deadline.data(), record.deadline.size());
+            }
+            for (const auto &task : latest)
+            {
+                const std::string &deadline = task.second;
+                auto it = reminders.find(task.first);
+                if (it != reminders.end() && it->second.deadline == deadline)
+                {
+                    it->second.seen = pass;
+                    continue;
+                }
+                std::int64_t due = dueTime(deadline);
+                bool ahead = due >= 0 && due - offsets.back() > now;
+                if (it == reminders.end())
+                {
+                    if (!ahead)
+                        continue; // Nothing left to remind of
+                    it = reminders.emplace(task.first, Reminder()).first;
+                    ++s.added;
+                }
+                else if (!ahead)
+                {
+                    wheel.cancel(it->second.timer);
+                    reminders.erase(it);
+                    ++s.dropped;
+                    continue;
+                }
+                else
+                    ++s.moved;
+                it->second.deadline = deadline;
+                it->second.due = due;
+                it->second.seen = pass;
+                arm(*it, now);
+            }
+            for (auto it = reminders.begin(); it != reminders.end();)
+            {
+                if (it->second.seen == pass)
+                {
+                    ++it;
+                    continue;
+                }
+                wheel.cancel(it->second.timer);
+                it = reminders.erase(it);
+                ++s.dropped;
+            }
+            scheduled.set(static_cast<std::int64_t>(wheel.size()));
+            return true;
+        }
+
+        // Fire every reminder due up to now, oldest first, through emit(event)
+        template <class Emit>
+        std::size_t advance(std::int64_t now, Emit emit)
+        {
+            std::size_t n = wheel.advance(now, [&](Entry *entry, std::int64_t when)
+                                          {
+                Reminder &r = entry->second;
+                fired.add();
+                emit(Event{entry->first, r.deadline, offsets[r.next], when});
+                if (++r.next < offsets.size())
+                    r.timer = wheel.schedule(r.due - offsets[r.next], entry);
+                else
+                    reminders.erase(reminders.find(entry->first)); });
+            if (n > 0)
+                scheduled.set(static_cast<std::int64_t>(wheel.size()));
+            return n;
+        }
+
+        // Tasks with a reminder still to come
+        std::size_t pending() const { return wheel.size(); }
+    };
+
+    // Read offsets such as "1d,2h,30m,0": a number with d, h, m or s (seconds
+    // without a unit), longest or shortest first; false on anything else
+    inline bool parseOffsets(const std::string &text, std::vector<std::int64_t> &offsets)
+    {
+        offsets.clear();
+        std::string_view rest(text);
+        while (true)
+        {
+            std::size_t comma = rest.find(',');
+            std::string_view item = rest.substr(0, comma);
+            std::size_t pos = 0;
+            int value;
+            if (!readNumber(item, pos, 6, value))
+                return false;
+            static const char units[] = "smhd";
+            static const std::int64_t seconds[] = {1, 60, 3600, 86400};
+            std::int64_t unit = 1;
+            if (pos + 1 == item.size())
+            {
+                const char *u = std::char_traits<char>::find(units, 4, item[pos]);
+                if (!u)
+                    return false;
+                unit = seconds[u - units];
+            }
+            else if (pos != item.size())
+                return false;
+            offsets.push_back(value * unit);
+            if (comma == std::string_view::npos)
+                return true;
+            rest.remove_prefix(comma + 1);
+        }
+    }
+
+    // An offset the way it would be typed: 1d, 36h, 90m, 45s
+    inline std::string formatOffset(std::int64_t seconds)
+    {
+        if (seconds % 86400 == 0)
+            return std::to_string(seconds / 86400) + "d";
+        if (seconds % 3600 == 0)
+            return std::to_string(seconds / 3600) + "h";
+        if (seconds % 60 == 0)
+            return std::to_string(seconds / 60) + "m";
+        return std::to_string(seconds) + "s";
+    }
+
+    // Set by SIGINT and SIGTERM to end a watch
+    inline volatile std::sig_atomic_t &watchStopRequested()
+    {
+        static volatile std::sig_atomic_t stop = 0;
+        return stop;
+    }
+
+    inline void requestWatchStop(int) { watchStopRequested() = 1; }
+
+    // watch [--remind <offsets>] [--due-time HH:MM]: stay running and print a
+    // line for each reminder as it goes off, picking up changes to the task
+    // file as it is saved. Ends on Ctrl-C or SIGTERM. metrics, if given, is
+    // rewritten whenever something happened
+    inline int watchCommand(const std::string &filename, int argc, char *argv[], const MetricsFileSession *metrics = nullptr)
+    {
+        std::vector<std::int64_t> offsets = {86400, 3600};
+        int hour = 9, minute = 0;
+        for (int i = 0; i < argc; ++i)
+        {
+            std::string arg = argv[i];
+            std::string_view value = i + 1 < argc ? std::string_view(argv[i + 1]) : std::string_view();
+            std::size_t pos = 0;
+            if (arg == "--remind" && i + 1 < argc && parseOffsets(argv[i + 1], offsets))
+                ++i;
+            else if (arg == "--due-time" && readNumber(value, pos, 2, hour) && pos < value.size() &&
+                     value[pos++] == ':' && readNumber(value, pos, 2, minute) && pos == value.size() &&
+                     hour < 24 && minute < 60)
+                ++i;
+            else
+            {
+                std::cerr << "usage: watch [--remind 1d,1h,...] [--due-time HH:MM]\n"
+                          << "  offsets before the deadline in d, h, m or s; tasks fall due at 09:00 by default\n";
+                return 2;
+            }
+        }
+
+        auto stampOf = [&filename]()
+        {
+            std::error_code error;
+            auto time = std::filesystem::last_write_time(filename, error);
+            auto size = std::filesystem::file_size(filename, error);
+            return std::make_pair(time, size);
+        };
+        auto stamp = stampOf();
+        std::int64_t now = static_cast<std::int64_t>(std::time(nullptr));
+        ReminderScheduler scheduler(offsets, hour * 3600 + minute * 60, now);
+        if (!scheduler.sync(filename, now))
+        {
+            std::cerr << "Could not open " << filename << "\n";
+            return 1;
+        }
+        std::cerr << "Watching " << filename << ": " << scheduler.pending() << " tasks with reminders ahead; Ctrl-C stops\n";
+        if (metrics)
+            metrics->flush();
+
+        watchStopRequested() = 0;
+        std::signal(SIGINT, requestWatchStop);
+        std::signal(SIGTERM, requestWatchStop);
+        auto print = [](const ReminderScheduler::Event &e)
+        {
+            char when[32];
+            std::time_t at = static_cast<std::time_t>(e.at);
+            std::strftime(when, sizeof(when), "%Y-%m-%d %H:%M", std::localtime(&at));
+            std::cout << when << " Reminder: " << e.title << " is due " << e.deadline
+                      << (e.offset == 0 ? std::string(" (now)") : " (in " + formatOffset(e.offset) + ")") << std::endl;
+        };
+        while (!watchStopRequested())
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(200));
+            now = static_cast<std::int64_t>(std::time(nullptr));
+            bool changed = scheduler.advance(now, print) > 0;
+            auto current = stampOf();
+            if (current != stamp)
+            {
+                // A save in progress shows up as another change, so a half-written
+                // file is read again once it is complete
+                stamp = current;
+                ReminderScheduler::SyncStats s;
+                if (scheduler.sync(filename, now, &s) && s.added + s.moved + s.dropped > 0)
+                {
+                    std::cerr << "Reloaded " << filename << ": " << s.added << " new, " << s.moved << " moved, "
+                              << s.dropped << " dropped\n";
+                    changed = true;
+                }
+            }
+            if (changed && metrics)
+                metrics->flush();
+        }
+        std::signal(SIGINT, SIG_DFL);
+        std::signal(SIGTERM, SIG_DFL);
+        return 0;
+    }
+
+} // namespace todo
+
+#endif
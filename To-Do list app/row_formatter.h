@@ -0,0 +1,113 @@
+#ifndef TODO_ROW_FORMATTER_H
+#define TODO_ROW_FORMATTER_H
+
+#include <string>
+#include <string_view>
+#include <cstring>
+#include <cstddef>
+#include "output_buffer.h"
+
+namespace todo
+{
+
+    // Column layout of a plain task row. Layouts are passed to RowFormatter as
+    // a type, so every width and separator is a compile-time constant
+    struct TaskRowLayout
+    {
+        static constexpr std::size_t titleWidth = 20;
+        static constexpr std::size_t deadlineWidth = 12;
+        static constexpr bool withCategory = false;
+        static constexpr bool withRepeat = false;
+        static constexpr char doneMark[] = "[X] ";
+        static constexpr char openMark[] = "[ ] ";
+        static constexpr char deadlineSeparator[] = " | Due: ";
+        static constexpr char categorySeparator[] = " | Category: ";
+        static constexpr char repeatSeparator[] = " | Repeats: ";
+    };
+
+    // Same row with the category column appended
+    struct CategorizedRowLayout : TaskRowLayout
+    {
+        static constexpr bool withCategory = true;
+    };
+
+    // Rows of recurring tasks end with how often the task comes back
+    struct RecurringRowLayout : TaskRowLayout
+    {
+        static constexpr bool withRepeat = true;
+    };
+
+    struct RecurringCategorizedRowLayout : CategorizedRowLayout
+    {
+        static constexpr bool withRepeat = true;
+    };
+
+    // Formats task rows straight into an OutputBuffer. All padding and
+    // separator copies have a fixed size, so the compiler turns them into
+    // plain stores instead of going through iostream manipulators
+    template <class Layout>
+    class RowFormatter
+    {
+    private:
+        static_assert(sizeof(Layout::doneMark) == sizeof(Layout::openMark),
+                      "completion marks must have the same width");
+
+        static constexpr std::size_t markSize = sizeof(Layout::doneMark) - 1;
+        static constexpr std::size_t deadlineSeparatorSize = sizeof(Layout::deadlineSeparator) - 1;
+        static constexpr std::size_t categorySeparatorSize = Layout::withCategory ? sizeof(Layout::categorySeparator) - 1 : 0;
+        static constexpr std::size_t repeatSeparatorSize = Layout::withRepeat ? sizeof(Layout::repeatSeparator) - 1 : 0;
+
+        // Copy a string left-aligned into a column of Width characters.
+        // The column is blanked first with a fixed-size fill, then the text is
+        // copied over it; longer text is never cut, just like std::setw
+        template <std::size_t Width>
+        static char *column(char *p, std::string_view text)
+        {
+            std::memset(p, ' ', Width);
+            std::memcpy(p, text.data(), text.size());
+            return p + (text.size() > Width ? text.size() : Width);
+        }
+
+    public:
+        // Upper bound for the fixed part of a row (marks, separators, padding, newline)
+        static constexpr std::size_t fixedSize = markSize + Layout::titleWidth + deadlineSeparatorSize +
+                                                 Layout::deadlineWidth + categorySeparatorSize + repeatSeparatorSize + 1;
+
+        static void format(OutputBuffer &out, bool completed, std::string_view title,
+                           std::string_view deadline, std::string_view category = std::string_view(),
+                           std::string_view repeat = std::string_view())
+        {
+            std::size_t maxSize = fixedSize + title.size() + deadline.size() +
+                                  (Layout::withCategory ? category.size() : 0) + (Layout::withRepeat ? repeat.size() : 0);
+            char *start = out.reserve(maxSize);
+            char *p = start;
+
+            std::memcpy(p, completed ? Layout::doneMark : Layout::openMark, markSize);
+            p += markSize;
+            p = column<Layout::titleWidth>(p, title);
+            std::memcpy(p, Layout::deadlineSeparator, deadlineSeparatorSize);
+            p += deadlineSeparatorSize;
+            p = column<Layout::deadlineWidth>(p, deadline);
+            if (Layout::withCategory)
+            {
+                std::memcpy(p, Layout::categorySeparator, categorySeparatorSize);
+                p += categorySeparatorSize;
+                std::memcpy(p, category.data(), category.size());
+                p += category.size();
+            }
+            if (Layout::withRepeat)
+            {
+                std::memcpy(p, Layout::repeatSeparator, repeatSeparatorSize);
+                p += repeatSeparatorSize;
+                std::memcpy(p, repeat.data(), repeat.size());
+                p += repeat.size();
+            }
+            *p++ = '\n';
+
+            out.commit(static_cast<std::size_t>(p - start));
+        }
+    };
+
+} // namespace todo
+
+#endif
@@ -0,0 +1,177 @@
+#ifndef TODO_TASK_H
+#define TODO_TASK_H
+
+#include <iostream>
+#include <string>
+#include <string_view>
+#include "output_buffer.h"
+#include "row_formatter.h"
+#include "recurrence.h"
+
+namespace todo
+{
+
+    // Abstract base class for tasks
+    class TaskBase
+    {
+    public:
+        // Pure virtual methods so that derived classes implement these
+        virtual void render(OutputBuffer &out) const = 0;
+        virtual std::string toFileString() const = 0;
+        virtual const std::string &getTitle() const = 0;
+        virtual const std::string &getDeadline() const = 0;
+        virtual const std::string &getCategory() const = 0;
+        virtual bool isCompleted() const = 0;
+        virtual void markCompleted() = 0;
+        virtual void reopen() = 0;
+        virtual ~TaskBase() {} // Virtual destructor for safe polymorphic deletion
+    };
+
+    // Concrete task class
+    class Task : public TaskBase
+    {
+    protected:
+        std::string title;
+        std::string deadline;
+        bool completed;
+
+    public:
+        // Default constructor
+        Task() : title(""), deadline(""), completed(false) {}
+
+        // Parameterized constructor
+        Task(const std::string &t, const std::string &d, bool c = false)
+            : title(t), deadline(d), completed(c) {}
+
+        // Format the task row into an output buffer
+        virtual void render(OutputBuffer &out) const override
+        {
+            RowFormatter<TaskRowLayout>::format(out, completed, title, deadline);
+        }
+
+        // Convert task details to a string for saving
+        virtual std::string toFileString() const override
+        {
+            return title + ";" + deadline + ";" + (completed ? "1" : "0");
+        }
+
+        // Mark task as completed
+        virtual void markCompleted() override { completed = true; }
+        // Take back markCompleted, for undo
+        virtual void reopen() override { completed = false; }
+        virtual bool isCompleted() const override { return completed; }
+        virtual const std::string &getTitle() const override { return title; }
+        virtual const std::string &getDeadline() const override { return deadline; }
+        virtual const std::string &getCategory() const override
+        {
+            static const std::string none;
+            return none;
+        }
+
+        // Overload << operator to display task
+        friend std::ostream &operator<<(std::ostream &os, const Task &task)
+        {
+            os << (task.completed ? "[X] " : "[ ] ") << task.title << " (Due: " << task.deadline << ")";
+            return os;
+        }
+
+        // Overload + operator to combine tasks
+        Task operator+(const Task &other)
+        {
+            return Task(title + " & " + other.title, deadline);
+        }
+    };
+
+    // Derived class with category support
+    class CategorizedTask : public Task
+    {
+    private:
+        std::string category;
+
+    public:
+        CategorizedTask() : Task(), category("") {}
+        CategorizedTask(const std::string &t, const std::string &d, const std::string &cat, bool c = false)
+            : Task(t, d, c), category(cat) {}
+
+        // Format the row including category
+        void render(OutputBuffer &out) const override
+        {
+            RowFormatter<CategorizedRowLayout>::format(out, completed, title, deadline, category);
+        }
+
+        // Convert to file string with category
+        std::string toFileString() const override
+        {
+            return title + ";" + deadline + ";" + (completed ? "1" : "0") + ";" + category;
+        }
+
+        const std::string &getCategory() const override { return category; }
+    };
+
+    // A task that comes back by a recurrence rule. The deadline is the next
+    // occurrence not yet done; completing the task files that occurrence as a
+    // completed task and moves the deadline on to the following one. Later
+    // occurrences are never stored, an agenda works them out for its window
+    class RecurringTask : public CategorizedTask
+    {
+    private:
+        RecurrenceRule rule;
+        std::string every; // rule.describe(), kept for rendering
+
+    public:
+        RecurringTask(const std::string &t, const std::string &d, const std::string &cat,
+                      const RecurrenceRule &r, bool c = false)
+            : CategorizedTask(t, d, cat, c), rule(r), every(r.describe()) {}
+
+        // The row layout of a recurring task, also used for raw task lines
+        static void formatRow(OutputBuffer &out, bool completed, std::string_view title, std::string_view deadline,
+                              std::string_view category, std::string_view every)
+        {
+            if (category.empty())
+                RowFormatter<RecurringRowLayout>::format(out, completed, title, deadline, category, every);
+            else
+                RowFormatter<RecurringCategorizedRowLayout>::format(out, completed, title, deadline, category, every);
+        }
+
+        void render(OutputBuffer &out) const override
+        {
+            formatRow(out, completed, title, deadline, getCategory(), every);
+        }
+
+        // The row of one occurrence, due on the given date
+        void renderAt(OutputBuffer &out, const std::string &date) const
+        {
+            formatRow(out, false, title, date, getCategory(), every);
+        }
+
+        std::string toFileString() const override
+        {
+            return CategorizedTask::toFileString() + ";repeat=" + rule.field();
+        }
+
+        const RecurrenceRule &recurrence() const { return rule; }
+
+        // The deadline after the current one; false when the series has ended
+        bool nextDeadline(std::string &next) const
+        {
+            Date due, date;
+            if (!parseDate(deadline, due) || !rule.nextAfter(due, date))
+                return false;
+            next = formatDeadline(date);
+            return true;
+        }
+
+        // A completed copy of the current occurrence, for the completed list
+        TaskBase *doneOccurrence() const
+        {
+            if (getCategory().empty())
+                return new Task(title, deadline, true);
+            return new CategorizedTask(title, deadline, getCategory(), true);
+        }
+
+        void reschedule(const std::string &d) { deadline = d; }
+    };
+
+} // namespace todo
+
+#endif
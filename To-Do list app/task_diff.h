@@ -0,0 +1,373 @@
+#ifndef TODO_TASK_DIFF_H
+#define TODO_TASK_DIFF_H
+
+#include <cstdio>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <functional>
+#include "task_file.h"
+#include "output_buffer.h"
+
+namespace todo
+{
+
+    // A whole task file held in one buffer, with every line split into a record
+    class TaskFileSnapshot
+    {
+    private:
+        std::string data;
+
+    public:
+        std::vector<TaskRecord> records;
+
+        bool load(const std::string &filename)
+        {
+            std::FILE *f = std::fopen(filename.c_str(), "rb");
+            if (!f)
+                return false;
+            char block[1 << 16];
+            std::size_t n;
+            while ((n = std::fread(block, 1, sizeof(block), f)) > 0)
+                data.append(block, n);
+            std::fclose(f);
+
+            std::string_view rest(data);
+            records.reserve(rest.size() / 32);
+            while (!rest.empty())
+            {
+                std::size_t newline = rest.find('\n');
+                TaskRecord record;
+                parseTaskLine(rest.substr(0, newline), record);
+                records.push_back(record);
+                rest.remove_prefix(newline == std::string_view::npos ? rest.size() : newline + 1);
+            }
+            return true;
+        }
+    };
+
+    // Compares and merges task files. Records are matched through hash tables in
+    // two passes: first identical records, then what is left by title. Both
+    // passes are linear in the number of lines; no pair of records is compared
+    // unless their hashes agree
+    class TaskDiff
+    {
+    public:
+        static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+    private:
+        static bool isDone(const TaskRecord &r) { return r.done || r.completed(); }
+
+        static std::uint64_t mix(std::uint64_t h, std::uint64_t v)
+        {
+            h ^= v + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+            return h;
+        }
+
+        static std::uint64_t titleHash(const TaskRecord &r)
+        {
+            return std::hash<std::string_view>()(r.title);
+        }
+
+        // Everything that makes two records the same task in the same state
+        static std::uint64_t contentHash(const TaskRecord &r)
+        {
+            std::hash<std::string_view> hash;
+            std::uint64_t h = mix(hash(r.title), hash(r.deadline));
+            h = mix(h, r.hasCategory ? hash(r.category) + 1 : 0);
+            h = mix(h, hash(r.extensions));
+            return mix(h, isDone(r) ? 1 : 2);
+        }
+
+        static bool sameContent(const TaskRecord &x, const TaskRecord &y)
+        {
+            return x.title == y.title && x.deadline == y.deadline && x.hasCategory == y.hasCategory &&
+                   x.category == y.category && x.extensions == y.extensions && isDone(x) == isDone(y);
+        }
+
+        static bool sameTitle(const TaskRecord &x, const TaskRecord &y) { return x.title == y.title; }
+
+        // Open-addressing hash table over some records of one file. Records with
+        // equal keys form a queue in file order, so duplicates are claimed one by one
+        class RecordIndex
+        {
+        private:
+            const std::vector<TaskRecord> &records;
+            std::vector<std::uint32_t> slots;  // First record of a key + 1, 0 when empty
+            std::vector<std::uint64_t> hashes; // Hash of the key in each slot
+            std::vector<std::uint32_t> next;   // Next record with the same key
+            std::vector<std::uint32_t> cursor; // First unclaimed record of a key, by its first record
+            std::vector<std::uint32_t> last;   // Last record of a key, by its first record
+            std::size_t mask;
+
+            static constexpr std::uint32_t none = 0xffffffffu;
+
+        public:
+            template <class Equal>
+            RecordIndex(const std::vector<TaskRecord> &recs, const std::vector<std::uint64_t> &keyHashes,
+                        const std::vector<std::size_t> &pairs, Equal equal)
+                : records(recs), next(recs.size(), none), cursor(recs.size(), none), last(recs.size(), none)
+            {
+                std::size_t capacity = 16;
+                while (capacity < recs.size() * 2)
+                    capacity <<= 1;
+                slots.assign(capacity, 0);
+                hashes.assign(capacity, 0);
+                mask = capacity - 1;
+
+                for (std::size_t i = 0; i < recs.size(); ++i)
+                {
+                    if (pairs[i] != npos)
+                        continue;
+                    std::size_t slot = keyHashes[i] & mask;
+                    while (slots[slot] != 0)
+                    {
+                        std::uint32_t first = slots[slot] - 1;
+                        if (hashes[slot] == keyHashes[i] && equal(recs[first], recs[i]))
+                            break;
+                        slot = (slot + 1) & mask;
+                    }
+                    std::uint32_t index = static_cast<std::uint32_t>(i);
+                    if (slots[slot] == 0)
+                    {
+                        slots[slot] = index + 1;
+                        hashes[slot] = keyHashes[i];
+                        cursor[i] = last[i] = index;
+                    }
+                    else
+                    {
+                        std::uint32_t first = slots[slot] - 1;
+                        next[last[first]] = index;
+                        last[first] = index;
+                    }
+                }
+            }
+
+            // Take the next unclaimed record whose key equals probe's; npos if there is none
+            template <class Equal>
+            std::size_t claim(const TaskRecord &probe, std::uint64_t hash, Equal equal)
+            {
+                std::size_t slot = hash & mask;
+                while (slots[slot] != 0)
+                {
+                    std::uint32_t first = slots[slot] - 1;
+                    if (hashes[slot] == hash && equal(records[first], probe))
+                    {
+                        std::uint32_t found = cursor[first];
+                        if (found == none)
+                            return npos;
+                        cursor[first] = next[found];
+                        return found;
+                    }
+                    slot = (slot + 1) & mask;
+                }
+                return npos;
+            }
+        };
+
+        // Pair records of a and b: pairsA[i] is the index in b matched to a[i], or npos
+        static void match(const std::vector<TaskRecord> &a, const std::vector<TaskRecord> &b,
+                          std::vector<std::size_t> &pairsA, std::vector<std::size_t> &pairsB)
+        {
+            pairsA.assign(a.size(), npos);
+            pairsB.assign(b.size(), npos);
+            std::vector<std::uint64_t> hashA(a.size()), hashB(b.size());
+
+            // Pass 1: identical records
+            for (std::size_t i = 0; i < a.size(); ++i)
+                hashA[i] = contentHash(a[i]);
+            {
+                RecordIndex index(a, hashA, pairsA, sameContent);
+                for (std::size_t j = 0; j < b.size(); ++j)
+                {
+                    hashB[j] = contentHash(b[j]);
+                    std::size_t i = index.claim(b[j], hashB[j], sameContent);
+                    if (i != npos)
+                    {
+                        pairsA[i] = j;
+                        pairsB[j] = i;
+                    }
+                }
+            }
+
+            // Pass 2: what is left, by title
+            for (std::size_t i = 0; i < a.size(); ++i)
+                if (pairsA[i] == npos)
+                    hashA[i] = titleHash(a[i]);
+            RecordIndex index(a, hashA, pairsA, sameTitle);
+            for (std::size_t j = 0; j < b.size(); ++j)
+            {
+                if (pairsB[j] != npos)
+                    continue;
+                std::size_t i = index.claim(b[j], titleHash(b[j]), sameTitle);
+                if (i != npos)
+                {
+                    pairsA[i] = j;
+                    pairsB[j] = i;
+                }
+            }
+        }
+
+        static void appendLine(OutputBuffer &out, const TaskRecord &r, bool done)
+        {
+            if (done)
+                out.append("DONE:", 5);
+            out.append(r.title.data(), r.title.size());
+            out.append(';');
+            out.append(r.deadline.data(), r.deadline.size());
+            out.append(';');
+            out.append(done || r.completed() ? '1' : '0');
+            if (r.hasCategory)
+            {
+                out.append(';');
+                out.append(r.category.data(), r.category.size());
+                if (!r.extensions.empty())
+                {
+                    out.append(';');
+                    out.append(r.extensions.data(), r.extensions.size());
+                }
+            }
+            out.append('\n');
+        }
+
+        static void appendChange(OutputBuffer &out, const char *what, std::string_view from, std::string_view to)
+        {
+            out.append(std::string("    ") + what + ": " + std::string(from) + " -> " + std::string(to) + "\n");
+        }
+
+    public:
+        struct Summary
+        {
+            std::size_t added = 0;
+            std::size_t deleted = 0;
+            std::size_t completed = 0;
+            std::size_t reopened = 0;
+            std::size_t changed = 0;
+            std::size_t unchanged = 0;
+        };
+
+        // Report how `after` differs from `before`:
+        //   + added, - deleted, x completed, o reopened, ~ changed deadline or category
+        static Summary diff(const TaskFileSnapshot &before, const TaskFileSnapshot &after, OutputBuffer &out)
+        {
+            const std::vector<TaskRecord> &a = before.records;
+            const std::vector<TaskRecord> &b = after.records;
+            std::vector<std::size_t> pairsA, pairsB;
+            match(a, b, pairsA, pairsB);
+
+            Summary summary;
+            for (std::size_t i = 0; i < a.size(); ++i)
+            {
+                if (pairsA[i] == npos)
+                {
+                    ++summary.deleted;
+                    out.append("- ", 2);
+                    appendLine(out, a[i], a[i].done);
+                    continue;
+                }
+                const TaskRecord &x = a[i];
+                const TaskRecord &y = b[pairsA[i]];
+                bool changedFields = x.deadline != y.deadline || x.hasCategory != y.hasCategory || x.category != y.category ||
+                                    x.extensions != y.extensions;
+                if (isDone(x) != isDone(y))
+                {
+                    ++(isDone(y) ? summary.completed : summary.reopened);
+                    out.append(isDone(y) ? "x " : "o ", 2);
+                    appendLine(out, y, y.done);
+                }
+                else if (changedFields)
+                {
+                    ++summary.changed;
+                    out.append("~ ", 2);
+                    appendLine(out, y, y.done);
+                }
+                else
+                {
+                    ++summary.unchanged;
+                    continue;
+                }
+                if (x.deadline != y.deadline)
+                    appendChange(out, "deadline", x.deadline, y.deadline);
+                if (x.category != y.category)
+                    appendChange(out, "category", x.category, y.category);
+                if (x.extensions != y.extensions)
+                    appendChange(out, "extensions", x.extensions, y.extensions);
+            }
+            for (std::size_t j = 0; j < b.size(); ++j)
+            {
+                if (pairsB[j] != npos)
+                    continue;
+                ++summary.added;
+                out.append("+ ", 2);
+                appendLine(out, b[j], b[j].done);
+            }
+            return summary;
+        }
+
+        // Merge two copies of a task file into out. Without a base every task of
+        // either side is kept; when a task exists on both sides, completion wins and
+        // otherwise `theirs` is taken. With a base, a task deleted on one side is
+        // dropped unless the other side changed it
+        static void merge(const TaskFileSnapshot &ours, const TaskFileSnapshot &theirs,
+                          const TaskFileSnapshot *base, OutputBuffer &out)
+        {
+            const std::vector<TaskRecord> &a = ours.records;
+            const std::vector<TaskRecord> &b = theirs.records;
+            std::vector<std::size_t> pairsA, pairsB;
+            match(a, b, pairsA, pairsB);
+
+            // Which records are unchanged since the base, per side
+            std::vector<std::size_t> baseOfA, baseForA, baseOfB, baseForB;
+            if (base)
+            {
+                match(base->records, a, baseForA, baseOfA);
+                match(base->records, b, baseForB, baseOfB);
+            }
+            auto unchangedSinceBase = [&](const std::vector<TaskRecord> &side, std::size_t index,
+                                          const std::vector<std::size_t> &baseOf)
+            {
+                std::size_t k = baseOf[index];
+                return k != npos && sameContent(base->records[k], side[index]);
+            };
+
+            // Final records and their completed state; active tasks are written first
+            std::vector<std::pair<const TaskRecord *, bool>> merged;
+            merged.reserve(a.size() + b.size());
+            for (std::size_t i = 0; i < a.size(); ++i)
+            {
+                std::size_t j = pairsA[i];
+                if (j == npos)
+                {
+                    // Only in ours: deleted by them if it came from the base unchanged
+                    if (base && baseOfA[i] != npos && unchangedSinceBase(a, i, baseOfA))
+                        continue;
+                    merged.push_back(std::make_pair(&a[i], isDone(a[i])));
+                    continue;
+                }
+                const TaskRecord *pick = &b[j];
+                if (base && unchangedSinceBase(b, j, baseOfB))
+                    pick = &a[i];
+                merged.push_back(std::make_pair(pick, isDone(a[i]) || isDone(b[j])));
+            }
+            for (std::size_t j = 0; j < b.size(); ++j)
+            {
+                if (pairsB[j] != npos)
+                    continue;
+                if (base && baseOfB[j] != npos && unchangedSinceBase(b, j, baseOfB))
+                    continue;
+                merged.push_back(std::make_pair(&b[j], isDone(b[j])));
+            }
+
+            for (const auto &m : merged)
+                if (!m.second)
+                    appendLine(out, *m.first, false);
+            for (const auto &m : merged)
+                if (m.second)
+                    appendLine(out, *m.first, true);
+        }
+    };
+
+} // namespace todo
+
+#endif
@@ -0,0 +1,224 @@
+#ifndef TODO_TASK_FILE_H
+#define TODO_TASK_FILE_H
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <climits>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace todo
+{
+
+    // One line of tasks.txt, split into fields without copying them.
+    // The views point into the line they were parsed from
+    struct TaskRecord
+    {
+        std::string_view title;
+        std::string_view deadline;
+        std::string_view completedFlag;
+        std::string_view category;
+        std::string_view extensions; // key=value fields after the category, ';'-separated
+        bool hasCategory = false;    // A fourth field was present
+        bool done = false;           // Line had the "DONE:" prefix (completed list)
+
+        bool completed() const { return completedFlag == "1"; }
+
+        // The task has a category column of its own; an empty one that only
+        // makes room for extension fields belongs to a plain task
+        bool categorized() const { return hasCategory && (!category.empty() || extensions.empty()); }
+
+        // Value of the extension field key=value; false if the line has none
+        bool extension(std::string_view key, std::string_view &value) const
+        {
+            std::string_view rest = extensions;
+            while (!rest.empty())
+            {
+                std::size_t end = rest.find(';');
+                std::string_view field = rest.substr(0, end);
+                if (field.size() > key.size() && field.compare(0, key.size(), key) == 0 && field[key.size()] == '=')
+                {
+                    value = field.substr(key.size() + 1);
+                    return true;
+                }
+                rest.remove_prefix(end == std::string_view::npos ? rest.size() : end + 1);
+            }
+            return false;
+        }
+    };
+
+    // Split a tasks.txt line the way loadFromFile does:
+    // title;deadline;completed[;category[;key=value...]]. Only the first
+    // fieldCount fields are split out, so callers that need just the title or
+    // deadline never scan the rest of the line; the extensions come with the
+    // category. A trailing '\r' from files saved on Windows is dropped
+    inline void parseTaskLine(std::string_view line, TaskRecord &record, int fieldCount = 4)
+    {
+        if (!line.empty() && line.back() == '\r')
+            line.remove_suffix(1);
+
+        record = TaskRecord();
+        if (line.compare(0, 5, "DONE:") == 0)
+        {
+            record.done = true;
+            line.remove_prefix(5);
+        }
+
+        std::string_view *fields[] = {&record.title, &record.deadline, &record.completedFlag, &record.category};
+        for (int i = 0; i < fieldCount && i < 4; ++i)
+        {
+            std::size_t end = line.find(';');
+            *fields[i] = line.substr(0, end);
+            if (end == std::string_view::npos)
+                return;
+            line.remove_prefix(end + 1);
+            // The category only counts when something follows the third ';'
+            if (i == 2)
+            {
+                if (line.empty())
+                    return;
+                record.hasCategory = true;
+            }
+        }
+        if (fieldCount >= 4)
+            record.extensions = line;
+    }
+
+    // Add a key=value extension field to a line from toFileString(), with an
+    // empty category in front if the line has no category field
+    inline void appendExtension(std::string &line, std::string_view key, std::string_view value)
+    {
+        if (std::count(line.begin(), line.end(), ';') < 3)
+            line += ';';
+        line += ';';
+        line.append(key.data(), key.size());
+        line += '=';
+        line.append(value.data(), value.size());
+    }
+
+    // Turn "d.m.yyyy" into yyyymmdd for sorting, without allocating or
+    // throwing. Malformed dates sort last
+    inline int deadlineKey(std::string_view date)
+    {
+        int parts[3] = {0, 0, 0};
+        int part = 0;
+        bool digits = false;
+        for (char c : date)
+        {
+            if (c == '.')
+            {
+                if (!digits || ++part > 2)
+                    return INT_MAX;
+                digits = false;
+            }
+            else if (c >= '0' && c <= '9')
+            {
+                parts[part] = parts[part] * 10 + (c - '0');
+                digits = true;
+                if (parts[part] > 99999)
+                    return INT_MAX;
+            }
+            else
+                return INT_MAX;
+        }
+        if (part != 2 || !digits)
+            return INT_MAX;
+        return parts[2] * 10000 + parts[1] * 100 + parts[0];
+    }
+
+    // Reads a file in large blocks and hands out one line at a time.
+    // Lines are views into the internal block and stay valid until the next call
+    class LineReader
+    {
+    private:
+        std::FILE *file;
+        std::vector<char> block;
+        std::size_t begin;
+        std::size_t end;
+        std::uint64_t offset; // File offset of block[begin]
+        bool atEof;
+
+        // Move the unread tail to the front and fill the rest of the block
+        bool refill()
+        {
+            if (atEof)
+                return false;
+            std::size_t pending = end - begin;
+            if (begin > 0)
+                std::memmove(block.data(), block.data() + begin, pending);
+            if (pending == block.size())
+                block.resize(block.size() * 2); // A line longer than the block
+            begin = 0;
+            end = pending;
+            std::size_t n = std::fread(block.data() + end, 1, block.size() - end, file);
+            end += n;
+            if (n == 0)
+                atEof = true;
+            return n > 0;
+        }
+
+    public:
+        explicit LineReader(std::size_t blockSize = 1 << 20)
+            : file(nullptr), block(blockSize), begin(0), end(0), offset(0), atEof(false) {}
+
+        ~LineReader() { close(); }
+
+        LineReader(const LineReader &) = delete;
+        LineReader &operator=(const LineReader &) = delete;
+
+        bool open(const std::string &filename, std::uint64_t startOffset = 0)
+        {
+            close();
+            file = std::fopen(filename.c_str(), "rb");
+            if (!file)
+                return false;
+            if (startOffset > 0 && std::fseek(file, static_cast<long>(startOffset), SEEK_SET) != 0)
+            {
+                close();
+                return false;
+            }
+            begin = end = 0;
+            offset = startOffset;
+            atEof = false;
+            return true;
+        }
+
+        void close()
+        {
+            if (file)
+                std::fclose(file);
+            file = nullptr;
+        }
+
+        // Next line without its '\n'; lineOffset receives where it starts in the file
+        bool next(std::string_view &line, std::uint64_t *lineOffset = nullptr)
+        {
+            if (!file)
+                return false;
+            while (true)
+            {
+                const char *start = block.data() + begin;
+                const char *newline = static_cast<const char *>(std::memchr(start, '\n', end - begin));
+                if (newline || (atEof && end > begin))
+                {
+                    std::size_t length = newline ? static_cast<std::size_t>(newline - start) : end - begin;
+                    line = std::string_view(start, length);
+                    if (lineOffset)
+                        *lineOffset = offset;
+                    std::size_t consumed = newline ? length + 1 : length;
+                    begin += consumed;
+                    offset += consumed;
+                    return true;
+                }
+                if (!refill() && end == begin)
+                    return false;
+            }
+        }
+    };
+
+} // namespace todo
+
+#endif
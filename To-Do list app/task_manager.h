@@ -0,0 +1,1020 @@
+#ifndef TODO_TASK_MANAGER_H
+#define TODO_TASK_MANAGER_H
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <map>
+#include <set>
+#include <algorithm>
+#include <chrono>
+#include <unordered_set>
+#include "task.h"
+#include "pager.h"
+#include "json_writer.h"
+#include "ical_writer.h"
+#include "latency_stats.h"
+#include "task_file.h"
+#include "trace.h"
+#include "alloc_tracker.h"
+#include "metrics.h"
+#include "history.h"
+#include "journal.h"
+#include "dependency_graph.h"
+#include "deadline_index.h"
+
+namespace todo
+{
+
+    // Pager rows backed directly by a task list
+    class TaskListSource : public PagerSource
+    {
+    private:
+        const std::vector<TaskBase *> &list;
+
+    public:
+        explicit TaskListSource(const std::vector<TaskBase *> &l) : list(l) {}
+        std::size_t size() const override { return list.size(); }
+        void renderRow(std::size_t index, OutputBuffer &out) const override { list[index]->render(out); }
+    };
+
+    // Where the time of one loadFromFile went, summed over all blocks
+    struct LoadTimings
+    {
+        std::chrono::steady_clock::duration open{};
+        std::chrono::steady_clock::duration read{};
+        std::chrono::steady_clock::duration parse{};
+        std::chrono::steady_clock::duration construct{};
+        std::chrono::steady_clock::duration index{};
+        std::size_t bytes = 0;
+        std::size_t lines = 0;
+    };
+
+    // What a TaskManager reports to a metrics scraper; operation counts come
+    // from OperationStats. Every TaskManager shares the same series
+    struct TaskMetrics
+    {
+        MetricsRegistry::Counter loaded;
+        MetricsRegistry::Counter bytesSaved;
+        MetricsRegistry::Counter lookupHits;
+        MetricsRegistry::Counter lookupMisses;
+        MetricsRegistry::Gauge active;
+        MetricsRegistry::Gauge completed;
+        MetricsRegistry::Gauge titleIndex;
+        MetricsRegistry::Gauge categories;
+        MetricsRegistry::Gauge dependencies;
+
+        TaskMetrics()
+        {
+            MetricsRegistry &r = MetricsRegistry::instance();
+            loaded = r.counter("todo_tasks_loaded_total", "Tasks read by loadFromFile");
+            bytesSaved = r.counter("todo_persisted_bytes_total", "Bytes written to task files and their indexes, by file", "file=\"tasks\"");
+            lookupHits = r.counter("todo_title_lookups_total", "Title index lookups by complete and delete, by result", "result=\"hit\"");
+            lookupMisses = r.counter("todo_title_lookups_total", "Title index lookups by complete and delete, by result", "result=\"miss\"");
+            active = r.gauge("todo_tasks", "Tasks held in memory, by state", "state=\"active\"");
+            completed = r.gauge("todo_tasks", "Tasks held in memory, by state", "state=\"completed\"");
+            titleIndex = r.gauge("todo_index_entries", "Entries in the in-memory indexes, by index", "index=\"title\"");
+            categories = r.gauge("todo_index_entries", "Entries in the in-memory indexes, by index", "index=\"category\"");
+            dependencies = r.gauge("todo_index_entries", "Entries in the in-memory indexes, by index", "index=\"dependency\"");
+        }
+    };
+
+    // Task manager class that handles all task operations
+    class TaskManager
+    {
+    private:
+        std::vector<TaskBase *> tasks;              // Active tasks
+        std::vector<TaskBase *> completedTasks;     // Completed tasks
+        std::map<std::string, TaskBase *> titleMap; // Map for quick title lookup
+        std::set<std::string> categories;           // Set of all unique categories
+        mutable OperationStats stats;               // Latency of every public operation
+        TaskMetrics metrics;                        // Counters and gauges for a scraper
+        TaskHistory history;                        // Undo and redo of the public changes
+        TaskJournal journal;                        // Timestamped changes for the file's journal, when enabled
+        DependencyGraph dependencies;               // Which titles wait for which
+
+        // Index a new active task and return the task its title pointed to
+        // before, if any; the public adders time it
+        TaskBase *insertTask(TaskBase *task)
+        {
+            tasks.push_back(task);
+            TaskBase *&slot = titleMap[task->getTitle()];
+            TaskBase *previous = slot;
+            slot = task;
+            if (!task->getCategory().empty())
+                categories.insert(task->getCategory());
+            return previous;
+        }
+
+        // Move a series on to next and file the occurrence that was done. The
+        // journal sees the series replaced, which as-of views can walk back
+        void advance(RecurringTask *series, TaskBase *done, const std::string &next)
+        {
+            journal.record(TaskJournal::Delete, *series, false);
+            series->reschedule(next);
+            journal.record(TaskJournal::Add, *series, false);
+            completedTasks.push_back(done);
+            journal.record(TaskJournal::Add, *done, true);
+        }
+
+        // Take a step back. Steps are reverted newest first, so the lists are
+        // exactly as the step left them. Categories stay, as after a delete
+        void revert(HistoryStep &step)
+        {
+            std::size_t n = step.tasks.size();
+            switch (step.kind)
+            {
+            case HistoryStep::Added:
+                tasks.resize(tasks.size() - n);
+                for (std::size_t i = n; i-- > 0;)
+                {
+                    journal.record(TaskJournal::Delete, *step.tasks[i], false);
+                    TaskBase *previous = step.shadowed.empty() ? nullptr : step.shadowed[i];
+                    if (previous)
+                        titleMap[step.tasks[i]->getTitle()] = previous;
+                    else
+                        titleMap.erase(step.tasks[i]->getTitle());
+                }
+                break;
+            case HistoryStep::AddedCompleted:
+                completedTasks.resize(completedTasks.size() - n);
+                for (auto task : step.tasks)
+                    journal.record(TaskJournal::Delete, *task, true);
+                break;
+            case HistoryStep::Completed:
+                completedTasks.pop_back();
+                step.tasks[0]->reopen();
+                tasks.insert(tasks.begin() + step.position, step.tasks[0]);
+                titleMap[step.tasks[0]->getTitle()] = step.tasks[0];
+                reattach(step);
+                journal.record(TaskJournal::Reopen, *step.tasks[0], false);
+                break;
+            case HistoryStep::Deleted:
+                tasks.insert(tasks.begin() + step.position, step.tasks[0]);
+                titleMap[step.tasks[0]->getTitle()] = step.tasks[0];
+                reattach(step);
+                journal.record(TaskJournal::Add, *step.tasks[0], false);
+                break;
+            case HistoryStep::Advanced:
+                completedTasks.pop_back();
+                journal.record(TaskJournal::Delete, *step.tasks[0], true);
+                journal.record(TaskJournal::Delete, *step.series, false);
+                step.series->reschedule(step.tasks[0]->getDeadline());
+                journal.record(TaskJournal::Add, *step.series, false);
+                break;
+            case HistoryStep::Linked:
+            case HistoryStep::Unlinked:
+                relink(step, step.kind == HistoryStep::Unlinked);
+                break;
+            }
+        }
+
+        // Do a reverted step again
+        void reapply(HistoryStep &step)
+        {
+            switch (step.kind)
+            {
+            case HistoryStep::Added:
+                tasks.reserve(tasks.size() + step.tasks.size());
+                for (auto task : step.tasks)
+                {
+                    insertTask(task);
+                    journal.record(TaskJournal::Add, *task, false);
+                }
+                break;
+            case HistoryStep::AddedCompleted:
+                completedTasks.insert(completedTasks.end(), step.tasks.begin(), step.tasks.end());
+                for (auto task : step.tasks)
+                    journal.record(TaskJournal::Add, *task, true);
+                break;
+            case HistoryStep::Completed:
+                detach(step);
+                tasks.erase(tasks.begin() + step.position);
+                step.tasks[0]->markCompleted();
+                completedTasks.push_back(step.tasks[0]);
+                titleMap.erase(step.tasks[0]->getTitle());
+                journal.record(TaskJournal::Complete, *step.tasks[0], true);
+                break;
+            case HistoryStep::Deleted:
+                detach(step);
+                tasks.erase(tasks.begin() + step.position);
+                titleMap.erase(step.tasks[0]->getTitle());
+                journal.record(TaskJournal::Delete, *step.tasks[0], false);
+                break;
+            case HistoryStep::Advanced:
+            {
+                // The rule gives the same next deadline as the first time
+                std::string next;
+                step.series->nextDeadline(next);
+                advance(step.series, step.tasks[0], next);
+                break;
+            }
+            case HistoryStep::Linked:
+            case HistoryStep::Unlinked:
+                relink(step, step.kind == HistoryStep::Linked);
+                break;
+            }
+        }
+
+        // Make tasks[0] of a Linked or Unlinked step wait for tasks[1], or stop
+        // it. Either way round this undoes or redoes a change to the same
+        // graph, so a link cannot close a cycle here
+        void relink(const HistoryStep &step, bool wait)
+        {
+            DependencyGraph::Node then = dependencies.node(step.tasks[0]->getTitle());
+            DependencyGraph::Node first = dependencies.node(step.tasks[1]->getTitle());
+            if (wait)
+                dependencies.link(first, then);
+            else
+                dependencies.unlink(first, then);
+        }
+
+        // Take tasks[0] of a Completed or Deleted step out of the graph while
+        // it is still active, noting its edges in the step. A finished task
+        // holds nothing up, and one added later under its title starts afresh
+        void detach(HistoryStep &step)
+        {
+            step.prerequisites.clear();
+            step.dependents.clear();
+            DependencyGraph::Node n;
+            if (!dependencies.find(step.tasks[0]->getTitle(), n))
+                return;
+            std::vector<DependencyGraph::Node> prerequisites, dependents;
+            dependencies.detach(n, prerequisites, dependents);
+            for (auto p : prerequisites)
+            {
+                auto it = titleMap.find(dependencies.title(p));
+                if (it != titleMap.end())
+                    step.prerequisites.push_back(it->second);
+            }
+            for (auto d : dependents)
+            {
+                auto it = titleMap.find(dependencies.title(d));
+                if (it != titleMap.end())
+                    step.dependents.push_back(it->second);
+            }
+        }
+
+        // Give back the edges detach() took. The graph is as it was then, so
+        // none of them can close a cycle
+        void reattach(const HistoryStep &step)
+        {
+            DependencyGraph::Node n = dependencies.node(step.tasks[0]->getTitle());
+            for (auto p : step.prerequisites)
+                dependencies.link(dependencies.node(p->getTitle()), n);
+            for (auto d : step.dependents)
+                dependencies.link(n, dependencies.node(d->getTitle()));
+        }
+
+        // Whether a task of the graph waits for a task that is still active
+        bool waiting(DependencyGraph::Node n) const
+        {
+            for (auto p : dependencies.prerequisites(n))
+                if (titleMap.count(dependencies.title(p)))
+                    return true;
+            return false;
+        }
+
+        // Add an after= field listing the active tasks it waits for to the
+        // line of an active task. Finished ones are dropped, so a saved file
+        // never names a task it does not hold
+        void appendPrerequisites(const TaskBase &task, std::string &line) const
+        {
+            DependencyGraph::Node n;
+            if (!dependencies.find(task.getTitle(), n))
+                return;
+            std::string value;
+            for (auto p : dependencies.prerequisites(n))
+                if (titleMap.count(dependencies.title(p)))
+                    appendTitleList(value, dependencies.title(p));
+            if (!value.empty())
+                appendExtension(line, "after", value);
+        }
+
+        // Publish the container sizes; a few relaxed stores after each change
+        void updateGauges() const
+        {
+            metrics.active.set(static_cast<std::int64_t>(tasks.size()));
+            metrics.completed.set(static_cast<std::int64_t>(completedTasks.size()));
+            metrics.titleIndex.set(static_cast<std::int64_t>(titleMap.size()));
+            metrics.categories.set(static_cast<std::int64_t>(categories.size()));
+            metrics.dependencies.set(static_cast<std::int64_t>(dependencies.edgeCount()));
+        }
+
+    public:
+        // Destructor to clean up all dynamically allocated tasks
+        ~TaskManager()
+        {
+            for (auto t : tasks)
+                delete t;
+            for (auto t : completedTasks)
+                delete t;
+        }
+
+        // Add a task to the system
+        void addTask(TaskBase *task)
+        {
+            LatencyTimer timer(stats, OperationStats::Add);
+            TODO_ALLOC_SCOPE("add");
+            TaskBase *previous = insertTask(task);
+            journal.record(TaskJournal::Add, *task, false);
+            history.record(HistoryStep{HistoryStep::Added, {task}, previous ? std::vector<TaskBase *>{previous} : std::vector<TaskBase *>(), 0});
+            updateGauges();
+        }
+
+        // Add many tasks at once; storage grows once for the whole batch
+        void addTasks(const std::vector<TaskBase *> &batch)
+        {
+            LatencyTimer timer(stats, OperationStats::AddBatch);
+            TODO_ALLOC_SCOPE("add-batch");
+            if (batch.empty())
+                return;
+            tasks.reserve(tasks.size() + batch.size());
+            HistoryStep step{HistoryStep::Added, batch, {}, 0};
+            const std::string *lastCategory = nullptr;
+            for (std::size_t i = 0; i < batch.size(); ++i)
+            {
+                TaskBase *task = batch[i];
+                tasks.push_back(task);
+                TaskBase *&slot = titleMap[task->getTitle()];
+                if (slot)
+                {
+                    // Only a batch that replaces titles pays for the list
+                    if (step.shadowed.empty())
+                        step.shadowed.resize(batch.size());
+                    step.shadowed[i] = slot;
+                }
+                slot = task;
+                // Imports tend to repeat the same category row after row
+                const std::string &category = task->getCategory();
+                if (!category.empty() && (!lastCategory || *lastCategory != category))
+                {
+                    categories.insert(category);
+                    lastCategory = &category;
+                }
+            }
+            if (journal.enabled())
+                for (auto task : batch)
+                    journal.record(TaskJournal::Add, *task, false);
+            history.record(std::move(step));
+            updateGauges();
+        }
+
+        // Add tasks straight to the completed list
+        void addCompletedTasks(const std::vector<TaskBase *> &batch)
+        {
+            LatencyTimer timer(stats, OperationStats::AddCompleted);
+            TODO_ALLOC_SCOPE("add-completed");
+            if (batch.empty())
+                return;
+            completedTasks.insert(completedTasks.end(), batch.begin(), batch.end());
+            if (journal.enabled())
+                for (auto task : batch)
+                    journal.record(TaskJournal::Add, *task, true);
+            history.record(HistoryStep{HistoryStep::AddedCompleted, batch, {}, 0});
+            updateGauges();
+        }
+
+        // Display tasks, optionally sorted by deadline
+        void viewTasks(bool sorted = false) const
+        {
+            OutputBuffer out;
+            viewTasks(sorted, out);
+        }
+
+        // Render tasks into out, optionally sorted by deadline
+        void viewTasks(bool sorted, OutputBuffer &out) const
+        {
+            LatencyTimer timer(stats, sorted ? OperationStats::ViewSorted : OperationStats::View);
+            TODO_ALLOC_SCOPE(sorted ? "view-sorted" : "view");
+            TODO_TRACE_SPAN("viewTasks");
+            if (!sorted)
+            {
+                TODO_TRACE_SPAN("render");
+                for (const auto &t : tasks)
+                    t->render(out);
+                return;
+            }
+
+            // Each deadline is converted once rather than on every comparison
+            std::vector<std::pair<int, TaskBase *>> keyed;
+            {
+                TODO_TRACE_SPAN("deadlineKey");
+                keyed.reserve(tasks.size());
+                for (const auto &t : tasks)
+                    keyed.push_back(std::make_pair(deadlineKey(t->getDeadline()), t));
+            }
+            {
+                TODO_TRACE_SPAN("sort");
+                std::sort(keyed.begin(), keyed.end(), [](const std::pair<int, TaskBase *> &a, const std::pair<int, TaskBase *> &b)
+                          { return a.first < b.first; });
+            }
+            TODO_TRACE_SPAN("render");
+            for (const auto &k : keyed)
+                k.second->render(out);
+        }
+
+        // Page through tasks, rendering only the visible rows
+        void browseTasks(bool sorted = false, std::istream &in = std::cin) const
+        {
+            if (!sorted)
+            {
+                TaskListSource source(tasks);
+                Pager(source).run(in);
+                return;
+            }
+
+            // The sorted order is a list of pointers; each deadline is parsed once
+            std::vector<std::pair<int, TaskBase *>> keyed;
+            keyed.reserve(tasks.size());
+            for (const auto &t : tasks)
+                keyed.push_back(std::make_pair(deadlineKey(t->getDeadline()), t));
+            std::stable_sort(keyed.begin(), keyed.end(), [](const std::pair<int, TaskBase *> &a, const std::pair<int, TaskBase *> &b)
+                             { return a.first < b.first; });
+            std::vector<TaskBase *> ordered;
+            ordered.reserve(keyed.size());
+            for (const auto &k : keyed)
+                ordered.push_back(k.second);
+            keyed.clear();
+            keyed.shrink_to_fit();
+
+            TaskListSource source(ordered);
+            Pager(source).run(in);
+        }
+
+        // Display all completed tasks
+        void viewCompleted() const
+        {
+            LatencyTimer timer(stats, OperationStats::ViewCompleted);
+            TODO_ALLOC_SCOPE("view-completed");
+            OutputBuffer out;
+            for (const auto &t : completedTasks)
+                t->render(out);
+        }
+
+        // Mark task as completed by title, returns false if there is no such task
+        bool markCompleted(const std::string &title)
+        {
+            LatencyTimer timer(stats, OperationStats::Complete);
+            TODO_ALLOC_SCOPE("complete");
+            auto it = titleMap.find(title);
+            if (it == titleMap.end())
+            {
+                metrics.lookupMisses.add();
+                return false;
+            }
+            metrics.lookupHits.add();
+            TaskBase *task = it->second;
+            // A recurring task stays active unless its series has run out
+            RecurringTask *series = dynamic_cast<RecurringTask *>(task);
+            std::string next;
+            if (series && series->nextDeadline(next))
+            {
+                HistoryStep step{HistoryStep::Advanced, {series->doneOccurrence()}, {}, 0};
+                step.series = series;
+                advance(series, step.tasks[0], next);
+                history.record(std::move(step));
+                updateGauges();
+                return true;
+            }
+            auto position = std::find(tasks.begin(), tasks.end(), task);
+            HistoryStep step{HistoryStep::Completed, {task}, {}, static_cast<std::size_t>(position - tasks.begin())};
+            detach(step);
+            tasks.erase(position);
+            task->markCompleted();
+            completedTasks.push_back(task);
+            titleMap.erase(it);
+            journal.record(TaskJournal::Complete, *task, true);
+            history.record(std::move(step));
+            updateGauges();
+            return true;
+        }
+
+        // Delete a task by title, returns false if there is no such task
+        bool deleteTask(const std::string &title)
+        {
+            LatencyTimer timer(stats, OperationStats::Delete);
+            TODO_ALLOC_SCOPE("delete");
+            auto it = titleMap.find(title);
+            if (it == titleMap.end())
+            {
+                metrics.lookupMisses.add();
+                return false;
+            }
+            metrics.lookupHits.add();
+            // The task is kept by the history until the delete can no longer be undone
+            TaskBase *task = it->second;
+            auto position = std::find(tasks.begin(), tasks.end(), task);
+            HistoryStep step{HistoryStep::Deleted, {task}, {}, static_cast<std::size_t>(position - tasks.begin())};
+            detach(step);
+            tasks.erase(position);
+            titleMap.erase(it);
+            journal.record(TaskJournal::Delete, *task, false);
+            history.record(std::move(step));
+            updateGauges();
+            return true;
+        }
+
+        // Take back the newest add, complete, delete or group of them. Returns
+        // false when there is nothing to undo; what sets the description
+        bool undo(std::string *what = nullptr)
+        {
+            LatencyTimer timer(stats, OperationStats::Undo);
+            TODO_ALLOC_SCOPE("undo");
+            if (!history.canUndo())
+                return false;
+            bool first;
+            do
+            {
+                HistoryStep step = history.popDone();
+                revert(step);
+                first = !step.joinsPrevious;
+                if (first && what)
+                    *what = step.describe();
+                history.pushUndone(std::move(step));
+            } while (!first);
+            updateGauges();
+            return true;
+        }
+
+        // Do the last undone change again; false when there is nothing to redo
+        bool redo(std::string *what = nullptr)
+        {
+            LatencyTimer timer(stats, OperationStats::Redo);
+            TODO_ALLOC_SCOPE("redo");
+            if (!history.canRedo())
+                return false;
+            do
+            {
+                HistoryStep step = history.popUndone();
+                reapply(step);
+                if (!step.joinsPrevious && what)
+                    *what = step.describe();
+                history.pushDone(std::move(step));
+            } while (history.nextJoins());
+            updateGauges();
+            return true;
+        }
+
+        // Makes every change during its lifetime a single undo step, e.g. an import
+        class UndoGroup
+        {
+        private:
+            TaskManager &manager;
+
+        public:
+            UndoGroup(TaskManager &m, const char *label) : manager(m) { manager.history.beginGroup(label); }
+            ~UndoGroup() { manager.history.endGroup(); }
+
+            UndoGroup(const UndoGroup &) = delete;
+            UndoGroup &operator=(const UndoGroup &) = delete;
+        };
+
+        // Render the active tasks falling due from `from` to `to` in date order,
+        // a recurring task once per occurrence; return how many rows there were.
+        // Occurrences are worked out for this window only
+        std::size_t agenda(const Date &from, const Date &to, OutputBuffer &out) const
+        {
+            LatencyTimer timer(stats, OperationStats::Agenda);
+            TODO_ALLOC_SCOPE("agenda");
+            TODO_TRACE_SPAN("agenda");
+            AgendaQueue queue(from, to);
+            Date due;
+            for (std::size_t i = 0; i < tasks.size(); ++i)
+            {
+                if (!parseDate(tasks[i]->getDeadline(), due))
+                    continue;
+                const RecurringTask *series = dynamic_cast<const RecurringTask *>(tasks[i]);
+                queue.add(i, due, series ? &series->recurrence() : nullptr);
+            }
+            std::size_t rows = 0;
+            std::size_t i;
+            while (queue.next(i, due))
+            {
+                if (const RecurringTask *series = dynamic_cast<const RecurringTask *>(tasks[i]))
+                    series->renderAt(out, formatDeadline(due));
+                else
+                    tasks[i]->render(out);
+                ++rows;
+            }
+            return rows;
+        }
+
+        // Make task wait for prerequisite, both active tasks. Returns false if
+        // either is missing or prerequisite already waits for task, directly or
+        // through others; then cycle, if given, gets the titles of that chain
+        // from task to prerequisite, each waiting for the one before it
+        bool addDependency(const std::string &task, const std::string &prerequisite,
+                           std::vector<std::string> *cycle = nullptr)
+        {
+            LatencyTimer timer(stats, OperationStats::Depend);
+            TODO_ALLOC_SCOPE("depend");
+            if (cycle)
+                cycle->clear();
+            auto waits = titleMap.find(task), on = titleMap.find(prerequisite);
+            if (waits == titleMap.end() || on == titleMap.end())
+                return false;
+            std::vector<DependencyGraph::Node> chain;
+            DependencyGraph::Node then = dependencies.node(task), first = dependencies.node(prerequisite);
+            switch (dependencies.link(first, then, cycle ? &chain : nullptr))
+            {
+            case DependencyGraph::Cycle:
+                if (cycle)
+                    for (auto n : chain)
+                        cycle->push_back(dependencies.title(n));
+                return false;
+            case DependencyGraph::Linked:
+                history.record(HistoryStep{HistoryStep::Linked, {waits->second, on->second}, {}, 0});
+                updateGauges();
+                break;
+            default:
+                break;
+            }
+            return true;
+        }
+
+        // Stop task waiting for prerequisite; false if it did not
+        bool removeDependency(const std::string &task, const std::string &prerequisite)
+        {
+            LatencyTimer timer(stats, OperationStats::Depend);
+            TODO_ALLOC_SCOPE("depend");
+            DependencyGraph::Node then, first;
+            auto waits = titleMap.find(task), on = titleMap.find(prerequisite);
+            if (waits == titleMap.end() || on == titleMap.end() || !dependencies.find(task, then) ||
+                !dependencies.find(prerequisite, first) || !dependencies.unlink(first, then))
+                return false;
+            history.record(HistoryStep{HistoryStep::Unlinked, {waits->second, on->second}, {}, 0});
+            updateGauges();
+            return true;
+        }
+
+        // Render the active tasks that wait for no other active task, in list
+        // order; return how many there were
+        std::size_t viewReady(OutputBuffer &out) const
+        {
+            LatencyTimer timer(stats, OperationStats::Ready);
+            TODO_ALLOC_SCOPE("ready");
+            TODO_TRACE_SPAN("viewReady");
+            // The graph is usually far smaller than the list, so the blocked
+            // tasks are found from it and the list is only checked against them
+            std::unordered_set<const TaskBase *> blocked;
+            dependencies.forEachInOrder([&](DependencyGraph::Node n)
+                                        {
+                auto it = titleMap.find(dependencies.title(n));
+                if (it != titleMap.end() && waiting(n))
+                    blocked.insert(it->second); });
+            std::size_t rows = 0;
+            for (const auto &t : tasks)
+            {
+                if (blocked.count(t))
+                    continue;
+                t->render(out);
+                ++rows;
+            }
+            return rows;
+        }
+
+        // Render the active tasks that wait for or hold up another active task
+        // so that each comes after everything it waits for; return how many
+        // there were. The graph keeps that order, so nothing is sorted here
+        std::size_t viewPlan(OutputBuffer &out) const
+        {
+            LatencyTimer timer(stats, OperationStats::Plan);
+            TODO_ALLOC_SCOPE("plan");
+            std::size_t rows = 0;
+            dependencies.forEachInOrder([&](DependencyGraph::Node n)
+                                        {
+                auto it = titleMap.find(dependencies.title(n));
+                if (it == titleMap.end())
+                    return;
+                bool linked = waiting(n);
+                for (auto d : dependencies.dependents(n))
+                    linked = linked || titleMap.count(dependencies.title(d)) > 0;
+                if (!linked)
+                    return;
+                it->second->render(out);
+                ++rows; });
+            return rows;
+        }
+
+        // Search for a task by keyword
+        void searchTask(const std::string &query) const
+        {
+            OutputBuffer out;
+            searchTask(query, out);
+        }
+
+        // Render matching tasks into out and return how many matched
+        std::size_t searchTask(const std::string &query, OutputBuffer &out) const
+        {
+            LatencyTimer timer(stats, OperationStats::Search);
+            TODO_ALLOC_SCOPE("search");
+            TODO_TRACE_SPAN("searchTask");
+            std::size_t matches = 0;
+            for (const auto &t : tasks)
+            {
+                if (t->getTitle().find(query) != std::string::npos)
+                {
+                    t->render(out);
+                    ++matches;
+                }
+            }
+            return matches;
+        }
+
+        // Filter tasks by category
+        void filterByCategory(const std::string &category) const
+        {
+            OutputBuffer out;
+            filterByCategory(category, out);
+        }
+
+        // Render the category list and matching tasks into out, return how many matched
+        std::size_t filterByCategory(const std::string &category, OutputBuffer &out) const
+        {
+            LatencyTimer timer(stats, OperationStats::FilterCategory);
+            TODO_ALLOC_SCOPE("filter-category");
+            TODO_TRACE_SPAN("filterByCategory");
+            out.append(std::string("Available categories to choose from:\n"));
+            for (const auto &cat : categories)
+            {
+                out.append(" - ", 3);
+                out.append(cat);
+                out.append('\n');
+            }
+            out.append("\nShowing tasks for category: " + category + "\n");
+            std::size_t matches = 0;
+            for (const auto &t : tasks)
+            {
+                if (t->getCategory() == category)
+                {
+                    t->render(out);
+                    ++matches;
+                }
+            }
+            return matches;
+        }
+
+        // List all unique categories
+        void listAllCategories() const
+        {
+            OutputBuffer out;
+            listAllCategories(out);
+        }
+
+        // Render the category list into out and return how many there are
+        std::size_t listAllCategories(OutputBuffer &out) const
+        {
+            LatencyTimer timer(stats, OperationStats::ListCategories);
+            TODO_ALLOC_SCOPE("list-categories");
+            out.append(std::string("Available categories:\n"));
+            for (const auto &cat : categories)
+            {
+                out.append(" - ", 3);
+                out.append(cat);
+                out.append('\n');
+            }
+            return categories.size();
+        }
+
+        // Call visit(task, completed) for every active, then every completed task
+        template <class Visit>
+        void forEachTask(Visit visit) const
+        {
+            for (const auto &t : tasks)
+                visit(*t, false);
+            for (const auto &t : completedTasks)
+                visit(*t, true);
+        }
+
+        // Write active and completed tasks as JSON (an array) or NDJSON
+        void exportJson(OutputBuffer &out, bool ndjson) const
+        {
+            LatencyTimer timer(stats, OperationStats::ExportJson);
+            TODO_ALLOC_SCOPE("export-json");
+            JsonTaskWriter writer(out, ndjson);
+            // repeat is the rule as the task file stores it
+            auto write = [&writer](const TaskBase *t, bool completed)
+            {
+                const RecurringTask *series = dynamic_cast<const RecurringTask *>(t);
+                writer.write(t->getTitle(), t->getDeadline(), t->getCategory(), !t->getCategory().empty(), completed,
+                             series ? series->recurrence().field() : std::string());
+            };
+            for (const auto &t : tasks)
+                write(t, false);
+            for (const auto &t : completedTasks)
+                write(t, true);
+            writer.finish();
+        }
+
+        // Export to a file, returns false if it could not be written
+        bool exportJson(const std::string &filename, bool ndjson) const
+        {
+            OutputBuffer out(filename);
+            if (!out.isOpen())
+                return false;
+            exportJson(out, ndjson);
+            out.flush();
+            return !out.hasFailed();
+        }
+
+        // Write active and completed tasks as an iCalendar file of VTODOs
+        void exportIcal(OutputBuffer &out) const
+        {
+            LatencyTimer timer(stats, OperationStats::ExportIcal);
+            TODO_ALLOC_SCOPE("export-ics");
+            IcalWriter writer(out);
+            for (const auto &t : tasks)
+            {
+                const RecurringTask *series = dynamic_cast<const RecurringTask *>(t);
+                writer.write(t->getTitle(), t->getDeadline(), t->getCategory(), false, series ? &series->recurrence() : nullptr);
+            }
+            for (const auto &t : completedTasks)
+                writer.write(t->getTitle(), t->getDeadline(), t->getCategory(), true);
+            writer.finish();
+        }
+
+        // Export to a file, returns false if it could not be written
+        bool exportIcal(const std::string &filename) const
+        {
+            OutputBuffer out(filename);
+            if (!out.isOpen())
+                return false;
+            exportIcal(out);
+            out.flush();
+            return !out.hasFailed();
+        }
+
+        // Latency histograms of the operations run so far
+        const OperationStats &operationStats() const { return stats; }
+
+        // Record every later change with its time, to be appended to the journal
+        // of the file the tasks are saved to (see time_travel.h)
+        void enableJournal(long keepDays = TaskJournal::defaultRetentionDays) { journal.enable(keepDays); }
+
+        // Count hardware events per operation with these counters (nullptr stops)
+        void attachPerfCounters(const PerfCounters *counters) { stats.attach(counters); }
+
+        // Save current tasks to file
+        void saveToFile(const std::string &filename)
+        {
+            LatencyTimer timer(stats, OperationStats::Save);
+            TODO_ALLOC_SCOPE("save");
+            TODO_TRACE_SPAN("saveToFile");
+            // The deadline index of the old contents must not outlive them
+            DeadlineIndex::invalidate(filename);
+            std::ofstream ofs(filename);
+            std::uint64_t bytes = 0;
+            {
+                TODO_TRACE_SPAN("write active");
+                for (const auto &t : tasks)
+                {
+                    std::string line = t->toFileString();
+                    if (!dependencies.empty())
+                        appendPrerequisites(*t, line);
+                    ofs << line << std::endl;
+                    bytes += line.size() + 1;
+                }
+            }
+            TODO_TRACE_SPAN("write completed");
+            for (const auto &t : completedTasks)
+            {
+                std::string line = t->toFileString();
+                ofs << "DONE:" << line << std::endl;
+                bytes += line.size() + 6;
+            }
+            ofs.close();
+            if (!ofs)
+                return;
+            metrics.bytesSaved.add(bytes);
+            // The journal follows the file, so it never describes a save that failed
+            journal.flush(filename);
+        }
+
+        // Load tasks from file. The file is taken in large blocks, and each block
+        // goes through the same phases: split the lines, create the tasks, index them.
+        // With timings, the time of each phase is added up there
+        void loadFromFile(const std::string &filename, LoadTimings *timings = nullptr)
+        {
+            LatencyTimer timer(stats, OperationStats::Load);
+            TODO_ALLOC_SCOPE("load");
+            TODO_TRACE_SPAN("loadFromFile");
+            LoadTimings unused;
+            LoadTimings &t = timings ? *timings : unused;
+            auto mark = std::chrono::steady_clock::now();
+            auto lap = [&mark](std::chrono::steady_clock::duration &phase)
+            {
+                auto now = std::chrono::steady_clock::now();
+                phase += now - mark;
+                mark = now;
+            };
+
+            std::FILE *file = std::fopen(filename.c_str(), "rb");
+            lap(t.open);
+            if (!file)
+                return;
+
+            std::vector<char> block(1 << 20);
+            std::string pending; // Unparsed bytes: the last partial line plus the new block
+            std::vector<TaskRecord> records;
+            std::vector<TaskBase *> created;
+            std::vector<std::pair<std::string, std::string>> waits; // (title, after= value) of active tasks
+            bool atEof = false;
+            while (!atEof)
+            {
+                {
+                    TODO_TRACE_SPAN("read");
+                    std::size_t n = std::fread(block.data(), 1, block.size(), file);
+                    atEof = n == 0;
+                    pending.append(block.data(), n);
+                    t.bytes += n;
+                }
+                lap(t.read);
+
+                std::string_view rest(pending);
+                {
+                    TODO_TRACE_SPAN("parse");
+                    TODO_ALLOC_SCOPE("load.parse");
+                    records.clear();
+                    while (!rest.empty())
+                    {
+                        std::size_t newline = rest.find('\n');
+                        if (newline == std::string_view::npos && !atEof)
+                            break; // The rest of this line comes with the next block
+                        TaskRecord record;
+                        parseTaskLine(rest.substr(0, newline), record);
+                        records.push_back(record);
+                        rest.remove_prefix(newline == std::string_view::npos ? rest.size() : newline + 1);
+                    }
+                    t.lines += records.size();
+                    metrics.loaded.add(records.size());
+                }
+                lap(t.parse);
+
+                {
+                    TODO_TRACE_SPAN("construct");
+                    TODO_ALLOC_SCOPE("load.construct");
+                    created.clear();
+                    RecurrenceRule rule;
+                    std::string_view repeat, after;
+                    for (const auto &r : records)
+                    {
+                        std::string title(r.title), deadline(r.deadline);
+                        if (!r.done && r.extension("after", after))
+                            waits.emplace_back(title, std::string(after));
+                        if (r.extension("repeat", repeat) && rule.parseField(repeat))
+                            created.push_back(new RecurringTask(title, deadline, std::string(r.category), rule, r.completed()));
+                        else if (r.categorized())
+                            created.push_back(new CategorizedTask(title, deadline, std::string(r.category), r.completed()));
+                        else
+                            created.push_back(new Task(title, deadline, r.completed()));
+                    }
+                }
+                lap(t.construct);
+
+                {
+                    TODO_TRACE_SPAN("index");
+                    TODO_ALLOC_SCOPE("load.index");
+                    for (std::size_t i = 0; i < records.size(); ++i)
+                    {
+                        if (records[i].done)
+                            completedTasks.push_back(created[i]);
+                        else
+                            insertTask(created[i]);
+                    }
+                }
+                lap(t.index);
+
+                pending.erase(0, pending.size() - rest.size());
+            }
+            std::fclose(file);
+            lap(t.read);
+
+            // All edges go in with a single sort once every task is known. A
+            // hand-edited file that closes a cycle loses the edges that close
+            // it, and one that names a task that is not active loses that name
+            if (!waits.empty())
+            {
+                TODO_TRACE_SPAN("dependencies");
+                std::vector<std::pair<DependencyGraph::Node, DependencyGraph::Node>> edges;
+                std::vector<std::string> prerequisites;
+                for (const auto &w : waits)
+                {
+                    DependencyGraph::Node then = dependencies.node(w.first);
+                    splitTitleList(w.second, prerequisites);
+                    for (const auto &p : prerequisites)
+                        if (titleMap.count(p))
+                            edges.push_back(std::make_pair(dependencies.node(p), then));
+                }
+                dependencies.linkAll(edges);
+                lap(t.index);
+            }
+            updateGauges();
+        }
+    };
+
+} // namespace todo
+
+#endif
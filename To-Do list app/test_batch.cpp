@@ -0,0 +1,61 @@
+// Tests for batch scripts: a bad line fails on its own without ending the
+// run, and a sorted view copes with deadlines that were never valid
+
+#include <sstream>
+#include <string>
+#include "batch.h"
+#include "test_check.h"
+
+using namespace todo;
+
+namespace
+{
+    bool has(const std::string &text, const std::string &part)
+    {
+        return text.find(part) != std::string::npos;
+    }
+}
+
+int main()
+{
+    // A deadline that is not a date is refused; valid ones are stored as DD.MM.YYYY
+    {
+        TaskManager manager;
+        BatchResult result;
+        {
+            OutputBuffer out("batch.txt");
+            BatchRunner runner(manager, out);
+            std::istringstream script("add X;garbage\n"
+                                      "add Y;1.2.2027;Work\n"
+                                      "add Z;2027-01-15\n"
+                                      "add W;31.02.2027\n"
+                                      "view sorted\n");
+            result = runner.run(script);
+        }
+        std::string text = test::readFile("batch.txt");
+        CHECK(result.commands == 5 && result.failures == 2);
+        CHECK(has(text, "1: error: invalid deadline \"garbage\" for \"X\"\n"));
+        CHECK(has(text, "4: error: invalid deadline \"31.02.2027\" for \"W\"\n"));
+        CHECK(text.find("15.01.2027") < text.find("01.02.2027"));
+        CHECK(has(text, "5: viewed sorted\n"));
+        manager.saveToFile("tasks.txt");
+        CHECK(test::readFile("tasks.txt") == "Y;01.02.2027;0;Work\nZ;15.01.2027;0\n");
+    }
+
+    // A file written before deadlines were checked sorts its bad lines last
+    test::writeFile("tasks.txt", "Bad;tomorrow;0\nGood;01.01.2027;0\nWorse;1..2027;0\n");
+    {
+        TaskManager manager;
+        manager.loadFromFile("tasks.txt");
+        {
+            OutputBuffer out("sorted.txt");
+            BatchRunner runner(manager, out);
+            std::istringstream script("view sorted\n");
+            CHECK(runner.run(script).failures == 0);
+        }
+        std::string text = test::readFile("sorted.txt");
+        CHECK(text.find("Good") < text.find("Bad") && text.find("Good") < text.find("Worse"));
+    }
+
+    return test::testResult("batch");
+}
@@ -0,0 +1,59 @@
+#ifndef TODO_TEST_CHECK_H
+#define TODO_TEST_CHECK_H
+
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+// Minimal checks for the test_*.cpp programs that `make test` builds and
+// runs. CHECK reports the failed expression with its place and carries on;
+// testResult() prints a summary and gives the exit status
+
+#define CHECK(condition) todo::test::check((condition), #condition, __FILE__, __LINE__)
+
+namespace todo
+{
+    namespace test
+    {
+
+        inline int &failures()
+        {
+            static int count = 0;
+            return count;
+        }
+
+        inline bool check(bool ok, const char *expression, const char *file, int line)
+        {
+            if (!ok)
+            {
+                ++failures();
+                std::cerr << file << ":" << line << ": CHECK failed: " << expression << "\n";
+            }
+            return ok;
+        }
+
+        inline int testResult(const char *name)
+        {
+            std::cout << name << ": " << (failures() == 0 ? "ok" : std::to_string(failures()) + " failed") << "\n";
+            return failures() == 0 ? 0 : 1;
+        }
+
+        inline void writeFile(const std::string &filename, const std::string &text)
+        {
+            std::ofstream out(filename, std::ios::binary | std::ios::trunc);
+            out << text;
+        }
+
+        inline std::string readFile(const std::string &filename)
+        {
+            std::ifstream in(filename, std::ios::binary);
+            std::ostringstream text;
+            text << in.rdbuf();
+            return text.str();
+        }
+
+    } // namespace test
+} // namespace todo
+
+#endif
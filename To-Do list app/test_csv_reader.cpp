@@ -0,0 +1,95 @@
+// Tests for CSV import: quoted fields that hold delimiters, quotes and line
+// breaks, across block boundaries, and --map values that are not usable
+
+#include <string>
+#include <vector>
+#include "csv_import.h"
+#include "csv_reader.h"
+#include "test_check.h"
+
+using namespace todo;
+
+namespace
+{
+    const std::string file = "tasks.csv";
+
+    // Every row of file as strings, with the line each row started on
+    std::vector<std::vector<std::string>> readAll(std::size_t blockSize, std::vector<std::size_t> &lines)
+    {
+        std::vector<std::vector<std::string>> rows;
+        lines.clear();
+        CsvReader reader(',', blockSize);
+        if (!reader.open(file))
+            return rows;
+        std::vector<std::string_view> fields;
+        while (reader.nextRow(fields))
+        {
+            rows.emplace_back(fields.begin(), fields.end());
+            lines.push_back(reader.lineNumber());
+        }
+        return rows;
+    }
+}
+
+int main()
+{
+    test::writeFile(file, "title,deadline\r\n"
+                          "\"Buy milk, eggs\",01.05.2027\r\n"
+                          "\"Call \"\"Bob\"\"\nabout the\r\nparty\",02.05.2027\n"
+                          "Plain,03.05.2027\n"
+                          "\"\",\n"
+                          "Last,04.05.2027");
+
+    // Block sizes small enough to split quotes and line ends give the same rows
+    for (std::size_t blockSize : {std::size_t(1), std::size_t(3), std::size_t(7), std::size_t(1) << 20})
+    {
+        std::vector<std::size_t> lines;
+        auto rows = readAll(blockSize, lines);
+        CHECK(rows.size() == 6);
+        if (rows.size() != 6)
+            continue;
+        CHECK((rows[0] == std::vector<std::string>{"title", "deadline"}));
+        CHECK((rows[1] == std::vector<std::string>{"Buy milk, eggs", "01.05.2027"}));
+        CHECK((rows[2] == std::vector<std::string>{"Call \"Bob\"\nabout the\r\nparty", "02.05.2027"}));
+        CHECK((rows[3] == std::vector<std::string>{"Plain", "03.05.2027"}));
+        CHECK((rows[4] == std::vector<std::string>{"", ""}));
+        CHECK((rows[5] == std::vector<std::string>{"Last", "04.05.2027"}));
+        CHECK((lines == std::vector<std::size_t>{1, 2, 3, 6, 7, 8}));
+    }
+
+    // The row with line breaks in its title is rejected by the line it starts on
+    {
+        TaskManager manager;
+        CsvImportOptions options;
+        ImportResult result = CsvImporter(options).run(file, manager);
+        CHECK(result.opened);
+        CHECK(result.imported == 3);
+        CHECK(result.rejected == 2);
+        CHECK(!result.errors.empty() && result.errors[0].compare(0, 7, "line 3:") == 0);
+    }
+
+    // Column positions: in range, 0, and beyond an int
+    {
+        CsvImportOptions options;
+        CHECK(options.setMapping("title=2,deadline=Due"));
+        CHECK(options.titleColumn == "2" && options.deadlineColumn == "Due");
+        CHECK(!CsvImportOptions().setMapping("title=0"));
+        CHECK(!CsvImportOptions().setMapping("title=99999999999999999999"));
+        CHECK(!CsvImportOptions().setMapping("deadline=2147483648"));
+        CHECK(CsvImportOptions().setMapping("deadline=2147483647"));
+        CHECK(!CsvImportOptions().setMapping("owner=1"));
+    }
+
+    // A huge position that reaches the importer finds no column
+    {
+        TaskManager manager;
+        CsvImportOptions options;
+        options.header = false;
+        options.titleColumn = "99999999999999999999";
+        ImportResult result = CsvImporter(options).run(file, manager);
+        CHECK(result.imported == 0);
+        CHECK(!result.errors.empty() && result.errors[0] == "no column for title");
+    }
+
+    return test::testResult("csv_reader");
+}
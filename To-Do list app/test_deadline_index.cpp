@@ -0,0 +1,94 @@
+// Tests for the deadline index behind the one-shot `next` command: it must
+// never answer from an index made for other contents of the task file
+
+#include <chrono>
+#include <string>
+#include <thread>
+#include "deadline_index.h"
+#include "oneshot.h"
+#include "task_manager.h"
+#include "test_check.h"
+
+using namespace todo;
+
+namespace
+{
+    const std::string file = "tasks.txt";
+
+    // 400 active tasks due in 2027 with `early` in the middle, then 400 done ones
+    std::string tasks(const std::string &early)
+    {
+        std::string text;
+        for (int i = 0; i < 400; ++i)
+        {
+            char line[64];
+            std::snprintf(line, sizeof(line), "Task%04d;%02d.05.2027;0;Work\n", i, i % 28 + 1);
+            text += line;
+            if (i == 200)
+                text += early + "\n";
+        }
+        for (int i = 0; i < 400; ++i)
+            text += "DONE:Old" + std::to_string(i) + ";01.01.2025;1\n";
+        return text;
+    }
+
+    std::string firstTitle()
+    {
+        std::vector<std::string> lines = DeadlineIndex::earliest(file, 3);
+        return lines.empty() ? std::string() : lines[0].substr(0, lines[0].find(';'));
+    }
+
+    // File times are coarse on some file systems; wait so a rewrite gets a new one
+    void tick() { std::this_thread::sleep_for(std::chrono::milliseconds(20)); }
+}
+
+int main()
+{
+    test::writeFile(file, tasks("Early1;01.01.2026;0"));
+    CHECK(firstTitle() == "Early1");
+    CHECK(firstTitle() == "Early1"); // Now from the index
+
+    // Same size, different middle: the first and last blocks hash the same
+    tick();
+    std::string before = tasks("Early1;01.01.2026;0");
+    std::string after = tasks("Early2;01.01.2026;0");
+    CHECK(before.size() == after.size());
+    test::writeFile(file, after);
+    CHECK(firstTitle() == "Early2");
+
+    // The same through a batch-style delete and add, saved by TaskManager
+    {
+        TaskManager manager;
+        manager.loadFromFile(file);
+        CHECK(manager.deleteTask("Early2"));
+        manager.addTask(new Task("Early3", "01.01.2026"));
+        manager.saveToFile(file);
+    }
+    CHECK(test::readFile(file).size() == after.size());
+    CHECK(firstTitle() == "Early3");
+
+    // A one-shot add keeps the index and only the appended line is scanned
+    CHECK(firstTitle() == "Early3");
+    tick();
+    char *args[] = {const_cast<char *>("Earliest"), const_cast<char *>("01.01.2024")};
+    CHECK(addCommand(file, 2, args) == 0);
+    CHECK(firstTitle() == "Earliest");
+
+    // A deadline that is not a date never reaches the file
+    std::string kept = test::readFile(file);
+    char *bad[] = {const_cast<char *>("Pay rent"), const_cast<char *>("tomorrow")};
+    CHECK(addCommand(file, 2, bad) == 2);
+    CHECK(test::readFile(file) == kept);
+    char *iso[] = {const_cast<char *>("Pay rent"), const_cast<char *>("2027-02-01")};
+    CHECK(addCommand(file, 2, iso) == 0);
+    CHECK(test::readFile(file) == kept + "Pay rent;01.02.2027;0\n");
+
+    // An index without the matching identity is not trusted after a later edit
+    tick();
+    std::string text = test::readFile(file);
+    text.replace(text.find("Earliest"), 8, "Earliezt");
+    test::writeFile(file, text);
+    CHECK(firstTitle() == "Earliezt");
+
+    return test::testResult("deadline_index");
+}
@@ -0,0 +1,188 @@
+// Tests for task dependencies: the graph must keep a valid order and find
+// every cycle as edges come and go, and a finished task must not hold up or
+// be held up by anything, nor come back to life under its title
+
+#include <random>
+#include <set>
+#include <string>
+#include "dependency_graph.h"
+#include "task_manager.h"
+#include "test_check.h"
+
+using namespace todo;
+
+namespace
+{
+    const std::string file = "tasks.txt";
+
+    // Edges as a plain adjacency list, to check the graph against
+    struct Model
+    {
+        std::vector<std::set<DependencyGraph::Node>> after;
+
+        bool reaches(DependencyGraph::Node from, DependencyGraph::Node to) const
+        {
+            std::vector<DependencyGraph::Node> stack{from};
+            std::vector<bool> seen(after.size());
+            while (!stack.empty())
+            {
+                DependencyGraph::Node n = stack.back();
+                stack.pop_back();
+                if (n == to)
+                    return true;
+                if (seen[n])
+                    continue;
+                seen[n] = true;
+                stack.insert(stack.end(), after[n].begin(), after[n].end());
+            }
+            return false;
+        }
+    };
+
+    // Random links, unlinks and detaches on small graphs, checked after each
+    void randomized()
+    {
+        std::mt19937 random(5);
+        for (int round = 0; round < 200; ++round)
+        {
+            std::uint32_t n = 2 + random() % 40;
+            DependencyGraph graph;
+            Model model;
+            model.after.resize(n);
+            for (std::uint32_t i = 0; i < n; ++i)
+                graph.node("t" + std::to_string(i));
+            for (std::uint32_t step = 0; step < n * 4; ++step)
+            {
+                DependencyGraph::Node a = random() % n, b = random() % n;
+                switch (random() % 8)
+                {
+                case 0:
+                    CHECK(graph.unlink(a, b) == (model.after[a].erase(b) == 1));
+                    break;
+                case 1:
+                {
+                    std::vector<DependencyGraph::Node> prerequisites, dependents;
+                    graph.detach(a, prerequisites, dependents);
+                    CHECK(dependents.size() == model.after[a].size());
+                    model.after[a].clear();
+                    for (auto &out : model.after)
+                        out.erase(a);
+                    CHECK(graph.prerequisites(a).empty() && graph.dependents(a).empty());
+                    break;
+                }
+                default:
+                {
+                    std::vector<DependencyGraph::Node> cycle;
+                    DependencyGraph::Result result = graph.link(a, b, &cycle);
+                    CHECK((result == DependencyGraph::Cycle) == (a == b || model.reaches(b, a)));
+                    if (result == DependencyGraph::Cycle && a != b)
+                    {
+                        CHECK(cycle.front() == b && cycle.back() == a);
+                        for (std::size_t i = 0; i + 1 < cycle.size(); ++i)
+                            CHECK(model.after[cycle[i]].count(cycle[i + 1]) == 1);
+                    }
+                    if (result == DependencyGraph::Linked)
+                        model.after[a].insert(b);
+                    break;
+                }
+                }
+                std::vector<std::uint32_t> place(n);
+                std::uint32_t next = 0;
+                graph.forEachInOrder([&](DependencyGraph::Node x)
+                                     { place[x] = next++; });
+                CHECK(next == n);
+                std::size_t edges = 0;
+                for (DependencyGraph::Node x = 0; x < n; ++x)
+                {
+                    edges += model.after[x].size();
+                    for (auto y : model.after[x])
+                        CHECK(place[x] < place[y]);
+                }
+                CHECK(graph.edgeCount() == edges);
+            }
+        }
+    }
+
+    std::string ready(TaskManager &manager)
+    {
+        {
+            OutputBuffer out("ready.txt");
+            manager.viewReady(out);
+        }
+        return test::readFile("ready.txt");
+    }
+
+    bool lists(const std::string &text, const std::string &title)
+    {
+        return text.find(title) != std::string::npos;
+    }
+}
+
+int main()
+{
+    randomized();
+
+    // Delete then depend: the deleted task's edge must not make a cycle
+    {
+        TaskManager manager;
+        manager.addTask(new Task("Write report", "01.06.2027"));
+        manager.addTask(new Task("Gather data", "01.05.2027"));
+        CHECK(manager.addDependency("Write report", "Gather data"));
+        CHECK(manager.deleteTask("Gather data"));
+        manager.addTask(new Task("Gather data", "01.05.2027"));
+        CHECK(manager.addDependency("Gather data", "Write report"));
+        std::string text = ready(manager);
+        CHECK(lists(text, "Write report") && !lists(text, "Gather data"));
+    }
+
+    // Complete, then add the same title: the new task holds nothing up, and
+    // the file names no finished prerequisite
+    {
+        TaskManager manager;
+        manager.addTask(new Task("Write report", "01.06.2027"));
+        manager.addTask(new Task("Gather data", "01.05.2027"));
+        CHECK(manager.addDependency("Write report", "Gather data"));
+        CHECK(!lists(ready(manager), "Write report"));
+        CHECK(manager.markCompleted("Gather data"));
+        manager.addTask(new Task("Gather data", "01.07.2027"));
+        CHECK(lists(ready(manager), "Write report"));
+        manager.saveToFile(file);
+        CHECK(!lists(test::readFile(file), "after="));
+    }
+
+    // Undo gives a finished task its edges back, redo takes them away again
+    {
+        TaskManager manager;
+        manager.addTask(new Task("Write report", "01.06.2027"));
+        manager.addTask(new Task("Gather data", "01.05.2027"));
+        manager.addTask(new Task("Send report", "01.08.2027"));
+        CHECK(manager.addDependency("Write report", "Gather data"));
+        CHECK(manager.addDependency("Send report", "Write report"));
+        CHECK(manager.deleteTask("Write report"));
+        CHECK(lists(ready(manager), "Send report"));
+        CHECK(manager.undo());
+        std::string text = ready(manager);
+        CHECK(!lists(text, "Write report") && !lists(text, "Send report"));
+        CHECK(manager.redo());
+        CHECK(lists(ready(manager), "Send report"));
+        CHECK(manager.undo());
+        CHECK(manager.markCompleted("Gather data"));
+        CHECK(lists(ready(manager), "Write report"));
+        CHECK(manager.undo());
+        CHECK(!lists(ready(manager), "Write report"));
+        manager.saveToFile(file);
+        CHECK(lists(test::readFile(file), "after=Gather data"));
+    }
+
+    // A file that names a finished task as a prerequisite does not block
+    {
+        test::writeFile(file, "Write report;01.06.2027;0;;after=Gather data\nDONE:Gather data;01.05.2027;1\n");
+        TaskManager manager;
+        manager.loadFromFile(file);
+        CHECK(lists(ready(manager), "Write report"));
+        manager.addTask(new Task("Gather data", "01.07.2027"));
+        CHECK(lists(ready(manager), "Write report"));
+    }
+
+    return test::testResult("dependency_graph");
+}
@@ -0,0 +1,174 @@
+// Tests for undo and redo: each change comes back and goes again as it was,
+// and every task is freed exactly once, whether the manager holds it or a
+// step of the history does. Heap blocks are counted by replacing the global
+// operator new, so a leak or a double delete shows up as a changed count
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include "task_manager.h"
+#include "test_check.h"
+
+namespace
+{
+    std::atomic<long> liveBlocks{0};
+}
+
+void *operator new(std::size_t size)
+{
+    void *p = std::malloc(size ? size : 1);
+    if (!p)
+        throw std::bad_alloc();
+    ++liveBlocks;
+    return p;
+}
+
+void operator delete(void *p) noexcept
+{
+    if (!p)
+        return;
+    --liveBlocks;
+    std::free(p);
+}
+
+void operator delete(void *p, std::size_t) noexcept { operator delete(p); }
+
+using namespace todo;
+
+namespace
+{
+    std::size_t found(TaskManager &manager, const std::string &query)
+    {
+        OutputBuffer out("found.txt");
+        return manager.searchTask(query, out);
+    }
+
+    // Heap blocks a scenario leaves behind (or freed twice, when negative)
+    template <class Scenario>
+    long leftOver(Scenario scenario)
+    {
+        long before = liveBlocks.load();
+        scenario();
+        return liveBlocks.load() - before;
+    }
+
+    // Added, then undone, then dropped from the redo stack by a new change
+    void undoneAdd()
+    {
+        TaskManager manager;
+        manager.addTask(new Task("First", "01.05.2027"));
+        manager.addTask(new CategorizedTask("Second", "02.05.2027", "Work"));
+        CHECK(manager.undo());
+        CHECK(found(manager, "Second") == 0);
+        CHECK(manager.redo());
+        CHECK(found(manager, "Second") == 1);
+        CHECK(manager.undo());
+        manager.addTask(new Task("Third", "03.05.2027"));
+        CHECK(!manager.redo());
+        CHECK(found(manager, "First") == 1 && found(manager, "Third") == 1);
+    }
+
+    // Deleted and completed tasks moving between the lists and the history
+    void deleteAndComplete()
+    {
+        TaskManager manager;
+        manager.addTask(new Task("Keep", "01.05.2027"));
+        manager.addTask(new Task("Drop", "02.05.2027"));
+        manager.addTask(new Task("Finish", "03.05.2027"));
+        CHECK(manager.deleteTask("Drop"));
+        CHECK(manager.markCompleted("Finish"));
+        CHECK(found(manager, "Finish") == 0);
+        CHECK(manager.undo());
+        CHECK(found(manager, "Finish") == 1);
+        CHECK(manager.undo());
+        CHECK(found(manager, "Drop") == 1);
+        CHECK(manager.redo());
+        CHECK(manager.redo());
+        CHECK(found(manager, "Drop") == 0 && found(manager, "Finish") == 0);
+        CHECK(manager.undo()); // Finish back, Drop still held by the history
+    }
+
+    // A title added twice: undo points the title back at the first task
+    void shadowedTitle()
+    {
+        TaskManager manager;
+        manager.addTask(new Task("Same", "01.05.2027"));
+        manager.addTask(new Task("Same", "02.05.2027"));
+        CHECK(manager.undo());
+        CHECK(manager.deleteTask("Same"));
+        CHECK(found(manager, "Same") == 0);
+        CHECK(manager.undo());
+        CHECK(found(manager, "Same") == 1);
+    }
+
+    // A recurring task completed: the done occurrence belongs to the history
+    // once undone, and the series moves back to its old deadline
+    void recurring()
+    {
+        TaskManager manager;
+        RecurrenceRule rule;
+        CHECK(rule.parse("weekly", "01.05.2027"));
+        manager.addTask(new RecurringTask("Water plants", "01.05.2027", "", rule));
+        CHECK(manager.markCompleted("Water plants"));
+        manager.saveToFile("tasks.txt");
+        CHECK(test::readFile("tasks.txt").find("Water plants;08.05.2027") != std::string::npos);
+        CHECK(test::readFile("tasks.txt").find("DONE:Water plants;01.05.2027") != std::string::npos);
+        CHECK(manager.undo());
+        manager.saveToFile("tasks.txt");
+        CHECK(test::readFile("tasks.txt").find("DONE:") == std::string::npos);
+        CHECK(manager.redo());
+        CHECK(manager.undo());
+        manager.addTask(new Task("Other", "01.06.2027"));
+    }
+
+    // An import in chunks undoes as one change
+    void group()
+    {
+        TaskManager manager;
+        manager.addTask(new Task("Before", "01.05.2027"));
+        {
+            TaskManager::UndoGroup together(manager, "import");
+            manager.addTasks({new Task("Imported 1", "01.05.2027"), new Task("Imported 2", "01.05.2027")});
+            manager.addTasks({new Task("Imported 3", "01.05.2027")});
+            manager.addCompletedTasks({new Task("Imported done", "01.04.2027", true)});
+        }
+        std::string what;
+        CHECK(manager.undo(&what));
+        CHECK(what == "import");
+        CHECK(found(manager, "Imported") == 0 && found(manager, "Before") == 1);
+        CHECK(manager.redo());
+        CHECK(found(manager, "Imported") == 3);
+        CHECK(manager.undo());
+    }
+
+    // More changes than the history keeps: the oldest deletes free their tasks
+    void overflow()
+    {
+        TaskManager manager;
+        std::size_t count = TaskHistory::maxEntries + 50;
+        for (std::size_t i = 0; i < count; ++i)
+            manager.addTask(new Task("Task " + std::to_string(i), "01.05.2027"));
+        for (std::size_t i = 0; i < count; ++i)
+            manager.deleteTask("Task " + std::to_string(i));
+        std::size_t undone = 0;
+        while (manager.undo())
+            ++undone;
+        CHECK(undone == TaskHistory::maxEntries);
+        CHECK(found(manager, "Task") == TaskHistory::maxEntries);
+    }
+}
+
+int main()
+{
+    // Singletons such as the metrics registry are made on first use
+    deleteAndComplete();
+
+    CHECK(leftOver(undoneAdd) == 0);
+    CHECK(leftOver(deleteAndComplete) == 0);
+    CHECK(leftOver(shadowedTitle) == 0);
+    CHECK(leftOver(recurring) == 0);
+    CHECK(leftOver(group) == 0);
+    CHECK(leftOver(overflow) == 0);
+    return test::testResult("history");
+}
@@ -0,0 +1,160 @@
+// Tests for iCalendar export and import: folding at 75 octets without
+// splitting a character, even when the bytes are not valid UTF-8, escaping,
+// titles and series that come back unchanged, and imports that must not add
+// a task twice or lose one without a word
+
+#include <string>
+#include <vector>
+#include "ical_import.h"
+#include "ical_writer.h"
+#include "test_check.h"
+
+using namespace todo;
+
+namespace
+{
+    const std::string file = "tasks.ics";
+
+    std::vector<std::string> physicalLines(const std::string &text)
+    {
+        std::vector<std::string> lines;
+        std::size_t start = 0, end;
+        while ((end = text.find("\r\n", start)) != std::string::npos)
+        {
+            lines.push_back(text.substr(start, end - start));
+            start = end + 2;
+        }
+        return lines;
+    }
+
+    std::string exportOne(const std::string &title, const std::string &category)
+    {
+        {
+            OutputBuffer out(file);
+            IcalWriter writer(out);
+            writer.write(title, "01.05.2027", category, false);
+            writer.finish();
+        }
+        return test::readFile(file);
+    }
+
+    // Lines of text fit in 75 octets and none starts inside a UTF-8 sequence
+    // of valid text
+    void checkFolding(const std::string &text, bool validUtf8)
+    {
+        for (const auto &line : physicalLines(text))
+        {
+            CHECK(line.size() <= 75);
+            if (validUtf8 && line.size() > 1 && line[0] == ' ')
+                CHECK((static_cast<unsigned char>(line[1]) & 0xC0) != 0x80);
+        }
+    }
+}
+
+int main()
+{
+    // Multi-byte characters on every fold boundary
+    std::string accented;
+    for (int i = 0; i < 120; ++i)
+        accented += "\xC3\xA9"; // e with acute accent
+    checkFolding(exportOne(accented, ""), true);
+
+    // A run of continuation bytes longer than a line used to fold forever
+    std::string invalid(300, '\x80');
+    checkFolding(exportOne(invalid, ""), false);
+    checkFolding(exportOne("Start \xE2\x82" + std::string(200, '\xAC'), ""), false);
+
+    // Escaped characters, folded lines and long titles survive a round trip
+    std::vector<std::string> titles = {
+        "Plain",
+        "Back\\slash, comma and semi",
+        accented,
+        std::string(200, 'x'),
+    };
+    {
+        OutputBuffer out(file);
+        IcalWriter writer(out);
+        for (const auto &title : titles)
+            writer.write(title, "01.05.2027", "Home, garden", false);
+        writer.finish();
+    }
+    std::string text = test::readFile(file);
+    checkFolding(text, true);
+    CHECK(text.find("SUMMARY:Back\\\\slash\\, comma and semi\r\n") != std::string::npos);
+    CHECK(text.find("CATEGORIES:Home\\, garden\r\n") != std::string::npos);
+    {
+        TaskManager manager;
+        ImportResult result = IcalImporter().run(file, manager);
+        CHECK(result.opened);
+        CHECK(result.imported == titles.size());
+        CHECK(result.rejected == 0);
+        manager.saveToFile("tasks.txt");
+        std::string saved = test::readFile("tasks.txt");
+        for (const auto &title : titles)
+            CHECK(saved.find(title + ";01.05.2027;") != std::string::npos);
+    }
+
+    // Importing the same file again adds nothing and says why
+    {
+        TaskManager manager;
+        manager.loadFromFile("tasks.txt");
+        ImportResult result = IcalImporter().run(file, manager);
+        CHECK(result.imported == 0);
+        CHECK(result.skipped == titles.size());
+        CHECK(result.rejected == 0);
+    }
+
+    // A UID seen before in the file is skipped; a VTODO cut off by the end
+    // of the file is rejected rather than dropped without a word
+    test::writeFile(file, "BEGIN:VCALENDAR\r\n"
+                          "BEGIN:VTODO\r\nUID:a@example\r\nSUMMARY:First\r\nDUE;VALUE=DATE:20270501\r\nEND:VTODO\r\n"
+                          "BEGIN:VTODO\r\nUID:a@example\r\nSUMMARY:First again\r\nDUE;VALUE=DATE:20270502\r\nEND:VTODO\r\n"
+                          "BEGIN:VTODO\r\nUID:b@example\r\nSUMMARY:Second\r\nDUE;VALUE=DATE:20270503\r\nEND:VTODO\r\n"
+                          "BEGIN:VTODO\r\nUID:c@example\r\nSUMMARY:Cut short\r\nDUE;VALUE=DATE:20270504\r\n");
+    {
+        TaskManager manager;
+        ImportResult result = IcalImporter().run(file, manager);
+        CHECK(result.imported == 2);
+        CHECK(result.skipped == 1);
+        CHECK(result.rejected == 1);
+        CHECK(!result.errors.empty() && result.errors[0] == "line 17: VTODO not closed by END:VTODO");
+    }
+
+    // A series keeps its rule, its start and the occurrence that is next
+    test::writeFile("tasks.txt", "Standup;12.01.2026;0;Work;repeat=1w@05.01.2026\n"
+                                 "Rent;28.02.2026;0;;repeat=1m@31.01.2026\n"
+                                 "Review;05.01.2026;0;;repeat=3d@05.01.2026\n");
+    {
+        TaskManager manager;
+        manager.loadFromFile("tasks.txt");
+        CHECK(manager.exportIcal(file));
+    }
+    text = test::readFile(file);
+    CHECK(text.find("DUE;VALUE=DATE:20260228\r\nDTSTART;VALUE=DATE:20260131\r\nRRULE:FREQ=MONTHLY;INTERVAL=1\r\n") != std::string::npos);
+    CHECK(text.find("RRULE:FREQ=DAILY;INTERVAL=3\r\n") != std::string::npos);
+    {
+        TaskManager manager;
+        ImportResult result = IcalImporter().run(file, manager);
+        CHECK(result.imported == 3 && result.rejected == 0);
+        manager.saveToFile("round-trip.txt");
+    }
+    CHECK(test::readFile("round-trip.txt") == test::readFile("tasks.txt"));
+
+    // A rule that cannot be kept is reported, not imported as a one-off;
+    // a done series comes in as the occurrence it ended on
+    test::writeFile(file, "BEGIN:VCALENDAR\r\n"
+                          "BEGIN:VTODO\r\nSUMMARY:Gym\r\nDTSTART:20270503T070000\r\nRRULE:freq=weekly;interval=2;wkst=MO\r\nEND:VTODO\r\n"
+                          "BEGIN:VTODO\r\nSUMMARY:Weekdays\r\nDUE;VALUE=DATE:20270503\r\nRRULE:FREQ=WEEKLY;BYDAY=MO,TU\r\nEND:VTODO\r\n"
+                          "BEGIN:VTODO\r\nSUMMARY:Old series\r\nDUE;VALUE=DATE:20270503\r\nRRULE:FREQ=DAILY\r\nSTATUS:COMPLETED\r\nEND:VTODO\r\n"
+                          "END:VCALENDAR\r\n");
+    {
+        TaskManager manager;
+        ImportResult result = IcalImporter().run(file, manager);
+        CHECK(result.imported == 2 && result.rejected == 1);
+        CHECK(!result.errors.empty() && result.errors[0] == "line 7: cannot repeat RRULE \"FREQ=WEEKLY;BYDAY=MO,TU\"");
+        manager.saveToFile("tasks.txt");
+    }
+    CHECK(test::readFile("tasks.txt") == "Gym;03.05.2027;0;;repeat=2w@03.05.2027\nDONE:Old series;03.05.2027;1\n");
+
+    return test::testResult("ical");
+}
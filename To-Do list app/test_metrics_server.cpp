@@ -0,0 +1,99 @@
+// Tests for the metrics socket: clients that hang up early must not end the
+// program, and the socket path must never cost the user a file
+
+#include <chrono>
+#include <string>
+#include <thread>
+#include "metrics_server.h"
+#include "test_check.h"
+
+using namespace todo;
+
+#ifdef TODO_METRICS_SOCKET
+namespace
+{
+    int connectTo(const std::string &path)
+    {
+        sockaddr_un address;
+        std::memset(&address, 0, sizeof(address));
+        address.sun_family = AF_UNIX;
+        std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+        int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd >= 0 && ::connect(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0)
+        {
+            ::close(fd);
+            return -1;
+        }
+        return fd;
+    }
+
+    std::string scrape(const std::string &path)
+    {
+        int fd = connectTo(path);
+        if (fd < 0)
+            return std::string();
+        const char request[] = "GET /metrics HTTP/1.1\r\n\r\n";
+        (void)::write(fd, request, sizeof(request) - 1);
+        std::string reply;
+        char buffer[4096];
+        ssize_t n;
+        while ((n = ::read(fd, buffer, sizeof(buffer))) > 0)
+            reply.append(buffer, static_cast<std::size_t>(n));
+        ::close(fd);
+        return reply;
+    }
+}
+#endif
+
+int main()
+{
+#ifdef TODO_METRICS_SOCKET
+    MetricsRegistry::instance().counter("todo_test_total", "Test counter").add(3);
+
+    // A regular file in the way is neither deleted nor replaced
+    test::writeFile("notes.txt", "keep me\n");
+    {
+        MetricsServer server;
+        CHECK(!server.start("notes.txt"));
+        CHECK(server.why().find("not a socket") != std::string::npos);
+    }
+    CHECK(test::readFile("notes.txt") == "keep me\n");
+
+    MetricsServer server;
+    CHECK(server.start("metrics.sock"));
+
+    // Clients that reset the connection before the reply goes out
+    for (int i = 0; i < 5; ++i)
+    {
+        int fd = connectTo("metrics.sock");
+        CHECK(fd >= 0);
+        linger reset{1, 0};
+        ::setsockopt(fd, SOL_SOCKET, SO_LINGER, &reset, sizeof(reset));
+        ::close(fd);
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+
+    // Still alive and serving
+    std::string reply = scrape("metrics.sock");
+    CHECK(reply.compare(0, 15, "HTTP/1.0 200 OK") == 0);
+    CHECK(reply.find("todo_test_total 3") != std::string::npos);
+    server.stop();
+
+    // A socket left behind by an earlier run is replaced
+    {
+        int stale = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        sockaddr_un address;
+        std::memset(&address, 0, sizeof(address));
+        address.sun_family = AF_UNIX;
+        std::strcpy(address.sun_path, "stale.sock");
+        CHECK(::bind(stale, reinterpret_cast<sockaddr *>(&address), sizeof(address)) == 0);
+        ::close(stale);
+        MetricsServer again;
+        CHECK(again.start("stale.sock"));
+        CHECK(scrape("stale.sock").find("todo_test_total") != std::string::npos);
+    }
+#else
+    std::cout << "metrics_server: no Unix sockets here, skipped\n";
+#endif
+    return test::testResult("metrics_server");
+}
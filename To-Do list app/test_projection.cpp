@@ -0,0 +1,75 @@
+// Tests for --fields projections: the JSON of `list --json` must be the
+// schema of `main export-json`, and text output only the fields asked for
+
+#include <string>
+#include "projection.h"
+#include "task_manager.h"
+#include "test_check.h"
+
+using namespace todo;
+
+namespace
+{
+    const std::string lines[] = {
+        "Plain;01.05.2027;0",
+        "Quoted \"title\";02.05.2027;0;Work",
+        "Waits;03.05.2027;0;;after=Plain",
+        "Empty category;04.05.2027;0;",
+        "Standup;12.01.2026;0;Work;repeat=1w@05.01.2026",
+        "Rent;31.01.2026;0;;repeat=1m@31.01.2026;after=Plain",
+        "DONE:Old;01.01.2026;1;Home",
+    };
+
+    std::string project(const std::string &list, bool json)
+    {
+        Projection projection;
+        CHECK(projection.parse(list));
+        {
+            OutputBuffer out("projected.txt");
+            TaskRecord record;
+            for (const auto &line : lines)
+            {
+                parseTaskLine(line, record, projection.fieldCount());
+                if (json)
+                    projection.renderJson(record, out);
+                else
+                    projection.renderText(record, out);
+            }
+        }
+        return test::readFile("projected.txt");
+    }
+}
+
+int main()
+{
+    std::string file;
+    for (const auto &line : lines)
+        file += line + "\n";
+    test::writeFile("tasks.txt", file);
+    TaskManager manager;
+    manager.loadFromFile("tasks.txt");
+    CHECK(manager.exportJson("export.json", true));
+    CHECK(project("title,deadline,category,status,repeat", true) == test::readFile("export.json"));
+    CHECK(project("title,repeat", true) == "{\"title\":\"Plain\",\"repeat\":null}\n"
+                                            "{\"title\":\"Quoted \\\"title\\\"\",\"repeat\":null}\n"
+                                            "{\"title\":\"Waits\",\"repeat\":null}\n"
+                                            "{\"title\":\"Empty category\",\"repeat\":null}\n"
+                                            "{\"title\":\"Standup\",\"repeat\":\"1w@05.01.2026\"}\n"
+                                            "{\"title\":\"Rent\",\"repeat\":\"1m@31.01.2026\"}\n"
+                                            "{\"title\":\"Old\",\"repeat\":null}\n");
+
+    // completed is the export's status, and is given once
+    CHECK(project("completed,status", true) == "{\"status\":\"active\"}\n{\"status\":\"active\"}\n"
+                                                "{\"status\":\"active\"}\n{\"status\":\"active\"}\n"
+                                                "{\"status\":\"active\"}\n{\"status\":\"active\"}\n"
+                                                "{\"status\":\"completed\"}\n");
+
+    // Text keeps the completed flag as it is in the file
+    CHECK(project("title,completed", false) == "Plain\t0\nQuoted \"title\"\t0\nWaits\t0\nEmpty category\t0\n"
+                                               "Standup\t0\nRent\t0\nOld\t1\n");
+    CHECK(project("title,repeat", false) == "Plain\t\nQuoted \"title\"\t\nWaits\t\nEmpty category\t\n"
+                                            "Standup\t1w@05.01.2026\nRent\t1m@31.01.2026\nOld\t\n");
+
+    CHECK(!Projection().parse("title,owner"));
+    return test::testResult("projection");
+}
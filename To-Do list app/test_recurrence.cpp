@@ -0,0 +1,122 @@
+// Tests for recurrence rules and the agenda queue, against brute force:
+// firstIndexFrom must find the first occurrence on or after any day, also
+// after occurrences clamped to the end of a short month, and the queue must
+// list every occurrence in a window once, in date order
+
+#include <algorithm>
+#include <random>
+#include <utility>
+#include <vector>
+#include "recurrence.h"
+#include "test_check.h"
+
+using namespace todo;
+
+namespace
+{
+    Date date(int day, int month, int year)
+    {
+        Date d;
+        d.day = day;
+        d.month = month;
+        d.year = year;
+        return d;
+    }
+
+    // Every day of four years from a little before the start, walking the
+    // expected index forward as the day moves on
+    void firstIndexFrom()
+    {
+        const Date starts[] = {date(31, 1, 2026), date(30, 1, 2026), date(29, 2, 2028), date(31, 3, 2027),
+                               date(28, 2, 2026), date(31, 12, 2025), date(15, 6, 2026), date(1, 1, 2026)};
+        for (int unit = RecurrenceRule::Days; unit <= RecurrenceRule::Years; ++unit)
+        {
+            for (int every : {1, 2, 3, 5})
+            {
+                for (const Date &start : starts)
+                {
+                    RecurrenceRule rule;
+                    rule.unit = static_cast<RecurrenceRule::Unit>(unit);
+                    rule.every = every;
+                    rule.start = start;
+                    long expected = 0;
+                    Date occurrence;
+                    long from = daysFromDate(start) - 40;
+                    for (long day = from; day < from + 4 * 366; ++day)
+                    {
+                        while (rule.occurrence(expected, occurrence) && daysFromDate(occurrence) < day)
+                            ++expected;
+                        CHECK(rule.firstIndexFrom(dateFromDays(day)) == expected);
+                    }
+                }
+            }
+        }
+
+        // Monthly from the 31st clamps to the last day and comes back to the 31st
+        RecurrenceRule rule;
+        CHECK(rule.parse("monthly", "31.01.2026"));
+        Date next;
+        CHECK(rule.nextAfter(date(31, 1, 2026), next) && daysFromDate(next) == daysFromDate(date(28, 2, 2026)));
+        CHECK(rule.nextAfter(next, next) && daysFromDate(next) == daysFromDate(date(31, 3, 2026)));
+        CHECK(rule.firstIndexFrom(date(1, 3, 2026)) == 2);
+    }
+
+    // Random one-off tasks and series against every occurrence listed out
+    void agenda()
+    {
+        std::mt19937 random(11);
+        const long base = daysFromDate(date(1, 1, 2026));
+        for (int round = 0; round < 300; ++round)
+        {
+            Date from = dateFromDays(base + random() % 400);
+            Date to = dateFromDays(daysFromDate(from) + random() % 120);
+            AgendaQueue queue(from, to);
+            std::vector<std::pair<long, std::size_t>> expected;
+            std::size_t tasks = random() % 12;
+            for (std::size_t source = 0; source < tasks; ++source)
+            {
+                Date due = dateFromDays(base - 200 + random() % 800);
+                if (random() % 3 == 0)
+                {
+                    long day = daysFromDate(due);
+                    bool inWindow = day >= daysFromDate(from) && day <= daysFromDate(to);
+                    CHECK(queue.add(source, due) == inWindow);
+                    if (inWindow)
+                        expected.emplace_back(day, source);
+                    continue;
+                }
+                RecurrenceRule rule;
+                rule.unit = static_cast<RecurrenceRule::Unit>(random() % 4);
+                rule.every = 1 + random() % 4;
+                rule.start = dateFromDays(daysFromDate(due) - random() % 100);
+                bool any = false;
+                Date occurrence;
+                for (long i = 0; rule.occurrence(i, occurrence) && daysFromDate(occurrence) <= daysFromDate(to); ++i)
+                {
+                    long day = daysFromDate(occurrence);
+                    if (day >= daysFromDate(due) && day >= daysFromDate(from))
+                    {
+                        expected.emplace_back(day, source);
+                        any = true;
+                    }
+                }
+                CHECK(queue.add(source, due, &rule) == any);
+            }
+            std::sort(expected.begin(), expected.end());
+
+            std::vector<std::pair<long, std::size_t>> listed;
+            std::size_t source;
+            Date day;
+            while (queue.next(source, day))
+                listed.emplace_back(daysFromDate(day), source);
+            CHECK(listed == expected);
+        }
+    }
+}
+
+int main()
+{
+    firstIndexFrom();
+    agenda();
+    return test::testResult("recurrence");
+}
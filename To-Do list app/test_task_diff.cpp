@@ -0,0 +1,114 @@
+// Tests for diff and merge of task files: every kind of change is reported
+// once, duplicates are matched one by one, and a merge keeps what either side
+// changed since the base
+
+#include <string>
+#include "task_diff.h"
+#include "test_check.h"
+
+using namespace todo;
+
+namespace
+{
+    TaskFileSnapshot snapshot(const std::string &name, const std::string &text)
+    {
+        test::writeFile(name, text);
+        TaskFileSnapshot s;
+        CHECK(s.load(name));
+        return s;
+    }
+
+    std::string diffText(const TaskFileSnapshot &before, const TaskFileSnapshot &after, TaskDiff::Summary &summary)
+    {
+        {
+            OutputBuffer out("diff.txt");
+            summary = TaskDiff::diff(before, after, out);
+        }
+        return test::readFile("diff.txt");
+    }
+
+    std::string mergeText(const TaskFileSnapshot &ours, const TaskFileSnapshot &theirs, const TaskFileSnapshot *base)
+    {
+        {
+            OutputBuffer out("merged.txt");
+            TaskDiff::merge(ours, theirs, base, out);
+        }
+        return test::readFile("merged.txt");
+    }
+
+    bool has(const std::string &text, const std::string &line)
+    {
+        return text.find(line) != std::string::npos;
+    }
+}
+
+int main()
+{
+    // One of each change, and a duplicate of which one copy goes
+    TaskFileSnapshot before = snapshot("before.txt", "Same;01.05.2027;0;Work\n"
+                                                     "Twice;02.05.2027;0\n"
+                                                     "Twice;02.05.2027;0\n"
+                                                     "Moved;03.05.2027;0;Work\n"
+                                                     "Finish;04.05.2027;0\n"
+                                                     "Gone;05.05.2027;0\n"
+                                                     "DONE:Reopen;06.05.2027;1\n");
+    TaskFileSnapshot after = snapshot("after.txt", "Same;01.05.2027;0;Work\r\n"
+                                                   "Twice;02.05.2027;0\n"
+                                                   "Moved;10.05.2027;0;Home\n"
+                                                   "Reopen;06.05.2027;0\n"
+                                                   "New;07.05.2027;0\n"
+                                                   "DONE:Finish;04.05.2027;1\n");
+    TaskDiff::Summary summary;
+    std::string text = diffText(before, after, summary);
+    CHECK(summary.unchanged == 2);
+    CHECK(summary.deleted == 2);
+    CHECK(summary.added == 1);
+    CHECK(summary.completed == 1);
+    CHECK(summary.reopened == 1);
+    CHECK(summary.changed == 1);
+    CHECK(has(text, "- Twice;02.05.2027;0\n"));
+    CHECK(has(text, "- Gone;05.05.2027;0\n"));
+    CHECK(has(text, "+ New;07.05.2027;0\n"));
+    CHECK(has(text, "x DONE:Finish;04.05.2027;1\n"));
+    CHECK(has(text, "o Reopen;06.05.2027;0\n"));
+    CHECK(has(text, "~ Moved;10.05.2027;0;Home\n    deadline: 03.05.2027 -> 10.05.2027\n    category: Work -> Home\n"));
+
+    // No change at all
+    text = diffText(before, before, summary);
+    CHECK(text.empty() && summary.unchanged == 7);
+
+    // Without a base: everything from both sides, completion wins, then theirs
+    TaskFileSnapshot ours = snapshot("ours.txt", "Shared;01.05.2027;0\n"
+                                                 "Done here;02.05.2027;0\n"
+                                                 "Edited;03.05.2027;0\n"
+                                                 "Only ours;04.05.2027;0\n");
+    TaskFileSnapshot theirs = snapshot("theirs.txt", "Shared;01.05.2027;0\n"
+                                                     "DONE:Done here;02.05.2027;1\n"
+                                                     "Edited;09.05.2027;0\n"
+                                                     "Only theirs;05.05.2027;0\n");
+    CHECK(mergeText(ours, theirs, nullptr) == "Shared;01.05.2027;0\n"
+                                              "Edited;09.05.2027;0\n"
+                                              "Only ours;04.05.2027;0\n"
+                                              "Only theirs;05.05.2027;0\n"
+                                              "DONE:Done here;02.05.2027;1\n");
+
+    // With a base: a delete stands unless the other side changed the task,
+    // and a change on either side beats the unchanged copy
+    TaskFileSnapshot base = snapshot("base.txt", "Keep;01.05.2027;0\n"
+                                                 "Deleted by us;02.05.2027;0\n"
+                                                 "Deleted by us, moved by them;03.05.2027;0\n"
+                                                 "Moved by us;04.05.2027;0\n"
+                                                 "Deleted by them;05.05.2027;0\n");
+    ours = snapshot("ours.txt", "Keep;01.05.2027;0\n"
+                                "Moved by us;11.05.2027;0\n"
+                                "Deleted by them;05.05.2027;0\n");
+    theirs = snapshot("theirs.txt", "Keep;01.05.2027;0\n"
+                                    "Deleted by us;02.05.2027;0\n"
+                                    "Deleted by us, moved by them;13.05.2027;0\n"
+                                    "Moved by us;04.05.2027;0\n");
+    CHECK(mergeText(ours, theirs, &base) == "Keep;01.05.2027;0\n"
+                                            "Moved by us;11.05.2027;0\n"
+                                            "Deleted by us, moved by them;13.05.2027;0\n");
+
+    return test::testResult("task_diff");
+}
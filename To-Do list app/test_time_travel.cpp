@@ -0,0 +1,128 @@
+// Tests for the journal and as-of views: a task file read back at any time
+// since its journal began must hold the tasks it held then, before and after
+// old history is collected, and the manager must journal each change once
+
+#include <algorithm>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "task_manager.h"
+#include "test_check.h"
+#include "time_travel.h"
+
+using namespace todo;
+
+namespace
+{
+    const std::string file = "tasks.txt";
+
+    std::vector<std::string> at(const TaskVersions &versions, std::int64_t time)
+    {
+        std::vector<std::string> lines;
+        CHECK(versions.forEachAt(time, [&](std::string_view line)
+                                 { lines.emplace_back(line); }));
+        std::sort(lines.begin(), lines.end());
+        return lines;
+    }
+
+    std::vector<std::string> lines(std::vector<std::string> list)
+    {
+        std::sort(list.begin(), list.end());
+        return list;
+    }
+
+    // Milk is added, done and reopened; Report is deleted and added again
+    // with a new deadline
+    void writeHistory()
+    {
+        test::writeFile(file, "Report;09.05.2027;0;Work\n"
+                              "Milk;01.05.2027;0\n");
+        test::writeFile(TaskJournal::fileFor(file), "#since 1000\n"
+                                                    "1000;add;Milk;01.05.2027;0\n"
+                                                    "1100;add;Report;02.05.2027;0;Work\n"
+                                                    "1200;complete;DONE:Milk;01.05.2027;1\n"
+                                                    "1300;delete;Report;02.05.2027;0;Work\n"
+                                                    "1400;add;Report;09.05.2027;0;Work\n"
+                                                    "1500;reopen;Milk;01.05.2027;0\n");
+    }
+}
+
+int main()
+{
+    writeHistory();
+    {
+        TaskVersions versions;
+        CHECK(versions.load(file));
+        CHECK(versions.hasHistory() && versions.historyStart() == 1000);
+        CHECK(at(versions, 999).empty());
+        CHECK(at(versions, 1000) == lines({"Milk;01.05.2027;0"}));
+        CHECK(at(versions, 1150) == lines({"Milk;01.05.2027;0", "Report;02.05.2027;0;Work"}));
+        CHECK(at(versions, 1250) == lines({"DONE:Milk;01.05.2027;1", "Report;02.05.2027;0;Work"}));
+        CHECK(at(versions, 1350) == lines({"DONE:Milk;01.05.2027;1"}));
+        CHECK(at(versions, 1450) == lines({"DONE:Milk;01.05.2027;1", "Report;09.05.2027;0;Work"}));
+        CHECK(at(versions, 1500) == lines({"Milk;01.05.2027;0", "Report;09.05.2027;0;Work"}));
+    }
+
+    // Collecting drops what ended before the horizon and nothing after it
+    CHECK(TaskJournal::collect(file, 1250));
+    {
+        TaskVersions versions;
+        CHECK(versions.load(file));
+        CHECK(versions.historyStart() == 1250);
+        CHECK(at(versions, 1260) == lines({"DONE:Milk;01.05.2027;1", "Report;02.05.2027;0;Work"}));
+        CHECK(at(versions, 1350) == lines({"DONE:Milk;01.05.2027;1"}));
+        CHECK(at(versions, 1450) == lines({"DONE:Milk;01.05.2027;1", "Report;09.05.2027;0;Work"}));
+        CHECK(at(versions, 1600) == lines({"Milk;01.05.2027;0", "Report;09.05.2027;0;Work"}));
+    }
+
+    // Without a journal only the current file is known
+    std::remove(TaskJournal::fileFor(file).c_str());
+    {
+        TaskVersions versions;
+        CHECK(versions.load(file));
+        CHECK(!versions.hasHistory());
+        CHECK(at(versions, 0).size() == 2);
+    }
+
+    // The manager journals each change once, undo included, after the save
+    test::writeFile(file, "");
+    {
+        TaskManager manager;
+        manager.loadFromFile(file);
+        manager.enableJournal();
+        manager.addTask(new Task("Milk", "01.05.2027"));
+        manager.addTask(new CategorizedTask("Report", "02.05.2027", "Work"));
+        CHECK(manager.markCompleted("Milk"));
+        CHECK(manager.undo());
+        CHECK(manager.deleteTask("Report"));
+        manager.saveToFile(file);
+    }
+    std::vector<TaskJournal::Entry> entries;
+    std::int64_t since = 0;
+    CHECK(TaskJournal::read(file, entries, since));
+    CHECK(entries.size() == 5);
+    if (entries.size() == 5)
+    {
+        CHECK(entries[0].op == TaskJournal::Add && entries[0].line == "Milk;01.05.2027;0");
+        CHECK(entries[1].op == TaskJournal::Add && entries[1].line == "Report;02.05.2027;0;Work");
+        CHECK(entries[2].op == TaskJournal::Complete && entries[2].line == "DONE:Milk;01.05.2027;1");
+        CHECK(entries[3].op == TaskJournal::Reopen && entries[3].line == "Milk;01.05.2027;0");
+        CHECK(entries[4].op == TaskJournal::Delete && entries[4].line == "Report;02.05.2027;0;Work");
+        CHECK(since == entries[0].time);
+    }
+
+    // Points in time
+    std::int64_t when = 0;
+    CHECK(parseWhen("@1500", when) && when == 1500);
+    std::int64_t before = TaskJournal::now();
+    CHECK(parseWhen("-2d", when));
+    CHECK(when >= before - 2 * 86400 && when <= TaskJournal::now() - 2 * 86400);
+    CHECK(parseWhen("1.3.2026", when));
+    std::int64_t endOfDay = when;
+    CHECK(parseWhen("2026-03-01 09:30", when) && when < endOfDay);
+    CHECK(!parseWhen("yesterday", when));
+    CHECK(!parseWhen("-3w", when));
+    CHECK(!parseWhen("2026-03-01 25:00", when));
+
+    return test::testResult("time_travel");
+}
@@ -0,0 +1,228 @@
+// Tests for the timer wheel and the reminders built on it: every timer fires
+// once, on its tick, across every level and cascade, and stale handles do
+// nothing; reminders follow the task file through sync()
+
+#include <ctime>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+#include "reminders.h"
+#include "test_check.h"
+#include "timer_wheel.h"
+
+using namespace todo;
+
+namespace
+{
+    using Wheel = TimerWheel<int>;
+
+    // Random schedules, cancels and reschedules at every level, checked
+    // against a plain map after each advance
+    void randomized()
+    {
+        std::mt19937_64 random(7);
+        const std::int64_t start = 1700000000;
+        Wheel wheel(start);
+        std::map<int, std::pair<std::int64_t, Wheel::Handle>> model; // id -> (when, handle)
+        std::int64_t now = start - 1;
+        int nextId = 0;
+        auto later = [&]() -> std::int64_t
+        {
+            switch (random() % 5)
+            {
+            case 0:
+                return 1 + random() % 64;
+            case 1:
+                return 1 + random() % 4096;
+            case 2:
+                return 1 + random() % 300000;
+            case 3:
+                return 1 + random() % (std::int64_t(1) << 22);
+            default:
+                return 1 + random() % (std::int64_t(1) << 26); // The top level
+            }
+        };
+        for (int round = 0; round < 3000; ++round)
+        {
+            for (int k = random() % 4; k > 0; --k)
+            {
+                std::int64_t when = now + later();
+                model[nextId] = std::make_pair(when, wheel.schedule(when, nextId));
+                ++nextId;
+            }
+            if (!model.empty() && random() % 3 == 0)
+            {
+                auto it = model.begin();
+                std::advance(it, random() % model.size());
+                if (random() % 2)
+                {
+                    CHECK(wheel.cancel(it->second.second));
+                    CHECK(!wheel.cancel(it->second.second));
+                    model.erase(it);
+                }
+                else
+                {
+                    it->second.first = now + later();
+                    CHECK(wheel.reschedule(it->second.second, it->second.first));
+                }
+            }
+
+            std::int64_t step = random() % 50 == 0 ? std::int64_t(1) << 22 : random() % 10 == 0 ? 200000 : 90;
+            std::int64_t to = now + 1 + random() % step;
+            std::int64_t last = now;
+            std::vector<int> fired;
+            wheel.advance(to, [&](int id, std::int64_t when)
+                          {
+                auto it = model.find(id);
+                CHECK(it != model.end() && it->second.first == when);
+                CHECK(when > now && when <= to && when >= last);
+                last = when;
+                fired.push_back(id); });
+            now = to;
+            for (int id : fired)
+            {
+                CHECK(!wheel.cancel(model[id].second)); // The handle went stale when it fired
+                model.erase(id);
+            }
+            for (const auto &m : model)
+                CHECK(m.second.first > now);
+            CHECK(wheel.size() == model.size());
+        }
+    }
+
+    // Handles of freed nodes must not reach the timer that reuses them
+    void staleHandles()
+    {
+        Wheel wheel(100);
+        Wheel::Handle first = wheel.schedule(110, 1);
+        CHECK(wheel.cancel(first));
+        Wheel::Handle second = wheel.schedule(120, 2); // Same node, new generation
+        CHECK(second != first);
+        CHECK(!wheel.cancel(first));
+        CHECK(!wheel.reschedule(first, 105));
+        CHECK(!wheel.cancel(0));
+        std::vector<int> fired;
+        wheel.advance(130, [&](int id, std::int64_t)
+                      { fired.push_back(id); });
+        CHECK(fired == std::vector<int>{2});
+    }
+
+    // Overdue timers fire on the next tick, as do ones scheduled for the
+    // past while firing: within the same advance if it reaches that tick
+    void overdueAndChained()
+    {
+        Wheel wheel(1000);
+        wheel.schedule(500, 1);
+        std::vector<std::pair<int, std::int64_t>> fired;
+        std::size_t n = wheel.advance(1000, [&](int id, std::int64_t when)
+                                      {
+            fired.push_back(std::make_pair(id, when));
+            if (id < 4)
+                wheel.schedule(0, id + 1); });
+        CHECK(n == 1);
+        CHECK(fired.size() == 1 && fired[0] == std::make_pair(1, std::int64_t(500)));
+        fired.clear();
+        n = wheel.advance(1003, [&](int id, std::int64_t when)
+                          {
+            fired.push_back(std::make_pair(id, when));
+            if (id < 4)
+                wheel.schedule(0, id + 1); });
+        CHECK(n == 3);
+        CHECK((fired == std::vector<std::pair<int, std::int64_t>>{{2, 0}, {3, 0}, {4, 0}}));
+        CHECK(wheel.size() == 0);
+    }
+
+    std::int64_t localTime(int year, int month, int day, int hour)
+    {
+        std::tm tm = {};
+        tm.tm_year = year - 1900;
+        tm.tm_mon = month - 1;
+        tm.tm_mday = day;
+        tm.tm_hour = hour;
+        tm.tm_isdst = -1;
+        return static_cast<std::int64_t>(std::mktime(&tm));
+    }
+
+    // Reminders a day and an hour before 09:00 on the deadline, moved and
+    // dropped as the file changes
+    void reminders()
+    {
+        const std::string file = "tasks.txt";
+        std::int64_t due = localTime(2027, 5, 10, 9);
+        std::int64_t moved = localTime(2027, 5, 12, 9);
+        std::int64_t now = due - 3 * 86400;
+        ReminderScheduler scheduler({86400, 3600}, 9 * 3600, now);
+        test::writeFile(file, "Report;10.05.2027;0\nPast;01.01.2020;0\nDONE:Old;10.05.2027;1\nMilk;12.05.2027;0\n");
+        ReminderScheduler::SyncStats stats;
+        CHECK(scheduler.sync(file, now, &stats));
+        CHECK(stats.added == 2 && scheduler.pending() == 2);
+
+        std::vector<std::string> seen;
+        auto record = [&](const ReminderScheduler::Event &e)
+        { seen.push_back(std::string(e.title) + "@" + std::to_string(e.offset)); };
+        CHECK(scheduler.advance(due - 86400 - 1, record) == 0);
+        CHECK(scheduler.advance(due - 86400, record) == 1);
+        CHECK(seen == std::vector<std::string>{"Report@86400"});
+
+        // Moving Report two days on sets its day-before reminder again
+        test::writeFile(file, "Report;12.05.2027;0\nMilk;12.05.2027;0\n");
+        stats = ReminderScheduler::SyncStats();
+        CHECK(scheduler.sync(file, due - 86400, &stats));
+        CHECK(stats.moved == 1 && stats.added == 0 && stats.dropped == 0);
+        seen.clear();
+        scheduler.advance(moved - 86400, record);
+        CHECK((seen == std::vector<std::string>{"Milk@86400", "Report@86400"} ||
+               seen == std::vector<std::string>{"Report@86400", "Milk@86400"}));
+
+        // Completing Milk drops its last reminder
+        test::writeFile(file, "Report;12.05.2027;0\nDONE:Milk;12.05.2027;1\n");
+        stats = ReminderScheduler::SyncStats();
+        CHECK(scheduler.sync(file, moved - 86400, &stats));
+        CHECK(stats.dropped == 1 && scheduler.pending() == 1);
+        seen.clear();
+        scheduler.advance(moved, record);
+        CHECK(seen == std::vector<std::string>{"Report@3600"});
+        CHECK(scheduler.pending() == 0);
+    }
+
+    // A title on two active lines follows the later one, and syncing an
+    // unchanged file changes nothing
+    void duplicateTitles()
+    {
+        const std::string file = "duplicates.txt";
+        std::int64_t early = localTime(2027, 6, 10, 9);
+        std::int64_t late = localTime(2027, 6, 20, 9);
+        std::int64_t now = early - 5 * 86400;
+        ReminderScheduler scheduler({3600}, 9 * 3600, now);
+        test::writeFile(file, "Taxes;20.06.2027;0\nTaxes;10.06.2027;0\n");
+        ReminderScheduler::SyncStats stats;
+        CHECK(scheduler.sync(file, now, &stats));
+        CHECK(stats.added == 1 && scheduler.pending() == 1);
+        for (int i = 0; i < 3; ++i)
+        {
+            stats = ReminderScheduler::SyncStats();
+            CHECK(scheduler.sync(file, now, &stats));
+            CHECK(stats.added == 0 && stats.moved == 0 && stats.dropped == 0);
+        }
+        std::vector<std::int64_t> at;
+        scheduler.advance(late, [&](const ReminderScheduler::Event &e)
+                          { at.push_back(e.at); });
+        CHECK(at == std::vector<std::int64_t>{early - 3600});
+    }
+}
+
+int main()
+{
+    randomized();
+    staleHandles();
+    overdueAndChained();
+    reminders();
+    duplicateTitles();
+
+    std::vector<std::int64_t> offsets;
+    CHECK(parseOffsets("1d,2h,30m,0", offsets));
+    CHECK((offsets == std::vector<std::int64_t>{86400, 7200, 1800, 0}));
+    CHECK(!parseOffsets("1w", offsets));
+    return test::testResult("timer_wheel");
+}
@@ -0,0 +1,354 @@
+#ifndef TODO_TIME_TRAVEL_H
+#define TODO_TIME_TRAVEL_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <ctime>
+#include <iostream>
+#include <limits>
+#include <set>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "date_utils.h"
+#include "journal.h"
+#include "oneshot.h"
+#include "task_file.h"
+
+namespace todo
+{
+
+    // Every version of every task a task file has had since its journal began,
+    // each valid over [begin, end). The current file holds the versions that
+    // are still valid; the rest are rebuilt by walking the journal backwards:
+    // an add sets where a version begins, a delete brings back a version that
+    // ended, and complete and reopen split a task into an open and a done
+    // version. Only the titles the journal mentions are looked up in the file,
+    // so an as-of read costs one extra pass over it plus the journal
+    class TaskVersions
+    {
+    public:
+        static constexpr std::int64_t minTime = std::numeric_limits<std::int64_t>::min();
+        static constexpr std::int64_t maxTime = std::numeric_limits<std::int64_t>::max();
+
+    private:
+        // A version that is no longer in the file, as the file would have held it
+        struct Version
+        {
+            std::string line;
+            std::int64_t begin;
+            std::int64_t end;
+        };
+
+        // A version that exists where the backward walk has got to and whose
+        // begin is still unknown: a line of the file or an entry of versions
+        struct Live
+        {
+            std::uint64_t fileLine;
+            std::size_t version; // npos for a file line
+            bool done;
+        };
+
+        std::string filename;
+        std::vector<Version> versions;
+        std::vector<std::pair<std::uint64_t, std::int64_t>> fileBegins; // (line number, begin), by line number
+        std::int64_t since = maxTime;
+        bool journaled = false;
+
+        static std::string titleOf(std::string_view line)
+        {
+            TaskRecord record;
+            parseTaskLine(line, record, 1);
+            return std::string(record.title);
+        }
+
+        // A task line (without "DONE:") as it is saved on the given list
+        static std::string onList(const std::string &taskLine, bool done)
+        {
+            std::string line = (done ? "DONE:" : "") + taskLine;
+            std::size_t start = line.find(';', line.find(';') + 1);
+            if (start != std::string::npos)
+            {
+                std::size_t end = line.find(';', start + 1);
+                line.replace(start + 1, end == std::string::npos ? std::string::npos : end - start - 1, done ? "1" : "0");
+            }
+            return line;
+        }
+
+        // Give the newest live version of title on that list its begin; false
+        // when the file was changed behind the journal's back
+        bool start(std::unordered_map<std::string, std::vector<Live>> &live, const std::string &title,
+                   bool done, std::int64_t begin)
+        {
+            auto it = live.find(title);
+            if (it == live.end())
+                return false;
+            std::vector<Live> &list = it->second;
+            for (std::size_t i = list.size(); i-- > 0;)
+            {
+                if (list[i].done != done)
+                    continue;
+                if (list[i].version == std::string::npos)
+                    fileBegins.push_back(std::make_pair(list[i].fileLine, begin));
+                else
+                    versions[list[i].version].begin = begin;
+                list.erase(list.begin() + static_cast<std::ptrdiff_t>(i));
+                return true;
+            }
+            return false;
+        }
+
+        void addVersion(std::unordered_map<std::string, std::vector<Live>> &live, const std::string &title,
+                        std::string line, bool done, std::int64_t end)
+        {
+            versions.push_back(Version{std::move(line), minTime, end});
+            live[title].push_back(Live{0, versions.size() - 1, done});
+        }
+
+    public:
+        // Load the journal of tasksFile and match it against the file; false if
+        // the task file cannot be read
+        bool load(const std::string &tasksFile)
+        {
+            filename = tasksFile;
+            versions.clear();
+            fileBegins.clear();
+            std::vector<TaskJournal::Entry> entries;
+            journaled = TaskJournal::read(tasksFile, entries, since);
+            if (!journaled)
+                since = maxTime;
+
+            std::unordered_map<std::string, std::vector<Live>> live;
+            std::vector<std::string> titles(entries.size());
+            for (std::size_t i = 0; i < entries.size(); ++i)
+            {
+                const std::string &line = entries[i].line;
+                titles[i] = titleOf(line.compare(0, 5, "DONE:") == 0 ? std::string_view(line).substr(5) : std::string_view(line));
+                live[titles[i]];
+            }
+
+            LineReader reader;
+            if (!reader.open(tasksFile))
+                return false;
+            std::string_view line;
+            TaskRecord record;
+            for (std::uint64_t n = 0; !live.empty() && reader.next(line); ++n)
+            {
+                parseTaskLine(line, record, 1);
+                auto it = live.find(std::string(record.title));
+                if (it != live.end())
+                    it->second.push_back(Live{n, std::string::npos, record.done});
+            }
+
+            for (std::size_t i = entries.size(); i-- > 0;)
+            {
+                const TaskJournal::Entry &e = entries[i];
+                bool done = e.line.compare(0, 5, "DONE:") == 0;
+                switch (e.op)
+                {
+                case TaskJournal::Add:
+                    start(live, titles[i], done, e.time);
+                    break;
+                case TaskJournal::Delete:
+                    addVersion(live, titles[i], e.line, done, e.time);
+                    break;
+                case TaskJournal::Complete:
+                case TaskJournal::Reopen:
+                    // Before the change the task was on the other list
+                    if (start(live, titles[i], done, e.time))
+                        addVersion(live, titles[i], onList(e.line.substr(done ? 5 : 0), !done), !done, e.time);
+                    break;
+                default:
+                    break;
+                }
+            }
+            std::sort(fileBegins.begin(), fileBegins.end());
+            return true;
+        }
+
+        // Whether the file has a journal, and where its history starts;
+        // earlier times show the tasks as they were then
+        bool hasHistory() const { return journaled; }
+        std::int64_t historyStart() const { return since; }
+
+        // Call visit(line) for every task line of the file as it was at time:
+        // current lines first, in file order, then the versions since replaced
+        template <class Visit>
+        bool forEachAt(std::int64_t time, Visit visit) const
+        {
+            LineReader reader;
+            if (!reader.open(filename))
+                return false;
+            std::string_view line;
+            auto known = fileBegins.begin();
+            for (std::uint64_t n = 0; reader.next(line); ++n)
+            {
+                while (known != fileBegins.end() && known->first < n)
+                    ++known;
+                if (known != fileBegins.end() && known->first == n && known->second > time)
+                    continue;
+                visit(line);
+            }
+            for (const auto &v : versions)
+                if (v.begin <= time && time < v.end)
+                    visit(std::string_view(v.line));
+            return true;
+        }
+    };
+
+    // Read a point in time: "now", "@<unix time>", "-<n>d" or "-<n>h" back
+    // from now, or a date (D.M.YYYY or YYYY-MM-DD) with an optional local
+    // time HH:MM after a space or 'T'. A date alone means the end of that day
+    inline bool parseWhen(const std::string &text, std::int64_t &when)
+    {
+        char *end = nullptr;
+        if (text == "now")
+        {
+            when = TaskJournal::now();
+            return true;
+        }
+        if (text.size() > 1 && text[0] == '@')
+        {
+            when = std::strtoll(text.c_str() + 1, &end, 10);
+            return *end == '\0';
+        }
+        if (text.size() > 2 && text[0] == '-')
+        {
+            long n = std::strtol(text.c_str() + 1, &end, 10);
+            if (n < 0 || (std::string(end) != "d" && std::string(end) != "h"))
+                return false;
+            when = TaskJournal::now() - n * (*end == 'd' ? 86400 : 3600);
+            return true;
+        }
+
+        std::size_t split = text.find_first_of(" T");
+        Date date;
+        if (!parseDate(std::string_view(text).substr(0, split), date))
+            return false;
+        int hour = 23, minute = 59, second = 59;
+        if (split != std::string::npos)
+        {
+            std::string_view clock = std::string_view(text).substr(split + 1);
+            std::size_t pos = 0;
+            if (!readNumber(clock, pos, 2, hour) || pos >= clock.size() || clock[pos++] != ':' ||
+                !readNumber(clock, pos, 2, minute) || pos != clock.size() || hour > 23 || minute > 59)
+                return false;
+            second = 0;
+        }
+        std::tm tm = {};
+        tm.tm_year = date.year - 1900;
+        tm.tm_mon = date.month - 1;
+        tm.tm_mday = date.day;
+        tm.tm_hour = hour;
+        tm.tm_min = minute;
+        tm.tm_sec = second;
+        tm.tm_isdst = -1;
+        when = static_cast<std::int64_t>(std::mktime(&tm));
+        return true;
+    }
+
+    // as-of <when> view [sorted] | completed | search <keyword> | filter <category>:
+    // the views of the menu over the tasks as they were at that time
+    inline int asOfCommand(const std::string &filename, int argc, char *argv[])
+    {
+        std::int64_t started = TaskJournal::now();
+        std::int64_t when;
+        std::string view = argc > 1 ? argv[1] : "";
+        std::string arg = argc > 2 ? argv[2] : "";
+        bool needsArg = view == "search" || view == "filter";
+        bool sorted = view == "view" && arg == "sorted";
+        if (argc < 2 || !parseWhen(argv[0], when) || (view != "view" && view != "completed" && !needsArg) ||
+            argc != (needsArg || sorted ? 3 : 2))
+        {
+            std::cerr << "usage: as-of <when> view [sorted] | completed | search <keyword> | filter <category>\n"
+                      << "  when: now, @<unix time>, -<n>d, -<n>h, or a date with an optional HH:MM\n";
+            return 2;
+        }
+
+        TaskVersions versions;
+        if (!versions.load(filename))
+        {
+            std::cerr << "Could not open " << filename << "\n";
+            return 1;
+        }
+        if (!versions.hasHistory() && when < started)
+            std::cerr << "No history recorded for " << filename << " yet; showing the tasks as they are now\n";
+        else if (versions.hasHistory() && when < versions.historyStart())
+            std::cerr << "History starts at @" << versions.historyStart() << "; showing the tasks as they were then\n";
+
+        OutputBuffer out;
+        TaskRecord record;
+        std::vector<std::pair<int, std::string>> keyed; // view sorted
+        std::vector<std::string> matching;              // filter
+        std::set<std::string> categories;               // filter
+        versions.forEachAt(when, [&](std::string_view line)
+                           {
+            parseTaskLine(line, record);
+            if (view == "completed")
+            {
+                if (record.done)
+                    renderRecord(record, out);
+            }
+            else if (record.done)
+                return;
+            else if (sorted)
+                keyed.push_back(std::make_pair(deadlineKey(record.deadline), std::string(line)));
+            else if (view == "view" || (view == "search" && record.title.find(arg) != std::string_view::npos))
+                renderRecord(record, out);
+            else if (view == "filter")
+            {
+                if (record.hasCategory && !record.category.empty())
+                    categories.insert(std::string(record.category));
+                if (record.category == arg)
+                    matching.push_back(std::string(line));
+            } });
+
+        if (sorted)
+        {
+            std::stable_sort(keyed.begin(), keyed.end(), [](const std::pair<int, std::string> &a, const std::pair<int, std::string> &b)
+                             { return a.first < b.first; });
+            for (const auto &k : keyed)
+            {
+                parseTaskLine(k.second, record);
+                renderRecord(record, out);
+            }
+        }
+        else if (view == "filter")
+        {
+            // Laid out like TaskManager::filterByCategory
+            out.append(std::string("Available categories to choose from:\n"));
+            for (const auto &cat : categories)
+                out.append(" - " + cat + "\n");
+            out.append("\nShowing tasks for category: " + arg + "\n");
+            for (const auto &line : matching)
+            {
+                parseTaskLine(line, record);
+                renderRecord(record, out);
+            }
+        }
+        return 0;
+    }
+
+    // history-gc [days]: forget versions that ended more than days ago
+    inline int historyGcCommand(const std::string &filename, int argc, char *argv[])
+    {
+        char *end = nullptr;
+        long days = argc > 0 ? std::strtol(argv[0], &end, 10) : TaskJournal::defaultRetentionDays;
+        if (argc > 1 || days < 0 || (end && (end == argv[0] || *end != '\0')))
+        {
+            std::cerr << "usage: history-gc [days]\n";
+            return 2;
+        }
+        if (!TaskJournal::collect(filename, TaskJournal::now() - static_cast<std::int64_t>(days) * 86400))
+        {
+            std::cerr << "Could not rewrite " << TaskJournal::fileFor(filename) << "\n";
+            return 1;
+        }
+        return 0;
+    }
+
+} // namespace todo
+
+#endif
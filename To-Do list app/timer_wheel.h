@@ -0,0 +1,212 @@
+#ifndef TODO_TIMER_WHEEL_H
+#define TODO_TIMER_WHEEL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace todo
+{
+
+    // Hierarchical timing wheel (Varghese and Lauck) with one-second ticks.
+    // Level 0 has a slot for each of the next 64 seconds, level 1 one for each
+    // of the next 64 stretches of 64 seconds, and so on; five levels reach about
+    // 34 years, and later timers wait in the top level until they come in range.
+    // A timer sits in the lowest level that reaches its expiry. When the clock
+    // wraps past a slot of a higher level, that slot's timers are spread over
+    // the levels below it (cascading), so each timer moves at most once per level.
+    //
+    // Timers are nodes in one vector, linked into their slots by index, so
+    // schedule, cancel and reschedule each touch a fixed number of nodes
+    // however many timers are pending. Handles carry a generation, which makes
+    // a handle of a timer that already fired or was cancelled harmless
+    template <class T>
+    class TimerWheel
+    {
+    public:
+        using Handle = std::uint64_t; // 0 is never a valid handle
+
+        static constexpr int levelBits = 6;
+        static constexpr int slotsPerLevel = 1 << levelBits;
+        static constexpr int levels = 5;
+
+    private:
+        static constexpr std::uint32_t none = 0xffffffffu;
+        static constexpr std::int64_t maxDelta = (std::int64_t(1) << (levelBits * levels)) - 1;
+
+        struct Node
+        {
+            std::int64_t when;
+            std::uint32_t prev;
+            std::uint32_t next; // Also chains the free list
+            std::uint32_t generation;
+            std::int32_t slot; // -1 while the node is free
+            T payload;
+        };
+
+        std::vector<Node> nodes;
+        std::uint32_t freeNodes = none;
+        std::uint32_t heads[levels * slotsPerLevel];
+        std::int64_t nextTick; // The first tick not yet processed
+        std::size_t pending = 0;
+
+        Node *lookup(Handle handle)
+        {
+            std::uint32_t index = static_cast<std::uint32_t>(handle) - 1;
+            if (handle == 0 || index >= nodes.size())
+                return nullptr;
+            Node &node = nodes[index];
+            return node.slot >= 0 && node.generation == static_cast<std::uint32_t>(handle >> 32) ? &node : nullptr;
+        }
+
+        // The slot for an expiry as seen from nextTick. Overdue timers go to
+        // the slot processed next; ones beyond the top level wait at its end
+        int slotFor(std::int64_t when) const
+        {
+            std::int64_t delta = when - nextTick;
+            if (delta < 0)
+                return static_cast<int>(nextTick & (slotsPerLevel - 1));
+            if (delta > maxDelta)
+                when = nextTick + maxDelta;
+            int level = 0;
+            while (level < levels - 1 && delta >= (std::int64_t(1) << (levelBits * (level + 1))))
+                ++level;
+            return level * slotsPerLevel + static_cast<int>((when >> (levelBits * level)) & (slotsPerLevel - 1));
+        }
+
+        void link(std::uint32_t index)
+        {
+            Node &node = nodes[index];
+            node.slot = slotFor(node.when);
+            node.prev = none;
+            node.next = heads[node.slot];
+            if (node.next != none)
+                nodes[node.next].prev = index;
+            heads[node.slot] = index;
+        }
+
+        void unlink(std::uint32_t index)
+        {
+            Node &node = nodes[index];
+            if (node.prev != none)
+                nodes[node.prev].next = node.next;
+            else
+                heads[node.slot] = node.next;
+            if (node.next != none)
+                nodes[node.next].prev = node.prev;
+        }
+
+        // Move the timers of a higher-level slot down; returns the slot index
+        // so the caller knows whether the next level wrapped too
+        int cascade(int level)
+        {
+            int index = static_cast<int>((nextTick >> (levelBits * level)) & (slotsPerLevel - 1));
+            std::uint32_t i = heads[level * slotsPerLevel + index];
+            heads[level * slotsPerLevel + index] = none;
+            while (i != none)
+            {
+                std::uint32_t following = nodes[i].next;
+                link(i);
+                i = following;
+            }
+            return index;
+        }
+
+    public:
+        explicit TimerWheel(std::int64_t now) : nextTick(now)
+        {
+            for (auto &head : heads)
+                head = none;
+        }
+
+        // Start a timer for time `when` (in seconds, like time()); earlier
+        // times fire on the next advance()
+        Handle schedule(std::int64_t when, const T &payload)
+        {
+            std::uint32_t index = freeNodes;
+            if (index != none)
+                freeNodes = nodes[index].next;
+            else
+            {
+                index = static_cast<std::uint32_t>(nodes.size());
+                nodes.push_back(Node{0, none, none, 0, -1, payload});
+            }
+            Node &node = nodes[index];
+            node.when = when;
+            node.payload = payload;
+            link(index);
+            ++pending;
+            return (static_cast<Handle>(node.generation) << 32) | (index + 1);
+        }
+
+        // Stop a timer; false if it already fired or was cancelled
+        bool cancel(Handle handle)
+        {
+            Node *node = lookup(handle);
+            if (!node)
+                return false;
+            std::uint32_t index = static_cast<std::uint32_t>(node - nodes.data());
+            unlink(index);
+            node->slot = -1;
+            ++node->generation;
+            node->next = freeNodes;
+            freeNodes = index;
+            --pending;
+            return true;
+        }
+
+        // Move a pending timer to a new time, keeping its handle
+        bool reschedule(Handle handle, std::int64_t when)
+        {
+            Node *node = lookup(handle);
+            if (!node)
+                return false;
+            std::uint32_t index = static_cast<std::uint32_t>(node - nodes.data());
+            unlink(index);
+            node->when = when;
+            link(index);
+            return true;
+        }
+
+        // Run the clock up to now, calling fire(payload, when) for every timer
+        // that expires on the way, in order of their tick. fire may schedule
+        // new timers; ones already due fire on the following tick
+        template <class Fire>
+        std::size_t advance(std::int64_t now, Fire fire)
+        {
+            std::size_t fired = 0;
+            if (pending == 0 && nextTick <= now)
+                nextTick = now + 1;
+            while (nextTick <= now)
+            {
+                int index = static_cast<int>(nextTick & (slotsPerLevel - 1));
+                for (int level = 1; index == 0 && level < levels; ++level)
+                    index = cascade(level);
+                int slot = static_cast<int>(nextTick & (slotsPerLevel - 1));
+                ++nextTick;
+                // Taken one at a time, so fire may also cancel timers of this tick
+                while (heads[slot] != none)
+                {
+                    std::uint32_t i = heads[slot];
+                    unlink(i);
+                    Node &node = nodes[i];
+                    std::int64_t when = node.when;
+                    T payload = node.payload;
+                    node.slot = -1;
+                    ++node.generation;
+                    node.next = freeNodes;
+                    freeNodes = i;
+                    --pending;
+                    fire(payload, when);
+                    ++fired;
+                }
+            }
+            return fired;
+        }
+
+        std::size_t size() const { return pending; }
+    };
+
+} // namespace todo
+
+#endif
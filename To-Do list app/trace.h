@@ -0,0 +1,161 @@
+#ifndef TODO_TRACE_H
+#define TODO_TRACE_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "json_writer.h"
+#include "output_buffer.h"
+
+namespace todo
+{
+
+    // Collects complete ("X") events for the Chrome trace-event format, which
+    // chrome://tracing and ui.perfetto.dev open directly. Nothing is recorded
+    // until enable() is called
+    class TraceRecorder
+    {
+    private:
+        struct Event
+        {
+            const char *name;
+            std::chrono::steady_clock::time_point start;
+            std::chrono::steady_clock::duration duration;
+            unsigned thread;
+        };
+
+        std::atomic<bool> on{false};
+        std::chrono::steady_clock::time_point origin = std::chrono::steady_clock::now();
+        std::mutex lock;
+        std::vector<Event> events;
+
+    public:
+        static TraceRecorder &instance()
+        {
+            static TraceRecorder recorder;
+            return recorder;
+        }
+
+        void enable() { on.store(true, std::memory_order_relaxed); }
+        bool enabled() const { return on.load(std::memory_order_relaxed); }
+
+        // Small stable number for the calling thread, used as the trace "tid"
+        static unsigned threadNumber()
+        {
+            static std::atomic<unsigned> next{1};
+            thread_local unsigned number = next++;
+            return number;
+        }
+
+        // name must outlive the recorder; span names are string literals
+        void add(const char *name, std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end)
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            events.push_back(Event{name, start, end - start, threadNumber()});
+        }
+
+        // Write {"traceEvents": [...]} with times in microseconds since startup
+        void write(OutputBuffer &out)
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            out.append(std::string("{\"traceEvents\":[\n"));
+            char numbers[96];
+            for (std::size_t i = 0; i < events.size(); ++i)
+            {
+                const Event &e = events[i];
+                out.append(std::string("{\"name\":"));
+                appendJsonString(out, e.name);
+                double ts = std::chrono::duration<double, std::micro>(e.start - origin).count();
+                double dur = std::chrono::duration<double, std::micro>(e.duration).count();
+                std::snprintf(numbers, sizeof(numbers), ",\"cat\":\"todo\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%u}",
+                              ts, dur, e.thread);
+                out.append(std::string(numbers));
+                out.append(i + 1 < events.size() ? ",\n" : "\n", i + 1 < events.size() ? 2 : 1);
+            }
+            out.append(std::string("],\"displayTimeUnit\":\"ms\"}\n"));
+        }
+
+        // Write to a file, returns false if it could not be written
+        bool write(const std::string &filename)
+        {
+            OutputBuffer out(filename);
+            if (!out.isOpen())
+                return false;
+            write(out);
+            out.flush();
+            return !out.hasFailed();
+        }
+    };
+
+    // Enables tracing for the lifetime of the session and writes the trace file
+    // when it ends, so every return path of main() gets a complete trace
+    class TraceSession
+    {
+    private:
+        std::string filename;
+
+    public:
+        explicit TraceSession(const std::string &file) : filename(file)
+        {
+            if (!filename.empty())
+                TraceRecorder::instance().enable();
+        }
+
+        ~TraceSession()
+        {
+            if (!filename.empty() && !TraceRecorder::instance().write(filename))
+                std::fprintf(stderr, "Could not write %s\n", filename.c_str());
+        }
+
+        TraceSession(const TraceSession &) = delete;
+        TraceSession &operator=(const TraceSession &) = delete;
+    };
+
+#ifdef TODO_ENABLE_TRACING
+    constexpr bool tracingCompiledIn = true;
+
+    // Records the lifetime of a scope as one trace event
+    class TraceSpan
+    {
+    private:
+        const char *name;
+        bool active;
+        std::chrono::steady_clock::time_point start;
+
+    public:
+        explicit TraceSpan(const char *spanName)
+            : name(spanName), active(TraceRecorder::instance().enabled())
+        {
+            if (active)
+                start = std::chrono::steady_clock::now();
+        }
+
+        ~TraceSpan()
+        {
+            if (active)
+                TraceRecorder::instance().add(name, start, std::chrono::steady_clock::now());
+        }
+
+        TraceSpan(const TraceSpan &) = delete;
+        TraceSpan &operator=(const TraceSpan &) = delete;
+    };
+
+#define TODO_TRACE_CONCAT2(a, b) a##b
+#define TODO_TRACE_CONCAT(a, b) TODO_TRACE_CONCAT2(a, b)
+#define TODO_TRACE_SPAN(name) ::todo::TraceSpan TODO_TRACE_CONCAT(todoTraceSpan, __LINE__)(name)
+#else
+    constexpr bool tracingCompiledIn = false;
+
+    // Without TODO_ENABLE_TRACING spans compile to nothing
+#define TODO_TRACE_SPAN(name) \
+    do                        \
+    {                         \
+    } while (0)
+#endif
+
+} // namespace todo
+
+#endif